@@ -0,0 +1,105 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+
+#include "BenchScene.hpp"
+#include "X3D.hpp"
+#include "engine/EngineContext.hpp"
+#include "entity/EntityBuilder.hpp"
+#include "level/LevelManager.hpp"
+#include "memory/FrameAllocator.hpp"
+#include "render/software/SoftwareRenderer.hpp"
+
+EngineContext* BenchScene::engineContext;
+Camera* BenchScene::camera;
+TransformComponent* BenchScene::cameraTransform;
+Vec3fp BenchScene::startPosition;
+
+class BenchCamera : public Entity
+{
+public:
+    static Entity* build(EntityBuilder& builder)
+    {
+        BenchCamera* entity = builder
+            .withComponent<TransformComponent>()
+            .withComponent<CameraComponent>()
+            .build<BenchCamera>();
+
+        entity->getComponent<CameraComponent>()->viewport.init(Vec2(0, 0), 640, 480, X_ANG_60);
+
+        return entity;
+    }
+};
+
+bool BenchScene::load(EngineContext* engineContext_, const char* mapName)
+{
+    engineContext = engineContext_;
+    engineContext->entityManager->registerEntityType<BenchCamera>("info_player_start"_sid, BenchCamera::build);
+
+    char command[256];
+    snprintf(command, sizeof(command), "map %s", mapName);
+    x_console_execute_cmd(engineContext->console, command);
+
+    auto& cameras = engineContext->cameraSystem->getAllEntities();
+
+    if(engineContext->levelManager->getCurrentLevel() == nullptr || cameras.begin() == cameras.end())
+    {
+        return false;
+    }
+
+    Entity* entity = *cameras.begin();
+
+    camera = entity->getComponent<CameraComponent>();
+    cameraTransform = entity->getComponent<TransformComponent>();
+    startPosition = cameraTransform->getPosition();
+
+    return true;
+}
+
+bool BenchScene::isLoaded()
+{
+    return camera != nullptr;
+}
+
+void BenchScene::setView(int viewId)
+{
+    Vec3fp position = startPosition;
+
+    position.x += fp::fromInt((viewId % 4) * 48 - 72);
+    position.y -= fp::fromInt(30);
+    position.z += fp::fromInt((viewId / 4) * 48 - 72);
+
+    cameraTransform->setPosition(position);
+    cameraTransform->setOrientation(Quaternion::fromEulerAngles(fp::fromInt(0), fp::fromInt(viewId * 23), fp::fromInt(0)));
+}
+
+void BenchScene::renderFrame()
+{
+    FrameAllocator::beginFrame();
+
+    SoftwareRenderer renderer(&engineContext->renderer->activeEdgeContext, engineContext);
+    renderer.render();
+}
+
+Camera* BenchScene::getCamera()
+{
+    return camera;
+}
+
+EngineContext* BenchScene::getEngineContext()
+{
+    return engineContext;
+}
@@ -0,0 +1,45 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "geo/Vec3.hpp"
+
+struct EngineContext;
+struct Camera;
+class TransformComponent;
+
+// The level and camera views shared by the level and render benchmarks. The views are a fixed grid
+// around the player start with varying yaw, so every run renders exactly the same frames.
+class BenchScene
+{
+public:
+    static const int TOTAL_VIEWS = 16;
+
+    static bool load(EngineContext* engineContext, const char* mapName);
+    static bool isLoaded();
+
+    static void setView(int viewId);
+    static void renderFrame();
+
+    static Camera* getCamera();
+    static EngineContext* getEngineContext();
+
+private:
+    static EngineContext* engineContext;
+    static Camera* camera;
+    static TransformComponent* cameraTransform;
+    static Vec3fp startPosition;
+};
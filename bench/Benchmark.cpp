@@ -0,0 +1,290 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Benchmark.hpp"
+
+// Samples shorter than this are dominated by timer resolution and scheduling noise
+static const double MIN_SAMPLE_NS = 10.0e6;
+static const int MAX_ITERATIONS = 1 << 28;
+
+// A change is only reported if it's bigger than this and well outside both runs' noise
+static const double MIN_SIGNIFICANT_CHANGE = 0.03;
+
+static const int MAX_BENCHMARK_NAME_LENGTH = 64;
+
+void BenchmarkRunner::add(const char* name, BenchmarkFunc func, int iterationStep)
+{
+    if(totalBenchmarks == MAX_BENCHMARKS)
+    {
+        fprintf(stderr, "Too many benchmarks, ignoring %s\n", name);
+        return;
+    }
+
+    Benchmark& benchmark = benchmarks[totalBenchmarks++];
+
+    benchmark.name = name;
+    benchmark.func = func;
+    benchmark.iterationStep = iterationStep;
+}
+
+void BenchmarkRunner::list() const
+{
+    for(int i = 0; i < totalBenchmarks; ++i)
+    {
+        printf("%s\n", benchmarks[i].name);
+    }
+}
+
+double BenchmarkRunner::runSample(const Benchmark& benchmark, int iterations)
+{
+    BenchmarkState state;
+
+    state.engineContext = engineContext;
+    state.iterations = iterations;
+    state.manualElapsedNs = -1;
+
+    auto start = std::chrono::steady_clock::now();
+    benchmark.func(state);
+    auto end = std::chrono::steady_clock::now();
+
+    if(state.manualElapsedNs >= 0)
+    {
+        return state.manualElapsedNs;
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Finds how many iterations make a sample at least MIN_SAMPLE_NS long. This also warms up the
+// caches and any lazily built data.
+int BenchmarkRunner::calibrate(const Benchmark& benchmark)
+{
+    int step = benchmark.iterationStep;
+    int iterations = step;
+
+    while(iterations < MAX_ITERATIONS)
+    {
+        double elapsedNs = runSample(benchmark, iterations);
+
+        if(elapsedNs >= MIN_SAMPLE_NS)
+        {
+            break;
+        }
+
+        // Aim a little past the target so we usually get there in one more step
+        double scale = (elapsedNs > 0 ? MIN_SAMPLE_NS * 1.2 / elapsedNs : 16);
+        scale = std::min(std::max(scale, 2.0), 16.0);
+
+        double nextIterations = std::min((double)iterations * scale, (double)MAX_ITERATIONS);
+        iterations = ((int)nextIterations + step - 1) / step * step;
+    }
+
+    return iterations;
+}
+
+void BenchmarkRunner::runBenchmark(const Benchmark& benchmark, BenchmarkResult& dest)
+{
+    int iterations = calibrate(benchmark);
+
+    // One untimed sample at the final count
+    runSample(benchmark, iterations);
+
+    std::vector<double> nsPerOp(totalSamples);
+    double sum = 0;
+    double minNs = 1e300;
+
+    for(int i = 0; i < totalSamples; ++i)
+    {
+        nsPerOp[i] = runSample(benchmark, iterations) / iterations;
+        sum += nsPerOp[i];
+        minNs = std::min(minNs, nsPerOp[i]);
+    }
+
+    double mean = sum / totalSamples;
+    double sumSquaredDiff = 0;
+
+    for(int i = 0; i < totalSamples; ++i)
+    {
+        sumSquaredDiff += (nsPerOp[i] - mean) * (nsPerOp[i] - mean);
+    }
+
+    dest.name = benchmark.name;
+    dest.nsPerOp = mean;
+    dest.stddevNs = (totalSamples > 1 ? sqrt(sumSquaredDiff / (totalSamples - 1)) : 0);
+    dest.minNs = minNs;
+    dest.totalSamples = totalSamples;
+    dest.iterations = iterations;
+}
+
+void BenchmarkRunner::run(const char* filter)
+{
+    printf("%-32s %14s %9s %14s %12s\n", "benchmark", "ns/op", "stddev", "min ns/op", "ops/sample");
+
+    for(int i = 0; i < totalBenchmarks; ++i)
+    {
+        const Benchmark& benchmark = benchmarks[i];
+
+        if(filter != nullptr && strstr(benchmark.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        BenchmarkResult& result = results[totalResults++];
+        runBenchmark(benchmark, result);
+
+        printf("%-32s %14.3f %8.2f%% %14.3f %12d\n",
+            result.name,
+            result.nsPerOp,
+            result.stddevNs / result.nsPerOp * 100,
+            result.minNs,
+            result.iterations);
+
+        fflush(stdout);
+    }
+}
+
+// One benchmark per line so baselines diff cleanly between commits. Not JSON, since the engine's
+// JSON reader stores numbers as 16.16 fixed point.
+bool BenchmarkRunner::writeBaseline(const char* fileName) const
+{
+    FILE* file = fopen(fileName, "w");
+
+    if(!file)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", fileName);
+        return false;
+    }
+
+    fprintf(file, "# x3d_bench baseline\n");
+    fprintf(file, "# name ns_per_op stddev_ns min_ns samples ops_per_sample\n");
+
+    for(int i = 0; i < totalResults; ++i)
+    {
+        const BenchmarkResult& result = results[i];
+
+        fprintf(file, "%s %.4f %.4f %.4f %d %d\n",
+            result.name,
+            result.nsPerOp,
+            result.stddevNs,
+            result.minNs,
+            result.totalSamples,
+            result.iterations);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+struct BaselineEntry
+{
+    char name[MAX_BENCHMARK_NAME_LENGTH];
+    double nsPerOp;
+    double stddevNs;
+};
+
+static bool loadBaseline(const char* fileName, std::vector<BaselineEntry>& dest)
+{
+    FILE* file = fopen(fileName, "r");
+
+    if(!file)
+    {
+        fprintf(stderr, "Failed to open baseline %s\n", fileName);
+        return false;
+    }
+
+    char line[256];
+
+    while(fgets(line, sizeof(line), file))
+    {
+        if(line[0] == '#')
+        {
+            continue;
+        }
+
+        BaselineEntry entry;
+
+        if(sscanf(line, "%63s %lf %lf", entry.name, &entry.nsPerOp, &entry.stddevNs) == 3)
+        {
+            dest.push_back(entry);
+        }
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+bool BenchmarkRunner::compareWithBaseline(const char* fileName) const
+{
+    std::vector<BaselineEntry> baseline;
+
+    if(!loadBaseline(fileName, baseline))
+    {
+        return false;
+    }
+
+    printf("\nCompared with %s:\n", fileName);
+    printf("%-32s %14s %14s %9s\n", "benchmark", "baseline", "current", "change");
+
+    int totalSlower = 0;
+    int totalFaster = 0;
+
+    for(int i = 0; i < totalResults; ++i)
+    {
+        const BenchmarkResult& result = results[i];
+        const BaselineEntry* entry = nullptr;
+
+        for(const BaselineEntry& candidate : baseline)
+        {
+            if(strcmp(candidate.name, result.name) == 0)
+            {
+                entry = &candidate;
+                break;
+            }
+        }
+
+        if(entry == nullptr)
+        {
+            printf("%-32s %14s %14.3f\n", result.name, "-", result.nsPerOp);
+            continue;
+        }
+
+        double diff = result.nsPerOp - entry->nsPerOp;
+        double change = diff / entry->nsPerOp;
+        double noise = 2 * sqrt(result.stddevNs * result.stddevNs + entry->stddevNs * entry->stddevNs);
+
+        const char* verdict = "";
+
+        if(fabs(change) >= MIN_SIGNIFICANT_CHANGE && fabs(diff) > noise)
+        {
+            verdict = (diff > 0 ? "slower" : "faster");
+            (diff > 0 ? totalSlower : totalFaster)++;
+        }
+
+        printf("%-32s %14.3f %14.3f %+8.2f%%%s%s\n", result.name, entry->nsPerOp, result.nsPerOp, change * 100, verdict[0] ? " " : "", verdict);
+    }
+
+    printf("%d slower, %d faster\n", totalSlower, totalFaster);
+
+    return true;
+}
@@ -0,0 +1,100 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+struct EngineContext;
+
+// Handed to each benchmark. The benchmark performs state.iterations operations; the runner times
+// them unless the benchmark measures a phase itself and reports it with setElapsedNs().
+struct BenchmarkState
+{
+    void setElapsedNs(double ns)
+    {
+        manualElapsedNs = ns;
+    }
+
+    EngineContext* engineContext;
+    int iterations;
+    double manualElapsedNs;     // < 0 if the runner's own timing should be used
+};
+
+typedef void (*BenchmarkFunc)(BenchmarkState& state);
+
+struct Benchmark
+{
+    const char* name;
+    BenchmarkFunc func;
+    int iterationStep;          // Iteration counts are always a multiple of this
+};
+
+struct BenchmarkResult
+{
+    const char* name;
+    double nsPerOp;             // Mean over all samples
+    double stddevNs;
+    double minNs;
+    int totalSamples;
+    int iterations;             // Operations per sample
+};
+
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(EngineContext* engineContext_, int totalSamples_)
+        : engineContext(engineContext_),
+        totalSamples(totalSamples_),
+        totalBenchmarks(0),
+        totalResults(0)
+    {
+
+    }
+
+    void add(const char* name, BenchmarkFunc func, int iterationStep = 1);
+    void list() const;
+    void run(const char* filter);
+
+    bool writeBaseline(const char* fileName) const;
+    bool compareWithBaseline(const char* fileName) const;
+
+private:
+    double runSample(const Benchmark& benchmark, int iterations);
+    int calibrate(const Benchmark& benchmark);
+    void runBenchmark(const Benchmark& benchmark, BenchmarkResult& dest);
+
+    static const int MAX_BENCHMARKS = 64;
+
+    EngineContext* engineContext;
+    int totalSamples;
+
+    Benchmark benchmarks[MAX_BENCHMARKS];
+    int totalBenchmarks;
+
+    BenchmarkResult results[MAX_BENCHMARKS];
+    int totalResults;
+};
+
+// Keeps the compiler from throwing away a result that's never read
+template<typename T>
+static inline void benchKeep(const T& value)
+{
+    asm volatile("" : : "m"(value) : "memory");
+}
+
+void registerMathBenchmarks(BenchmarkRunner& runner);
+void registerLevelBenchmarks(BenchmarkRunner& runner);
+void registerMemoryBenchmarks(BenchmarkRunner& runner);
+void registerJsonBenchmarks(BenchmarkRunner& runner);
+void registerRenderBenchmarks(BenchmarkRunner& runner);
@@ -0,0 +1,116 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "util/Json.hpp"
+#include "util/JsonDocument.hpp"
+#include "util/JsonReader.hpp"
+
+// The tree is parsed into the zone, which runs out at around a thousand objects
+static const int TOTAL_OBJECTS = 512;
+static const int NODES_PER_OBJECT = 16;
+
+static std::vector<char> source;
+static std::vector<char> buffer;
+
+// Objects that look like level entities, with one escaped string each
+static void initJsonData()
+{
+    const char* OBJECT_FORMAT = "{\"classname\": \"light\", \"origin\": [%d, %d, %d], \"light\": %d, \"angle\": 1.5, "
+        "\"target\": \"t%d\\\"a\", \"spawnflags\": 0, \"enabled\": true, \"model\": null}";
+
+    char object[192];
+
+    source.push_back('[');
+
+    for(int i = 0; i < TOTAL_OBJECTS; ++i)
+    {
+        if(i != 0)
+        {
+            source.push_back(',');
+            source.push_back('\n');
+        }
+
+        int length = sprintf(object, OBJECT_FORMAT, i % 4096, (i * 7) % 4096, (i * 13) % 4096, 100 + i % 200, i);
+        source.insert(source.end(), object, object + length);
+    }
+
+    source.push_back(']');
+    source.push_back('\0');
+
+    buffer.resize(source.size());
+}
+
+// The parsers work in place, so every op parses a fresh copy of the document
+static char* copySource()
+{
+    memcpy(&buffer[0], &source[0], source.size());
+
+    return &buffer[0];
+}
+
+// One op = parsing the document into a zone allocated tree and freeing it
+static void benchParseTree(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        Json::free(Json::parse(copySource()));
+    }
+}
+
+// One op = parsing the document into an arena
+static void benchParseArena(BenchmarkState& state)
+{
+    JsonDocument document(TOTAL_OBJECTS * NODES_PER_OBJECT + 1);
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        document.parse(copySource());
+    }
+
+    benchKeep(document.totalNodes());
+}
+
+// One op = reading every token of the document with the pull reader
+static void benchReadTokens(BenchmarkState& state)
+{
+    int totalTokens = 0;
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        JsonReader reader(copySource());
+        JsonToken token;
+
+        while(reader.read(token) != JSON_TOKEN_END)
+        {
+            ++totalTokens;
+        }
+    }
+
+    benchKeep(totalTokens);
+}
+
+void registerJsonBenchmarks(BenchmarkRunner& runner)
+{
+    initJsonData();
+
+    runner.add("json.parseTree", benchParseTree);
+    runner.add("json.parseArena", benchParseArena);
+    runner.add("json.readTokens", benchReadTokens);
+}
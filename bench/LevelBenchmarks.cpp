@@ -0,0 +1,282 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "BenchScene.hpp"
+#include "engine/EngineContext.hpp"
+#include "level/BspLeafGrid.hpp"
+#include "level/BspLevel.hpp"
+#include "level/BspRayTracer.hpp"
+#include "level/LevelManager.hpp"
+#include "math/Random.hpp"
+#include "render/Camera.hpp"
+
+static BspLevel* level;
+
+//======================== clipToFrustum ========================
+
+// Room for the vertices clipping against the four frustum planes can add
+static const int MAX_CLIP_INPUT_VERTICES = X_POLYGON3_MAX_VERTS - 4;
+
+static std::vector<Vec3fp> levelPolygonVertices;
+static std::vector<Polygon3> levelPolygons;
+static Viewport viewports[BenchScene::TOTAL_VIEWS];
+
+static void initClipData()
+{
+    Vec3fp origin(0, 0, 0);
+    Vec3fp vertices[X_POLYGON3_MAX_VERTS];
+    LevelPolygon3 poly(vertices, 0, nullptr);
+
+    std::vector<int> firstVertex;
+
+    for(int i = 0; i < level->totalSurfaces; ++i)
+    {
+        BspSurface* surface = level->surfaces + i;
+
+        if(surface->totalEdges > MAX_CLIP_INPUT_VERTICES)
+        {
+            continue;
+        }
+
+        level->getLevelPolygon(surface, &origin, &poly);
+
+        firstVertex.push_back(levelPolygonVertices.size());
+        levelPolygonVertices.insert(levelPolygonVertices.end(), vertices, vertices + poly.totalVertices);
+        levelPolygons.push_back(Polygon3(nullptr, poly.totalVertices));
+    }
+
+    // Fix up the vertex pointers once the vertex array has stopped growing
+    for(int i = 0; i < (int)levelPolygons.size(); ++i)
+    {
+        levelPolygons[i].vertices = &levelPolygonVertices[firstVertex[i]];
+    }
+
+    // Rendering a view is the easiest way to get the exact frustum the renderer clips against
+    for(int i = 0; i < BenchScene::TOTAL_VIEWS; ++i)
+    {
+        BenchScene::setView(i);
+        BenchScene::renderFrame();
+
+        viewports[i] = BenchScene::getCamera()->viewport;
+        viewports[i].viewFrustum.planes = viewports[i].viewFrustumPlanes;
+    }
+}
+
+// One op = clipping one level surface against one view's frustum
+static void benchClipToFrustum(BenchmarkState& state)
+{
+    const unsigned int ALL_SIDE_PLANES = (1 << 4) - 1;
+
+    int totalPolygons = levelPolygons.size();
+    InternalPolygon3 clipped;
+    int totalClippedVertices = 0;
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        const Polygon3& poly = levelPolygons[i % totalPolygons];
+        const Viewport& viewport = viewports[(i / totalPolygons) % BenchScene::TOTAL_VIEWS];
+
+        if(poly.clipToFrustum(viewport.viewFrustum, clipped, ALL_SIDE_PLANES))
+        {
+            totalClippedVertices += clipped.totalVertices;
+        }
+    }
+
+    benchKeep(totalClippedVertices);
+}
+
+//======================== PVS ========================
+
+static std::vector<BspLeaf*> leavesWithPvs;
+static DecompressedLeafVisibleSet decompressedPvs;
+
+static void initPvsData()
+{
+    for(int i = 0; i < level->totalLeaves; ++i)
+    {
+        BspLeaf& leaf = level->leaves[i];
+
+        if(leaf.pvsFromLeaf.hasPvsData() && !leaf.isOutsideLevel())
+        {
+            leavesWithPvs.push_back(&leaf);
+        }
+    }
+}
+
+// Calls the decompressor directly, since decompressPvsForLeaf() currently marks everything visible
+static void benchPvsDecompress(BenchmarkState& state)
+{
+    int bytesPerEntry = level->pvs.getBytesPerEntry();
+    int totalLeaves = leavesWithPvs.size();
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        leavesWithPvs[i % totalLeaves]->pvsFromLeaf.decompress(bytesPerEntry, decompressedPvs);
+        benchKeep(decompressedPvs);
+    }
+}
+
+static Vec3fp randomPointInBox(Random& random, const Vec3fp& boxMin, const Vec3fp& boxMax)
+{
+    // One statement per coordinate, since the order constructor arguments are evaluated in isn't fixed
+    fp x = random.nextFpInRange(boxMin.x, boxMax.x);
+    fp y = random.nextFpInRange(boxMin.y, boxMax.y);
+    fp z = random.nextFpInRange(boxMin.z, boxMax.z);
+
+    return Vec3fp(x, y, z);
+}
+
+//======================== leaf lookup ========================
+
+static const int TOTAL_POINTS = 4096;
+
+static Vec3fp points[TOTAL_POINTS];
+
+// Random points over the level, reaching a little past it so points outside the leaf grid get
+// looked up too. Both ways of finding the leaf have to agree, or the timings mean nothing.
+static void initLeafData()
+{
+    Random random;
+    const fp MARGIN = fp::fromInt(64);
+
+    BoundBox& levelBox = level->getLevelRootNode().nodeBoundBox;
+    Vec3fp boxMin = MakeVec3fp(levelBox.v[0]) - Vec3fp(MARGIN, MARGIN, MARGIN);
+    Vec3fp boxMax = MakeVec3fp(levelBox.v[1]) + Vec3fp(MARGIN, MARGIN, MARGIN);
+
+    int mismatches = 0;
+
+    for(int i = 0; i < TOTAL_POINTS; ++i)
+    {
+        points[i] = randomPointInBox(random, boxMin, boxMax);
+
+        if(level->findLeafPointIsIn(points[i]) != BspLeafGrid::descendToLeaf(&level->getLevelRootNode(), points[i]))
+        {
+            ++mismatches;
+        }
+    }
+
+    if(mismatches != 0)
+    {
+        printf("%d of %d points gave different leaves from the leaf grid and the BSP tree\n", mismatches, TOTAL_POINTS);
+    }
+}
+
+// One op = finding the leaf a point is in by descending the BSP tree from the root
+static void benchDescendToLeaf(BenchmarkState& state)
+{
+    BspNode* rootNode = &level->getLevelRootNode();
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        benchKeep(BspLeafGrid::descendToLeaf(rootNode, points[i & (TOTAL_POINTS - 1)]));
+    }
+}
+
+// One op = finding the leaf a point is in through the level's leaf grid
+static void benchFindLeaf(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        benchKeep(level->findLeafPointIsIn(points[i & (TOTAL_POINTS - 1)]));
+    }
+}
+
+//======================== ray tracing ========================
+
+static const int TOTAL_RAYS = 4096;
+
+static Ray3 rays[TOTAL_RAYS];
+
+// Clusters of rays that start near each other and head the same way, like the traces for a group
+// of objects
+static void initRayData()
+{
+    Random random;
+
+    BoundBox& levelBox = level->getLevelModel().boundBox;
+    Vec3fp boxMin(fp(levelBox.v[0].x), fp(levelBox.v[0].y), fp(levelBox.v[0].z));
+    Vec3fp boxMax(fp(levelBox.v[1].x), fp(levelBox.v[1].y), fp(levelBox.v[1].z));
+
+    const fp MAX_RAY_LENGTH = fp::fromInt(256);
+    const int CLUSTER_SIZE = 16;
+    const fp CLUSTER_RADIUS = fp::fromInt(32);
+
+    const Vec3fp maxRayOffset(MAX_RAY_LENGTH, MAX_RAY_LENGTH, MAX_RAY_LENGTH);
+    const Vec3fp clusterExtent(CLUSTER_RADIUS, CLUSTER_RADIUS, CLUSTER_RADIUS);
+
+    Vec3fp clusterCenter;
+    Vec3fp clusterOffset;
+
+    for(int i = 0; i < TOTAL_RAYS; ++i)
+    {
+        if(i % CLUSTER_SIZE == 0)
+        {
+            clusterCenter = randomPointInBox(random, boxMin, boxMax);
+            clusterOffset = randomPointInBox(random, -maxRayOffset, maxRayOffset);
+        }
+
+        Vec3fp start = clusterCenter + randomPointInBox(random, -clusterExtent, clusterExtent);
+
+        rays[i] = Ray3(start, start + clusterOffset);
+    }
+}
+
+static void benchRayTrace(BenchmarkState& state)
+{
+    int totalHits = 0;
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        BspRayTracer tracer(rays[i & (TOTAL_RAYS - 1)], level, 0);
+        totalHits += tracer.trace();
+    }
+
+    benchKeep(totalHits);
+}
+
+void registerLevelBenchmarks(BenchmarkRunner& runner)
+{
+    if(!BenchScene::isLoaded())
+    {
+        return;
+    }
+
+    level = BenchScene::getEngineContext()->levelManager->getCurrentLevel();
+
+    initClipData();
+    runner.add("geo.clipToFrustum", benchClipToFrustum);
+
+    initPvsData();
+
+    if(leavesWithPvs.size() > 0)
+    {
+        runner.add("pvs.decompress", benchPvsDecompress);
+    }
+    else
+    {
+        printf("Level has no PVS data, skipping pvs.decompress\n");
+    }
+
+    initLeafData();
+    runner.add("level.descendToLeaf", benchDescendToLeaf);
+    runner.add("level.findLeafPointIsIn", benchFindLeaf);
+
+    initRayData();
+    runner.add("level.rayTrace", benchRayTrace);
+}
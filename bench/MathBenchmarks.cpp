@@ -0,0 +1,154 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+
+#include "Benchmark.hpp"
+#include "math/FixedPoint.hpp"
+#include "math/FastSqrt.hpp"
+#include "math/Mat4x4.hpp"
+#include "math/Random.hpp"
+
+// Big enough to defeat any constant folding, small enough to stay in L1/L2 so we measure the
+// arithmetic and not memory
+static const int DATA_SIZE = 4096;
+static const int DATA_MASK = DATA_SIZE - 1;
+
+static const int TRANSFORM_BATCH_SIZE = 256;
+
+static fp fpA[DATA_SIZE];
+static fp fpB[DATA_SIZE];
+static fp fpOut[DATA_SIZE];
+
+static unsigned int uintValues[DATA_SIZE];
+static unsigned int recipValues[DATA_SIZE];
+static int intOut[DATA_SIZE];
+
+static Vec3fp points[DATA_SIZE];
+static Vec3fp transformedPoints[DATA_SIZE];
+static Mat4x4 transformMatrix;
+
+static void initMathData()
+{
+    Random random;
+
+    for(int i = 0; i < DATA_SIZE; ++i)
+    {
+        fpA[i] = fp(random.nextInRange(-(1000 << 16), 1000 << 16));
+
+        // Divisors in 1..256 so quotients never overflow
+        fpB[i] = fp(random.nextInRange(1 << 16, 256 << 16));
+
+        uintValues[i] = random.next();
+        recipValues[i] = random.nextInRange(1, 65536);
+
+        points[i] = Vec3fp(
+            fp(random.nextInRange(-(4096 << 16), 4096 << 16)),
+            fp(random.nextInRange(-(4096 << 16), 4096 << 16)),
+            fp(random.nextInRange(-(4096 << 16), 4096 << 16)));
+    }
+
+    // A typical view matrix: a bit of pitch and yaw plus a translation
+    Mat4x4 pitch;
+    pitch.loadXRotation(fp::fromInt(12));
+
+    Mat4x4 yaw;
+    yaw.loadYRotation(fp::fromInt(37));
+
+    Mat4x4 translation;
+    translation.loadTranslation(Vec3fp(fp::fromInt(-120), fp::fromInt(48), fp::fromInt(300)));
+
+    transformMatrix = pitch * yaw * translation;
+}
+
+static void benchFpMul(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        int j = i & DATA_MASK;
+        fpOut[j] = fpA[j] * fpB[j];
+    }
+
+    benchKeep(fpOut);
+}
+
+static void benchFpDiv(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        int j = i & DATA_MASK;
+        fpOut[j] = fpA[j] / fpB[j];
+    }
+
+    benchKeep(fpOut);
+}
+
+static void benchSqrt(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        int j = i & DATA_MASK;
+        intOut[j] = x_sqrt(uintValues[j]);
+    }
+
+    benchKeep(intOut);
+}
+
+static void benchFastRecip(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        int j = i & DATA_MASK;
+        intOut[j] = x_fastrecip(recipValues[j]);
+    }
+
+    benchKeep(intOut);
+}
+
+static void benchTransform(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        int j = i & DATA_MASK;
+        transformedPoints[j] = transformMatrix.transform(points[j]);
+    }
+
+    benchKeep(transformedPoints);
+}
+
+static void benchTransformPoints(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; i += TRANSFORM_BATCH_SIZE)
+    {
+        int j = i & DATA_MASK;
+        int count = std::min(TRANSFORM_BATCH_SIZE, state.iterations - i);
+
+        transformMatrix.transformPoints(points + j, transformedPoints + j, count);
+    }
+
+    benchKeep(transformedPoints);
+}
+
+void registerMathBenchmarks(BenchmarkRunner& runner)
+{
+    initMathData();
+
+    runner.add("fp.mul", benchFpMul);
+    runner.add("fp.div", benchFpDiv);
+    runner.add("math.x_sqrt", benchSqrt);
+    runner.add("math.x_fastrecip", benchFastRecip);
+    runner.add("mat4x4.transform", benchTransform);
+    runner.add("mat4x4.transformPoints", benchTransformPoints);
+}
@@ -0,0 +1,115 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.hpp"
+#include "memory/Cache.h"
+#include "memory/Memory.hpp"
+#include "math/Random.hpp"
+
+//======================== surface cache ========================
+
+static const int CACHE_SIZE = 1024 * 1024;
+static const int TOTAL_CACHE_ENTRIES = 2048;
+
+static X_Cache cache;
+static X_CacheEntry cacheEntries[TOTAL_CACHE_ENTRIES];
+static int cacheEntrySizes[TOTAL_CACHE_ENTRIES];
+
+static void initCacheData()
+{
+    Random random;
+
+    x_cache_init(&cache, CACHE_SIZE, "bench");
+
+    // Roughly the spread of surface sizes across mip levels. The entries add up to several times
+    // the size of the cache and are used round robin, so (like the renderer's surface cache when
+    // it's under pressure) almost every lookup misses and evicts the least recently used blocks.
+    for(int i = 0; i < TOTAL_CACHE_ENTRIES; ++i)
+    {
+        x_cacheentry_init(cacheEntries + i);
+        cacheEntrySizes[i] = random.nextInRange(64, 8192);
+    }
+}
+
+// One op = looking up an entry and allocating it if it's not in the cache
+static void benchCacheAlloc(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        X_CacheEntry* entry = cacheEntries + (i & (TOTAL_CACHE_ENTRIES - 1));
+        void* data = x_cache_get_cached_data(&cache, entry);
+
+        if(data == nullptr)
+        {
+            x_cache_alloc(&cache, cacheEntrySizes[i & (TOTAL_CACHE_ENTRIES - 1)], entry);
+        }
+
+        benchKeep(data);
+    }
+}
+
+//======================== zone ========================
+
+static const int TOTAL_LIVE_ZONE_BLOCKS = 64;
+
+static int zoneBlockSizes[TOTAL_LIVE_ZONE_BLOCKS * 4];
+static unsigned char* liveZoneBlocks[TOTAL_LIVE_ZONE_BLOCKS];
+
+static void initZoneData()
+{
+    Random random;
+
+    for(int i = 0; i < TOTAL_LIVE_ZONE_BLOCKS * 4; ++i)
+    {
+        zoneBlockSizes[i] = random.nextInRange(16, 512);
+    }
+}
+
+// One op = freeing the oldest of a ring of live blocks and allocating a new one in its place, the
+// pattern of short-lived containers and strings
+static void benchZoneAlloc(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        unsigned char*& block = liveZoneBlocks[i & (TOTAL_LIVE_ZONE_BLOCKS - 1)];
+
+        if(block != nullptr)
+        {
+            Zone::free(block);
+        }
+
+        block = Zone::alloc<unsigned char>(zoneBlockSizes[i & (TOTAL_LIVE_ZONE_BLOCKS * 4 - 1)]);
+        block[0] = i;
+    }
+
+    // Start every sample from an empty ring so they all do the same work
+    for(int i = 0; i < TOTAL_LIVE_ZONE_BLOCKS; ++i)
+    {
+        if(liveZoneBlocks[i] != nullptr)
+        {
+            Zone::free(liveZoneBlocks[i]);
+            liveZoneBlocks[i] = nullptr;
+        }
+    }
+}
+
+void registerMemoryBenchmarks(BenchmarkRunner& runner)
+{
+    initCacheData();
+    runner.add("memory.x_cache_alloc", benchCacheAlloc);
+
+    initZoneData();
+    runner.add("memory.zoneAllocFree", benchZoneAlloc);
+}
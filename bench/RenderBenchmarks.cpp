@@ -0,0 +1,80 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.hpp"
+#include "BenchScene.hpp"
+#include "util/StopWatch.hpp"
+
+// One op = rendering one frame. Iterations are a multiple of the number of views, so every sample
+// renders each view the same number of times.
+static void benchRenderFrame(BenchmarkState& state)
+{
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        BenchScene::setView(i % BenchScene::TOTAL_VIEWS);
+        BenchScene::renderFrame();
+    }
+}
+
+// Renders frames but only counts the time the renderer spent in one of its StopWatch phases. A phase
+// can run several times per frame (once per camera and portal view), so this takes the change in the
+// phase's running total rather than frameTicks, which only holds the last interval.
+static void renderFramesAndTimePhase(BenchmarkState& state, const char* phaseName)
+{
+    long long totalMicroseconds = 0;
+
+    for(int i = 0; i < state.iterations; ++i)
+    {
+        StopWatchEntry* entry = StopWatch::getEntry(phaseName);
+        long long ticksBefore = entry != nullptr ? entry->totalTicks : 0;
+
+        BenchScene::setView(i % BenchScene::TOTAL_VIEWS);
+        BenchScene::renderFrame();
+
+        // The entry is created the first time the phase runs
+        entry = StopWatch::getEntry(phaseName);
+
+        if(entry != nullptr)
+        {
+            totalMicroseconds += entry->totalTicks - ticksBefore;
+        }
+    }
+
+    state.setElapsedNs(totalMicroseconds * 1000.0);
+}
+
+// Sorting new edges into the active edge list and scanning it into spans
+static void benchScanEdges(BenchmarkState& state)
+{
+    renderFramesAndTimePhase(state, "scan-active-edge");
+}
+
+// Texturing the spans
+static void benchRenderSpans(BenchmarkState& state)
+{
+    renderFramesAndTimePhase(state, "render-spans");
+}
+
+void registerRenderBenchmarks(BenchmarkRunner& runner)
+{
+    if(!BenchScene::isLoaded())
+    {
+        return;
+    }
+
+    runner.add("render.frame", benchRenderFrame, BenchScene::TOTAL_VIEWS);
+    runner.add("render.edgeSortAndScan", benchScanEdges, BenchScene::TOTAL_VIEWS);
+    runner.add("render.spanTexturing", benchRenderSpans, BenchScene::TOTAL_VIEWS);
+}
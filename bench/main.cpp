@@ -0,0 +1,165 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "X3D.hpp"
+#include "Benchmark.hpp"
+#include "BenchScene.hpp"
+
+#ifndef X_BENCH_DATA_PATH
+#define X_BENCH_DATA_PATH "../test"
+#endif
+
+// Normally defined by the game
+bool physics = true;
+
+static const int DEFAULT_TOTAL_SAMPLES = 15;
+
+static void printUsage()
+{
+    printf(
+        "Usage: x3d_bench [options]\n"
+        "  --list             list the benchmarks and exit\n"
+        "  --filter <text>    only run benchmarks whose name contains text\n"
+        "  --samples <n>      timed samples per benchmark (default %d)\n"
+        "  --map <file>       level to benchmark (default x3d.bsp)\n"
+        "  --data <dir>       directory with the maps and assets (default %s)\n"
+        "  --out <file>       save the results as a baseline\n"
+        "  --compare <file>   compare the results with a saved baseline\n",
+        DEFAULT_TOTAL_SAMPLES,
+        X_BENCH_DATA_PATH);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* filter = nullptr;
+    const char* mapName = "x3d.bsp";
+    const char* dataPath = X_BENCH_DATA_PATH;
+    const char* outFileName = nullptr;
+    const char* compareFileName = nullptr;
+    int totalSamples = DEFAULT_TOTAL_SAMPLES;
+    bool listOnly = false;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--list") == 0)
+        {
+            listOnly = true;
+        }
+        else if(strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "--samples") == 0 && hasValue)
+        {
+            totalSamples = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--map") == 0 && hasValue)
+        {
+            mapName = argv[++i];
+        }
+        else if(strcmp(argv[i], "--data") == 0 && hasValue)
+        {
+            dataPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--out") == 0 && hasValue)
+        {
+            outFileName = argv[++i];
+        }
+        else if(strcmp(argv[i], "--compare") == 0 && hasValue)
+        {
+            compareFileName = argv[++i];
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if(totalSamples < 2)
+    {
+        fprintf(stderr, "Need at least 2 samples to measure variance\n");
+        return 1;
+    }
+
+    // Nothing is shown, so don't require a display
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+    // The engine finds files relative to the program's directory, so run as if we were the game in
+    // its release directory
+    char programPath[512];
+    snprintf(programPath, sizeof(programPath), "%s/release/x3d_bench", dataPath);
+
+    ScreenConfig screenConfig = ScreenConfig()
+        .fieldOfView(X_ANG_60)
+        .resolution(640, 480)
+        .useQuakeColorPalette();
+
+    X_Config config = X_Config()
+        .programPath(programPath)
+        .defaultFont("../assets/font.xtex")
+        .screenConfig(screenConfig);
+
+    config.systemConfig.programPath = programPath;
+    config.systemConfig.enableLogging = false;
+
+    EngineContext* engineContext = Engine::init(config);
+
+    char searchPath[512];
+    snprintf(searchPath, sizeof(searchPath), "%s/maps", dataPath);
+    FileSystem::addSearchPath(searchPath);
+
+    snprintf(searchPath, sizeof(searchPath), "%s/assets", dataPath);
+    FileSystem::addSearchPath(searchPath);
+
+    if(!BenchScene::load(engineContext, mapName))
+    {
+        fprintf(stderr, "Failed to load %s with a player start, skipping level and render benchmarks\n", mapName);
+    }
+
+    BenchmarkRunner runner(engineContext, totalSamples);
+
+    registerMathBenchmarks(runner);
+    registerMemoryBenchmarks(runner);
+    registerJsonBenchmarks(runner);
+    registerLevelBenchmarks(runner);
+    registerRenderBenchmarks(runner);
+
+    if(listOnly)
+    {
+        runner.list();
+        return 0;
+    }
+
+    runner.run(filter);
+
+    if(outFileName != nullptr && !runner.writeBaseline(outFileName))
+    {
+        return 1;
+    }
+
+    if(compareFileName != nullptr && !runner.compareWithBaseline(compareFileName))
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -17,6 +17,8 @@
 
 // dev
 #include "dev/console/Console.hpp"
+#include "dev/console/ConsoleScript.hpp"
+#include "dev/console/StdinCommandChannel.hpp"
 
 // geo
 #include "geo/BoundBox.hpp"
@@ -110,6 +112,7 @@
 
 // util
 #include "util/Json.hpp"
+#include "util/JsonDocument.hpp"
 #include "util/Util.hpp"
 #include "util/StopWatch.hpp"
 
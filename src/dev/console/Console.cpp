@@ -26,6 +26,9 @@
 #include "error/Log.hpp"
 #include "dev/console/AutoCompleter.hpp"
 #include "TokenLexer.hpp"
+#include "ConsoleScript.hpp"
+
+static const int INITIAL_NAME_TABLE_SIZE = 64;
 
 void x_console_open(Console* console)
 {
@@ -52,6 +55,93 @@ static void x_consolevar_init(X_ConsoleVar* consoleVar, void* var, const char* n
     x_consolevar_set_value(consoleVar, initialValue);
 }
 
+static const char* x_console_name_of(const Console* console, const X_ConsoleName* entry)
+{
+    return entry->isCmd
+        ? console->consoleCmds[entry->index].name
+        : console->consoleVars[entry->index].name;
+}
+
+// Returns the slot for the name, or the empty slot it would go in. The name is only compared when
+// the ids match, in case two names share a CRC.
+static X_ConsoleName* x_console_find_name_slot(Console* console, StringId id, const char* name)
+{
+    unsigned int mask = console->nameTableSize - 1;
+    unsigned int pos = id.key & mask;
+
+    while(true)
+    {
+        X_ConsoleName* entry = console->nameTable + pos;
+
+        if(entry->index < 0)
+        {
+            return entry;
+        }
+
+        if(entry->id == id && strcmp(x_console_name_of(console, entry), name) == 0)
+        {
+            return entry;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+}
+
+static X_ConsoleName* x_console_lookup_name(Console* console, StringId id, const char* name)
+{
+    X_ConsoleName* entry = x_console_find_name_slot(console, id, name);
+
+    return entry->index >= 0 ? entry : NULL;
+}
+
+static void x_console_insert_name(Console* console, const char* name, int index, bool isCmd)
+{
+    StringId id = StringId::fromString(name);
+    X_ConsoleName* entry = x_console_find_name_slot(console, id, name);
+
+    entry->id = id;
+    entry->index = index;
+    entry->isCmd = isCmd;
+}
+
+static void x_console_resize_name_table(Console* console, int newSize)
+{
+    x_free(console->nameTable);
+
+    console->nameTableSize = newSize;
+    console->nameTable = (X_ConsoleName*)x_malloc(newSize * sizeof(X_ConsoleName));
+
+    for(int i = 0; i < newSize; ++i)
+    {
+        console->nameTable[i].index = -1;
+    }
+
+    for(int i = 0; i < console->totalConsoleCmds; ++i)
+    {
+        x_console_insert_name(console, console->consoleCmds[i].name, i, true);
+    }
+
+    for(int i = 0; i < console->totalConsoleVars; ++i)
+    {
+        x_console_insert_name(console, console->consoleVars[i].name, i, false);
+    }
+}
+
+// Keeps the table at most half full so probe sequences stay short
+static void x_console_add_name(Console* console, const char* name, int index, bool isCmd)
+{
+    int totalNames = console->totalConsoleCmds + console->totalConsoleVars;
+
+    if(totalNames * 2 > console->nameTableSize)
+    {
+        // Rehashing picks up the new entry, since it has already been added to its array
+        x_console_resize_name_table(console, console->nameTableSize * 2);
+        return;
+    }
+
+    x_console_insert_name(console, name, index, isCmd);
+}
+
 static X_ConsoleVar* x_console_add_var(Console* console)
 {
     ++console->totalConsoleVars;
@@ -76,17 +166,20 @@ void x_console_register_var(Console* console, void* var, const char* name, X_Con
     
     X_ConsoleVar* consoleVar = x_console_add_var(console);
     x_consolevar_init(consoleVar, var, name, type, initialValue, saveToConfig);
+
+    x_console_add_name(console, name, console->totalConsoleVars - 1, false);
+}
+
+static X_ConsoleCmd* x_console_get_cmd_by_id(Console* console, StringId id, const char* cmdName)
+{
+    X_ConsoleName* entry = x_console_lookup_name(console, id, cmdName);
+
+    return entry != NULL && entry->isCmd ? console->consoleCmds + entry->index : NULL;
 }
 
 X_ConsoleCmd* x_console_get_cmd(Console* console, const char* cmdName)
 {
-    for(int i = 0; i < console->totalConsoleCmds; ++i)
-    {
-        if(strcmp(console->consoleCmds[i].name, cmdName) == 0)
-            return console->consoleCmds + i;
-    }
-    
-    return NULL;
+    return x_console_get_cmd_by_id(console, StringId::fromString(cmdName), cmdName);
 }
 
 bool x_console_cmd_exists(Console* console, const char* cmdName)
@@ -119,6 +212,8 @@ void x_console_register_cmd(Console* console, const char* name, X_ConsoleCmdHand
     X_ConsoleCmd* cmd = x_console_add_cmd(console);
     cmd->name = name;
     cmd->handler = handler;
+
+    x_console_add_name(console, name, console->totalConsoleCmds - 1, true);
 }
 
 static int x_console_bytes_in_line(const Console* console)
@@ -184,6 +279,11 @@ Console::Console(EngineContext* engineContext, Font* font)
     
     consoleVars = NULL;
     totalConsoleVars = 0;
+
+    nameTable = NULL;
+    x_console_resize_name_table(this, INITIAL_NAME_TABLE_SIZE);
+
+    scriptHead = NULL;
     
     commandHistorySize = 0;
     commandHistoryPos = 0;
@@ -214,17 +314,21 @@ void x_console_cleanup(Console* console)
     
     x_free(console->consoleCmds);
     x_free(console->consoleVars);
+    x_free(console->nameTable);
+
+    x_console_free_scripts(console);
+}
+
+static X_ConsoleVar* x_console_get_var_by_id(Console* console, StringId id, const char* varName)
+{
+    X_ConsoleName* entry = x_console_lookup_name(console, id, varName);
+
+    return entry != NULL && !entry->isCmd ? console->consoleVars + entry->index : NULL;
 }
 
 X_ConsoleVar* x_console_get_var(Console* console, const char* varName)
 {
-    for(int i = 0; i < console->totalConsoleVars; ++i)
-    {
-        if(strcmp(console->consoleVars[i].name, varName) == 0)
-            return console->consoleVars + i;
-    }
-    
-    return NULL;
+    return x_console_get_var_by_id(console, StringId::fromString(varName), varName);
 }
 
 bool x_console_var_exists(Console* console, const char* name)
@@ -708,23 +812,8 @@ static bool x_tokenlexer_is_valid_console_input(X_TokenLexer* lexer, char** toke
         !token_begins_comment_line(tokens[0]);
 }
 
-static bool x_console_input_try_execute_command(Console* console, char** tokens, int totalTokens)
-{
-    X_ConsoleCmd* cmd = x_console_get_cmd(console, tokens[0]);
-    
-    if(cmd == NULL)
-        return 0;
-    
-    cmd->handler(console->engineContext, totalTokens, tokens);
-    return 1;
-}
-
-static bool x_console_input_try_set_variable(Console* console, char** tokens, int totalTokens)
+static bool x_console_input_try_set_variable(Console* console, X_ConsoleVar* var, char** tokens, int totalTokens)
 {
-    X_ConsoleVar* var = x_console_get_var(console, tokens[0]);
-    if(!var)
-        return 0;
-    
     if(totalTokens > 2)
     {
         x_console_print(console, "Expected syntax <var> <value to set to>\n");
@@ -752,16 +841,29 @@ static int count_tokens_in_cmd(char** tokens, int totalTokens)
     return totalTokens;
 }
 
-static bool try_run_command(Console* console, char** tokens, int totalTokens)
+// Runs a command whose name has already been hashed (precompiled scripts hash theirs only once)
+bool x_console_execute_tokens(Console* console, StringId name, char** tokens, int totalTokens)
 {
-    if(x_console_input_try_execute_command(console, tokens, totalTokens))
-        return 1;
-    
-    if(x_console_input_try_set_variable(console, tokens, totalTokens))
+    X_ConsoleName* entry = x_console_lookup_name(console, name, tokens[0]);
+
+    if(entry == NULL)
+    {
+        x_console_printf(console, "Unknown command or var %s\n", tokens[0]);
+        return 0;
+    }
+
+    if(entry->isCmd)
+    {
+        console->consoleCmds[entry->index].handler(console->engineContext, totalTokens, tokens);
         return 1;
-    
-    x_console_printf(console, "Unknown command or var %s\n", tokens[0]);
-    return 0;
+    }
+
+    return x_console_input_try_set_variable(console, console->consoleVars + entry->index, tokens, totalTokens);
+}
+
+static bool try_run_command(Console* console, char** tokens, int totalTokens)
+{
+    return x_console_execute_tokens(console, StringId::fromString(tokens[0]), tokens, totalTokens);
 }
 
 void x_console_execute_cmd(Console* console, const char* str)
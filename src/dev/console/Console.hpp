@@ -16,6 +16,7 @@
 #pragma once
 
 #include "memory/String.h"
+#include "memory/StringId.hpp"
 #include "math/FixedPoint.hpp"
 #include "geo/Vec2.hpp"
 #include "geo/Vec3.hpp"
@@ -66,9 +67,18 @@ typedef struct X_ConsoleCmd
     X_ConsoleCmdHandler handler;    
 } X_ConsoleCmd;
 
+// Slot in the table used to look up commands and variables by name (they share one namespace)
+typedef struct X_ConsoleName
+{
+    StringId id;
+    short index;        // Index into consoleCmds or consoleVars, -1 if the slot is empty
+    bool isCmd;
+} X_ConsoleName;
+
 #define X_CONSOLE_COMMAND_HISTORY_SIZE 10
 
 struct ConsoleVariable;
+struct ConsoleScript;
 
 typedef struct Console
 {
@@ -82,6 +92,11 @@ typedef struct Console
     
     X_ConsoleCmd* consoleCmds;
     int totalConsoleCmds;
+
+    X_ConsoleName* nameTable;
+    int nameTableSize;
+
+    ConsoleScript* scriptHead;
     
     Vec2 cursor;
     Vec2 size;
@@ -137,4 +152,5 @@ void x_console_render(Console* console);
 void x_console_send_key(Console* console, KeyCode key);
 
 void x_console_execute_cmd(Console* console, const char* str);
+bool x_console_execute_tokens(Console* console, StringId name, char** tokens, int totalTokens);
 
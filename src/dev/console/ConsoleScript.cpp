@@ -0,0 +1,308 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <string.h>
+
+#include "ConsoleScript.hpp"
+#include "Console.hpp"
+#include "TokenLexer.hpp"
+#include "memory/Alloc.h"
+#include "system/File.hpp"
+
+// Lines are capped well below what the lexer can hold, so tokenizing a line can never fail
+static const int MAX_LINE_LENGTH = 512;
+static const int MAX_LINE_TOKENS = 512;
+static const int TOKEN_BUF_SIZE = 1024;
+
+// Stops runaway recursion from scripts that run themselves
+static const int MAX_SCRIPT_DEPTH = 16;
+
+struct ConsoleScriptSize
+{
+    int totalCommands;
+    int totalTokens;
+    int totalStringBytes;
+};
+
+// Copies the next line into dest (dropping any '\r') and returns the start of the line after it
+static const char* read_line(const char* text, char* dest, bool* tooLong)
+{
+    char* destEnd = dest + MAX_LINE_LENGTH - 1;
+    *tooLong = false;
+
+    while(*text != '\0' && *text != '\n')
+    {
+        if(*text != '\r')
+        {
+            if(dest == destEnd)
+            {
+                *tooLong = true;
+            }
+            else
+            {
+                *dest++ = *text;
+            }
+        }
+
+        ++text;
+    }
+
+    *dest = '\0';
+
+    return *text == '\n' ? text + 1 : text;
+}
+
+static bool is_comment(const char* token)
+{
+    return token[0] == '/' && token[1] == '/';
+}
+
+// Walks the whole script. The first pass only measures it (script is null) and reports any problems,
+// the second fills in the block.
+static void compile_lines(Console* console, const char* name, const char* text, ConsoleScriptSize* size, ConsoleScript* script, char** tokensOut, char* stringsOut)
+{
+    size->totalCommands = 0;
+    size->totalTokens = 0;
+    size->totalStringBytes = 0;
+
+    char line[MAX_LINE_LENGTH];
+    char tokenBuf[TOKEN_BUF_SIZE];
+    char* tokens[MAX_LINE_TOKENS];
+    int lineNumber = 0;
+
+    while(*text != '\0')
+    {
+        bool tooLong;
+        text = read_line(text, line, &tooLong);
+        ++lineNumber;
+
+        if(tooLong)
+        {
+            if(script == NULL)
+            {
+                x_console_printf(console, "Skipping line %d of %s (line too long)\n", lineNumber, name);
+            }
+
+            continue;
+        }
+
+        X_TokenLexer lexer;
+        x_tokenlexer_init(&lexer, line, tokenBuf, TOKEN_BUF_SIZE, tokens, MAX_LINE_TOKENS, console);
+        x_tokenlexer_tokenize(&lexer);
+
+        if(lexer.errorOccured || lexer.totalTokens == 0 || is_comment(tokens[0]))
+        {
+            continue;
+        }
+
+        int cmdStart = 0;
+        int firstCmdOnLine = size->totalCommands;
+
+        for(int i = 0; i <= lexer.totalTokens; ++i)
+        {
+            if(i < lexer.totalTokens && strcmp(tokens[i], ";") != 0)
+            {
+                continue;
+            }
+
+            int totalCmdTokens = i - cmdStart;
+
+            if(totalCmdTokens > 0)
+            {
+                if(script != NULL)
+                {
+                    ConsoleScriptCommand* cmd = script->commands + size->totalCommands;
+
+                    cmd->name = StringId::fromString(tokens[cmdStart]);
+                    cmd->tokens = tokensOut + size->totalTokens;
+                    cmd->totalTokens = totalCmdTokens;
+                    cmd->endsLine = false;
+                }
+
+                for(int j = cmdStart; j < i; ++j)
+                {
+                    int length = strlen(tokens[j]) + 1;
+
+                    if(script != NULL)
+                    {
+                        char* dest = stringsOut + size->totalStringBytes;
+                        memcpy(dest, tokens[j], length);
+
+                        tokensOut[size->totalTokens] = dest;
+                    }
+
+                    ++size->totalTokens;
+                    size->totalStringBytes += length;
+                }
+
+                ++size->totalCommands;
+            }
+
+            cmdStart = i + 1;
+        }
+
+        if(script != NULL && size->totalCommands > firstCmdOnLine)
+        {
+            script->commands[size->totalCommands - 1].endsLine = true;
+        }
+    }
+}
+
+ConsoleScript* x_console_compile_script(Console* console, const char* name, const char* text)
+{
+    ConsoleScriptSize size;
+    compile_lines(console, name, text, &size, NULL, NULL, NULL);
+
+    int nameLength = strlen(name) + 1;
+    int totalBytes = sizeof(ConsoleScript)
+        + size.totalCommands * sizeof(ConsoleScriptCommand)
+        + size.totalTokens * sizeof(char*)
+        + nameLength
+        + size.totalStringBytes;
+
+    unsigned char* block = (unsigned char*)x_malloc(totalBytes);
+
+    ConsoleScript* script = (ConsoleScript*)block;
+    script->commands = (ConsoleScriptCommand*)(script + 1);
+    script->totalCommands = size.totalCommands;
+    script->runDepth = 0;
+    script->next = NULL;
+
+    char** tokens = (char**)(script->commands + size.totalCommands);
+    char* strings = (char*)(tokens + size.totalTokens);
+
+    memcpy(strings, name, nameLength);
+    script->name = strings;
+
+    compile_lines(console, name, text, &size, script, tokens, strings + nameLength);
+
+    return script;
+}
+
+ConsoleScript* x_console_compile_script_file(Console* console, const char* name, const char* fileName)
+{
+    X_File file;
+
+    if(!x_file_open_reading(&file, fileName))
+    {
+        return NULL;
+    }
+
+    char* text = (char*)x_malloc(file.size + 1);
+    x_file_read_buf(&file, file.size, text);
+    text[file.size] = '\0';
+
+    x_file_close(&file);
+
+    ConsoleScript* script = x_console_compile_script(console, name, text);
+    x_free(text);
+
+    return script;
+}
+
+void x_console_run_script(Console* console, ConsoleScript* script)
+{
+    if(script->runDepth == MAX_SCRIPT_DEPTH)
+    {
+        x_console_printf(console, "Not running %s (scripts nested too deeply)\n", script->name);
+        return;
+    }
+
+    ++script->runDepth;
+
+    for(int i = 0; i < script->totalCommands; ++i)
+    {
+        ConsoleScriptCommand* cmd = script->commands + i;
+
+        if(!x_console_execute_tokens(console, cmd->name, cmd->tokens, cmd->totalTokens))
+        {
+            while(!script->commands[i].endsLine)
+            {
+                ++i;
+            }
+        }
+    }
+
+    --script->runDepth;
+}
+
+void x_console_free_script(ConsoleScript* script)
+{
+    x_free(script);
+}
+
+ConsoleScript* x_console_get_script(Console* console, const char* name)
+{
+    for(ConsoleScript* script = console->scriptHead; script != NULL; script = script->next)
+    {
+        if(strcmp(script->name, name) == 0)
+        {
+            return script;
+        }
+    }
+
+    return NULL;
+}
+
+// Compiles a file and keeps it around under the given name, replacing any script already using it
+bool x_console_load_script(Console* console, const char* name, const char* fileName)
+{
+    ConsoleScript* oldScript = x_console_get_script(console, name);
+
+    if(oldScript != NULL && oldScript->runDepth > 0)
+    {
+        x_console_printf(console, "Can't reload script %s while it's running\n", name);
+        return false;
+    }
+
+    ConsoleScript* script = x_console_compile_script_file(console, name, fileName);
+
+    if(script == NULL)
+    {
+        x_console_printf(console, "Failed to open file %s\n", fileName);
+        return false;
+    }
+
+    ConsoleScript** link = &console->scriptHead;
+
+    while(*link != NULL && *link != oldScript)
+    {
+        link = &(*link)->next;
+    }
+
+    if(*link != NULL)
+    {
+        script->next = oldScript->next;
+        x_console_free_script(oldScript);
+    }
+
+    *link = script;
+
+    return true;
+}
+
+void x_console_free_scripts(Console* console)
+{
+    ConsoleScript* script = console->scriptHead;
+
+    while(script != NULL)
+    {
+        ConsoleScript* next = script->next;
+        x_console_free_script(script);
+        script = next;
+    }
+
+    console->scriptHead = NULL;
+}
@@ -0,0 +1,48 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "memory/StringId.hpp"
+
+struct Console;
+
+struct ConsoleScriptCommand
+{
+    StringId name;
+    char** tokens;
+    int totalTokens;
+    bool endsLine;      // An unknown command skips the rest of its line, like it does when typed in
+};
+
+// A console script that has been split into commands and tokenized once, so running it again
+// only dispatches the commands. Everything lives in a single allocation.
+struct ConsoleScript
+{
+    const char* name;
+    ConsoleScriptCommand* commands;
+    int totalCommands;
+    int runDepth;
+    ConsoleScript* next;
+};
+
+ConsoleScript* x_console_compile_script(struct Console* console, const char* name, const char* text);
+ConsoleScript* x_console_compile_script_file(struct Console* console, const char* name, const char* fileName);
+void x_console_run_script(struct Console* console, ConsoleScript* script);
+void x_console_free_script(ConsoleScript* script);
+
+bool x_console_load_script(struct Console* console, const char* name, const char* fileName);
+ConsoleScript* x_console_get_script(struct Console* console, const char* name);
+void x_console_free_scripts(struct Console* console);
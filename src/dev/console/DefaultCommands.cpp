@@ -14,10 +14,15 @@
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dev/console/Console.hpp"
+#include "dev/console/ConsoleScript.hpp"
 #include "engine/Engine.hpp"
 #include "util/Util.hpp"
 #include "system/PackFile.hpp"
 #include "level/LevelManager.hpp"
+#include "memory/MemoryStats.hpp"
+#include "render/OldRenderer.hpp"
+#include "render/Surface.h"
+#include "render/SurfaceLayout.hpp"
 
 static void cmd_echo(EngineContext* context, int argc, char* argv[])
 {
@@ -117,24 +122,221 @@ static void cmd_exec(EngineContext* context, int argc, char* argv[])
         return;
     }
     
-    char line[512];
-    X_File file;
-    
-    if(!x_file_open_reading(&file, argv[1]))
+    ConsoleScript* script = x_console_compile_script_file(context->console, argv[1], argv[1]);
+
+    if(script == NULL)
     {
         x_console_printf(context->console, "Failed to open file %s for execution\n", argv[1]);
         return;
     }
-    
-    while(x_file_read_line(&file, sizeof(line), line))
+
+    x_console_run_script(context->console, script);
+    x_console_free_script(script);
+}
+
+static void cmd_scriptload(EngineContext* context, int argc, char* argv[])
+{
+    if(argc != 3)
+    {
+        x_console_print(context->console, "Usage: script.load [name] [file] -> compiles a script file once so it can be run repeatedly\n");
+        return;
+    }
+
+    if(x_console_load_script(context->console, argv[1], argv[2]))
+    {
+        x_console_printf(context->console, "Loaded script %s\n", argv[1]);
+    }
+}
+
+static void cmd_scriptrun(EngineContext* context, int argc, char* argv[])
+{
+    if(argc != 2 && argc != 3)
     {
-        if(*line)
+        x_console_print(context->console, "Usage: script.run [name] [times] -> runs a script loaded with script.load\n");
+        return;
+    }
+
+    ConsoleScript* script = x_console_get_script(context->console, argv[1]);
+
+    if(script == NULL)
+    {
+        x_console_printf(context->console, "No script named %s\n", argv[1]);
+        return;
+    }
+
+    int totalRuns = (argc == 3 ? atoi(argv[2]) : 1);
+
+    for(int i = 0; i < totalRuns; ++i)
+    {
+        x_console_run_script(context->console, script);
+    }
+}
+
+static void cmd_memstats(EngineContext* context, int argc, char* argv[])
+{
+    if(argc == 3 && strcmp(argv[1], "json") == 0)
+    {
+        if(!MemoryStats::dumpJson(argv[2]))
         {
-            x_console_execute_cmd(context->console, line);
+            x_console_printf(context->console, "Failed to open %s for writing\n", argv[2]);
+            return;
         }
+
+        x_console_printf(context->console, "Wrote memory stats to %s\n", argv[2]);
+        return;
+    }
+
+    if(argc != 1)
+    {
+        x_console_print(context->console, "Usage: mem.stats [json file] -> prints memory usage per allocator and tag\n");
+        return;
+    }
+
+    for(int i = 0; i < (int)MemorySource::TOTAL; ++i)
+    {
+        MemorySourceStats stats;
+        MemoryStats::getSourceStats((MemorySource)i, stats);
+
+        x_console_printf(context->console, "%-6s %8d / %8d bytes, peak %8d\n",
+            MemoryStats::getSourceName((MemorySource)i),
+            stats.usedBytes,
+            stats.capacityBytes,
+            stats.peakBytes);
+    }
+
+    x_console_print(context->console, "\n");
+
+    for(int i = 0; i < MemoryStats::getTotalTags(); ++i)
+    {
+        MemoryTagStats stats;
+        MemoryStats::getTagStats(i, stats);
+
+        if(stats.totalAllocs == 0)
+        {
+            continue;
+        }
+
+        x_console_printf(context->console, "%-6s %-15s live %8d peak %8d allocs %d/%d\n",
+            MemoryStats::getSourceName(stats.source),
+            stats.name,
+            stats.liveBytes,
+            stats.peakBytes,
+            stats.liveAllocs,
+            stats.totalAllocs);
     }
 }
 
+static unsigned int hash_surface_texels(const Texture& surface, SurfaceTexelLayout layout)
+{
+    unsigned int hash = 2166136261u;
+    int tiledW = x_surface_tiled_size(surface.getW());
+
+    for(int y = 0; y < surface.getH(); ++y)
+    {
+        for(int x = 0; x < surface.getW(); ++x)
+        {
+            int offset = (layout == SURFACE_TEXELS_TILED
+                ? x_surface_tiled_texel_offset(x, y, tiledW)
+                : y * surface.getW() + x);
+
+            hash = (hash ^ surface.getTexels()[offset]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+// Hash of every surface at every mip level, as built by the original surface builder
+struct RecordedSurfaceHash
+{
+    const char* levelName;
+    unsigned int hash;
+};
+
+static const RecordedSurfaceHash recordedSurfaceHashes[] =
+{
+    { "x3d.bsp", 0x284ba3d7 },
+    { "portal2.bsp", 0x3f47a9a6 }
+};
+
+// Builds every surface of the level at every mip level with the surface builder's original per-texel
+// builder and with its optimized kernels, checks they give the same texels, and checks the level's
+// hash against the one recorded for it
+static void cmd_surfacecheck(EngineContext* context, int argc, char* argv[])
+{
+    BspLevel* level = context->levelManager->getCurrentLevel();
+
+    if(level == nullptr)
+    {
+        x_console_print(context->console, "No level loaded\n");
+        return;
+    }
+
+    OldRenderer* renderer = context->renderer;
+    unsigned int levelHash = 2166136261u;
+    int totalChecked = 0;
+    int mismatches = 0;
+
+    for(int i = 0; i < level->totalSurfaces; ++i)
+    {
+        BspSurface* surface = level->surfaces + i;
+
+        // Sky and liquids aren't built through the surface cache
+        if(surface->faceTexture->flags != 0)
+        {
+            continue;
+        }
+
+        for(int mipLevel = 0; mipLevel < X_BSPTEXTURE_MIP_LEVELS; ++mipLevel)
+        {
+            Texture texture;
+
+            x_surfacebuilder_use_reference_kernels(true);
+            x_bspsurface_rebuild_for_mip_level(surface, mipLevel, renderer, &texture);
+            unsigned int referenceHash = hash_surface_texels(texture, renderer->surfaceTexelLayout);
+
+            x_surfacebuilder_use_reference_kernels(false);
+            x_bspsurface_rebuild_for_mip_level(surface, mipLevel, renderer, &texture);
+
+            if(hash_surface_texels(texture, renderer->surfaceTexelLayout) != referenceHash)
+            {
+                if(mismatches < 8)
+                {
+                    x_console_printf(context->console, "Surface %d mip %d differs\n", i, mipLevel);
+                }
+
+                ++mismatches;
+            }
+
+            levelHash = (levelHash ^ referenceHash) * 16777619u;
+            ++totalChecked;
+        }
+    }
+
+    x_console_printf(context->console, "%d surface mip levels checked, %d differ (hash %08x)\n", totalChecked, mismatches, levelHash);
+
+    for(int i = 0; i < (int)(sizeof(recordedSurfaceHashes) / sizeof(recordedSurfaceHashes[0])); ++i)
+    {
+        if(strcmp(level->name, recordedSurfaceHashes[i].levelName) != 0)
+        {
+            continue;
+        }
+
+        if(mismatches != 0 || levelHash != recordedSurfaceHashes[i].hash)
+        {
+            x_console_printf(context->console, "FAILED (expected hash %08x for %s)\n", recordedSurfaceHashes[i].hash, level->name);
+        }
+        else
+        {
+            x_console_print(context->console, "Passed\n");
+        }
+
+        return;
+    }
+
+    x_console_printf(context->console, "No recorded hash for %s\n", level->name);
+}
+
 void x_console_register_builtin_commands(Console* console)
 {
     x_console_register_cmd(console, "echo", cmd_echo);    
@@ -143,5 +345,9 @@ void x_console_register_builtin_commands(Console* console)
     x_console_register_cmd(console, "packextract", cmd_packextract);    
     x_console_register_cmd(console, "searchpath", cmd_searchpath);    
     x_console_register_cmd(console, "exec", cmd_exec);
+    x_console_register_cmd(console, "script.load", cmd_scriptload);
+    x_console_register_cmd(console, "script.run", cmd_scriptrun);
+    x_console_register_cmd(console, "mem.stats", cmd_memstats);
+    x_console_register_cmd(console, "surfacecheck", cmd_surfacecheck);
 }
 
@@ -0,0 +1,132 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "StdinCommandChannel.hpp"
+#include "Console.hpp"
+#include "engine/Config.hpp"
+#include "error/Log.hpp"
+
+#if X_ENABLE_THREADS
+
+#include <chrono>
+#include <thread>
+
+#include "memory/LockFreeQueue.hpp"
+
+struct CommandLine
+{
+    char text[X_CONSOLE_INPUT_BUF_SIZE];
+};
+
+static const int COMMAND_QUEUE_SIZE = 64;
+
+static LockFreeQueue<CommandLine, COMMAND_QUEUE_SIZE> commandQueue;
+static bool channelStarted = false;
+
+static bool read_command_line(char* line, int maxLength)
+{
+    if(fgets(line, maxLength, stdin) == nullptr)
+    {
+        return false;
+    }
+
+    int length = strlen(line);
+    bool sawNewline = length > 0 && line[length - 1] == '\n';
+
+    // Only the start of an overlong line is kept, the rest is thrown away rather than run as its own command
+    if(!sawNewline && !feof(stdin))
+    {
+        int c;
+
+        while((c = fgetc(stdin)) != EOF && c != '\n')
+        {
+        }
+
+        Log::error("Command from stdin too long (truncated to %d characters)", length);
+    }
+
+    while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+    {
+        line[--length] = '\0';
+    }
+
+    return true;
+}
+
+static void reader_thread_main()
+{
+    char line[X_CONSOLE_INPUT_BUF_SIZE];
+
+    while(read_command_line(line, sizeof(line)))
+    {
+        if(*line == '\0')
+        {
+            continue;
+        }
+
+        // Wait for room instead of dropping commands, since a harness expects every one of them to run
+        while(!commandQueue.tryEnqueue([&](CommandLine& command) { strcpy(command.text, line); }))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void StdinCommandChannel::start()
+{
+    if(channelStarted)
+    {
+        return;
+    }
+
+    channelStarted = true;
+
+    // Detached since there's no way to wake up a read that's blocked on stdin when we shut down
+    std::thread(reader_thread_main).detach();
+
+    Log::info("Reading console commands from stdin");
+}
+
+void StdinCommandChannel::poll(Console* console)
+{
+    if(!channelStarted)
+    {
+        return;
+    }
+
+    CommandLine command;
+
+    while(commandQueue.tryDequeue([&](const CommandLine& queued) { command = queued; }))
+    {
+        x_console_printf(console, "] %s\n", command.text);
+        x_console_execute_cmd(console, command.text);
+    }
+}
+
+#else
+
+void StdinCommandChannel::start()
+{
+    Log::error("Reading console commands from stdin requires threads");
+}
+
+void StdinCommandChannel::poll(Console* console)
+{
+}
+
+#endif
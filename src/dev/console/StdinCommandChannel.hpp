@@ -0,0 +1,28 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+struct Console;
+
+// Non-interactive command channel: lines piped into stdin are run as console commands, so test
+// harnesses can drive the engine without going through the on-screen console. A background
+// thread does the blocking reads, and the commands themselves run on the main thread in poll().
+class StdinCommandChannel
+{
+public:
+    static void start();
+    static void poll(Console* console);
+};
@@ -20,6 +20,16 @@
 // Enables colord output for different types of logging
 #define X_ENABLE_COLOR_LOG 1
 
+// nspire has no threads, so anything that would hand off work or needs locking is compiled out
+#ifndef __nspire__
+#define X_ENABLE_THREADS 1
+#else
+#define X_ENABLE_THREADS 0
+#endif
+
+// Log messages are queued and written out by a background thread
+#define X_ENABLE_ASYNC_LOG X_ENABLE_THREADS
+
 // Cursor blink time for the console (in ms)
 #define X_CONSOLE_CURSOR_BLINK_TIME 250
 
@@ -23,6 +23,7 @@
 #include "geo/Polygon3.hpp"
 #include "platform/Platform.hpp"
 #include "memory/Memory.hpp"
+#include "memory/FrameAllocator.hpp"
 #include "util/X_JsonParser.hpp"
 #include "system/FileSystem.hpp"
 #include "physics/PhysicsEngine.hpp"
@@ -36,6 +37,10 @@
 #include "hud/MessageQueue.hpp"
 #include "hud/OverlayRenderer.hpp"
 #include "hud/EntityOverlay.hpp"
+#include "hud/RenderStatsOverlay.hpp"
+#include "render/RenderStats.hpp"
+#include "util/StackTrace.hpp"
+#include "dev/console/StdinCommandChannel.hpp"
 
 EngineContext Engine::instance;
 bool Engine::wasInitialized = false;
@@ -48,6 +53,7 @@ void x_enginecontext_get_rendercontext_for_camera(EngineContext* engineContext,
     dest->canvas = &engineContext->screen->canvas;
     dest->zbuf = engineContext->screen->zbuf;
     dest->currentFrame = x_enginecontext_get_frame(engineContext);
+    dest->pvsFrame = dest->currentFrame;
     dest->engineContext = engineContext;
     dest->level = engineContext->levelManager->getCurrentLevel();
     dest->renderer = engineContext->renderer;
@@ -55,13 +61,16 @@ void x_enginecontext_get_rendercontext_for_camera(EngineContext* engineContext,
     dest->viewFrustum = &cam->viewport.viewFrustum;
     dest->viewMatrix = &cam->viewMatrix;
     dest->renderer = engineContext->renderer;
+    dest->activeEdgeContext = &engineContext->renderer->activeEdgeContext;
 }
 
 static void initSystem(SystemConfig& config)
 {
     FileSystem::init(config.programPath);
     Log::init(config.logFile, config.enableLogging);
+    installCrashHandler();
     MemoryManager::init(config.hunkSize, config.zoneSize);
+    FrameAllocator::init(config.frameBufferSize);
 }
 
 void initEngineContext(EngineContext* context, X_Config& config)
@@ -119,7 +128,10 @@ void initEngineContext(EngineContext* context, X_Config& config)
     context->overlayRenderer = new OverlayRenderer(*context->console);
     context->entityOverlay = new EntityOverlay("entity", context->screen);
 
+    context->renderStatsOverlay = new RenderStatsOverlay("stats", context->screen, context->mainFont);
+
     context->overlayRenderer->addOverlay(context->entityOverlay);
+    context->overlayRenderer->addOverlay(context->renderStatsOverlay);
 }
 
 EngineContext* Engine::init(X_Config& config)
@@ -140,6 +152,11 @@ EngineContext* Engine::init(X_Config& config)
 
     auto platform = instance.getPlatform();
     platform->init(config);
+
+    if(config.systemConfig.enableStdinCommands)
+    {
+        StdinCommandChannel::start();
+    }
     
     wasInitialized = true;
     
@@ -148,8 +165,12 @@ EngineContext* Engine::init(X_Config& config)
 
 void Engine::shutdownEngine()
 {
+    // Closes the JSON array and flushes any rows still buffered
+    RenderStats::stopRecording();
+
     x_platform_cleanup(&instance);
     x_filesystem_cleanup();
+    FrameAllocator::cleanup();
     x_memory_free_all();
     x_log_cleanup();
 }
@@ -260,6 +281,10 @@ static void runFrame(EngineContext* engineContext)
         Engine::quit();
     }
 
+    FrameAllocator::beginFrame();
+
+    StdinCommandChannel::poll(engineContext->console);
+
     engineContext->lastFrameStart = engineContext->frameStart;
     engineContext->frameStart = Clock::getTicks();
     engineContext->timeDelta = (engineContext->frameStart - engineContext->lastFrameStart).toSeconds();
@@ -38,6 +38,7 @@ class LevelManager;
 class MessageQueue;
 class OverlayRenderer;
 class EntityOverlay;
+class RenderStatsOverlay;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// A context object that holds the state for the entire engine.
@@ -77,6 +78,7 @@ struct EngineContext
 
     OverlayRenderer* overlayRenderer;
     EntityOverlay* entityOverlay;
+    RenderStatsOverlay* renderStatsOverlay;
 };
 
 void x_enginecontext_cleanup(EngineContext* context);
@@ -57,7 +57,7 @@ void EngineQueue::flush()
 
 void EngineQueue::addHandler(const char* name, bool (*handler)(EngineEvent& event, EngineContext* engineContext), int priority)
 {
-    auto eventHandler = Zone::alloc<EngineEventHandler>();
+    auto eventHandler = Zone::alloc<EngineEventHandler>(1, ZoneTag::engine);
     new (eventHandler) EngineEventHandler(name, handler, priority);
 
     if(handlerHead == nullptr || priority < handlerHead->priority)
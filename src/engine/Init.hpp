@@ -257,7 +257,9 @@ struct SystemConfig
     const char* logFile = "engine.log";
     int hunkSize = 4 * 1024 * 1024;
     int zoneSize = 1024 * 1024;
+    int frameBufferSize = 256 * 1024;
     bool enableLogging = true;
+    bool enableStdinCommands = false;      // Run lines piped into stdin as console commands
 };
 
 struct X_Config
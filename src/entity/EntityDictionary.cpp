@@ -1,81 +1,172 @@
+#include <cstdlib>
+
 #include "EntityDictionary.hpp"
 #include "geo/Vec3.hpp"
 
-template<>
-void edictParseAttribute(const char *value, bool &outValue)
+// Parses a decimal number straight to fixed point, without going through a float
+static const char* parseNumber(const char* str, fp& outValue, bool& outIsInt)
 {
-    if(strcmp(value, "true") == 0)
+    bool negative = (*str == '-');
+
+    if(negative)
+    {
+        ++str;
+    }
+
+    if(*str < '0' || *str > '9')
+    {
+        return nullptr;
+    }
+
+    int whole = 0;
+
+    while(*str >= '0' && *str <= '9')
+    {
+        whole = whole * 10 + (*str++ - '0');
+    }
+
+    int fraction = 0;
+    int scale = 1;
+
+    outIsInt = (*str != '.');
+
+    if(!outIsInt)
+    {
+        ++str;
+
+        // Digits past what 16 bits of fraction can hold are ignored
+        while(*str >= '0' && *str <= '9')
+        {
+            if(scale < 100000)
+            {
+                fraction = fraction * 10 + (*str - '0');
+                scale *= 10;
+            }
+
+            ++str;
+        }
+    }
+
+    int value = (whole << 16) + (int)(((long long)fraction << 16) / scale);
+    outValue = fp(negative ? -value : value);
+
+    return str;
+}
+
+void X_EdictAttribute::set(const char* name_, const char* value_)
+{
+    name = StringId::fromString(name_);
+    nameString = name_;
+    value = value_;
+
+    type = EDICT_VALUE_STRING;
+
+    bool isBrushModel = (value[0] == '*');
+    const char* next = (isBrushModel ? value + 1 : value);
+
+    fp components[3];
+    bool isInt;
+    int totalComponents = 0;
+
+    while(totalComponents < 3 && (next = parseNumber(next, components[totalComponents], isInt)) != nullptr)
+    {
+        ++totalComponents;
+
+        if(*next == '\0')
+        {
+            break;
+        }
+
+        while(*next == ' ')
+        {
+            ++next;
+        }
+    }
+
+    if(next == nullptr || *next != '\0')
+    {
+        return;
+    }
+
+    if(totalComponents == 1 && isInt)
+    {
+        type = (isBrushModel ? EDICT_VALUE_BRUSH_MODEL : EDICT_VALUE_INT);
+        // Integers outside the range of fp (like spawnflags) are read back from the text
+        intValue = atoi(isBrushModel ? value + 1 : value);
+    }
+    else if(totalComponents == 3 && !isBrushModel)
+    {
+        type = EDICT_VALUE_VEC3;
+        vec3Value = Vec3fp(components[0], components[1], components[2]).toX3dCoords();
+    }
+}
+
+void edictParseAttribute(const X_EdictAttribute& attribute, bool& outValue)
+{
+    if(strcmp(attribute.value, "true") == 0)
     {
         outValue = true;
     }
-    else if(strcmp(value, "false") == 0)
+    else if(strcmp(attribute.value, "false") == 0)
     {
         outValue = false;
     }
     else
     {
-        outValue = atoi(value);
+        int value;
+        edictParseAttribute(attribute, value);
+
+        outValue = value;
     }
 }
 
-template<>
-void edictParseAttribute(const char* value, int& outValue)
+void edictParseAttribute(const X_EdictAttribute& attribute, int& outValue)
 {
-    outValue = atoi(value);
+    outValue = (attribute.type == EDICT_VALUE_INT ? attribute.intValue : atoi(attribute.value));
 }
 
-template<>
-void edictParseAttribute(const char* value, BrushModelId& outValue)
+void edictParseAttribute(const X_EdictAttribute& attribute, BrushModelId& outValue)
 {
+    if(attribute.type == EDICT_VALUE_BRUSH_MODEL)
+    {
+        outValue = BrushModelId(attribute.intValue);
+        return;
+    }
+
     // Skip over '*' character
-    const char* startOfModelId = value + 1;
+    const char* startOfModelId = attribute.value + 1;
     int id = atoi(startOfModelId);
 
     outValue = BrushModelId(id);
 }
 
-void edictParseAttribute(const char* value, char* outValue)
+void edictParseAttribute(const X_EdictAttribute& attribute, char* outValue)
 {
-    strcpy(outValue, value);
+    strcpy(outValue, attribute.value);
 }
 
-template<>
-void edictParseAttribute(const char* value, Vec3fp& dest)
+void edictParseAttribute(const X_EdictAttribute& attribute, Vec3fp& dest)
 {
+    if(attribute.type == EDICT_VALUE_VEC3)
+    {
+        dest = attribute.vec3Value;
+        return;
+    }
+
     Vec3f v;
-    sscanf(value, "%f %f %f", &v.x, &v.y, &v.z);
+    sscanf(attribute.value, "%f %f %f", &v.x, &v.y, &v.z);
 
     dest = v
         .toVec3<fp>()
         .toX3dCoords();
 }
 
-X_EdictAttribute *X_Edict::getAttribute(const char *name) const
-{
-    for(int i = 0; i < totalAttributes; ++i)
-    {
-        if(strcmp(name, attributes[i].name) == 0)
-        {
-            return attributes + i;
-        }
-    }
-
-    return nullptr;
-}
-
-bool X_Edict::hasAttribute(const char *name) const
-{
-    return getAttribute(name) != nullptr;
-}
-
 void X_Edict::print()
 {
     printf("============Edict\"============\n");
 
     for(int i = 0; i < totalAttributes; ++i)
     {
-        printf("%.32s: %s\n", attributes[i].name, attributes[i].value);
+        printf("%s: %s\n", attributes[i].nameString, attributes[i].value);
     }
 }
-
-
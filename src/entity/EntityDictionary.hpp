@@ -18,9 +18,9 @@
 #include <cstring>
 
 #include "error/Error.hpp"
-
-#define X_EDICT_MAX_NAME_LENGTH 32
-#define X_EDICT_MAX_ATTRIBUTES 64
+#include "memory/Alloc.h"
+#include "memory/StringId.hpp"
+#include "geo/Vec3.hpp"
 
 struct BrushModelId
 {
@@ -39,19 +39,38 @@ struct BrushModelId
     int id;
 };
 
+// What a value looked like when it was parsed, so common types don't need to be parsed again
+enum EdictValueType
+{
+    EDICT_VALUE_STRING,
+    EDICT_VALUE_INT,            // e.g. "180"
+    EDICT_VALUE_VEC3,           // e.g. "488 -136 248", already converted to X3D coordinates
+    EDICT_VALUE_BRUSH_MODEL     // e.g. "*3"
+};
+
 struct X_EdictAttribute
 {
-    char name[X_EDICT_MAX_NAME_LENGTH];
-    char* value;
+    void set(const char* name_, const char* value_);
+
+    StringId name;
+    const char* nameString;
+    const char* value;
+
+    EdictValueType type;
+    int intValue;               // For ints and brush models
+    Vec3fp vec3Value;
 };
 
-template<typename T>
-void edictParseAttribute(const char* value, T& outValue);
+void edictParseAttribute(const X_EdictAttribute& attribute, bool& outValue);
+void edictParseAttribute(const X_EdictAttribute& attribute, int& outValue);
+void edictParseAttribute(const X_EdictAttribute& attribute, BrushModelId& outValue);
+void edictParseAttribute(const X_EdictAttribute& attribute, Vec3fp& outValue);
+void edictParseAttribute(const X_EdictAttribute& attribute, char* outValue);
 
 struct X_Edict
 {
     template<typename T>
-    bool getValueOrDefault(const char* name, T& outValue, const T& defaultValue) const
+    bool getValueOrDefault(StringId name, T& outValue, const T& defaultValue) const
     {
 
         if(getValue(name, outValue))
@@ -64,7 +83,7 @@ struct X_Edict
         return false;
     }
 
-    bool getValueOrDefault(const char* name, char* outValue, const char* defaultValue) const
+    bool getValueOrDefault(StringId name, char* outValue, const char* defaultValue) const
     {
         if(!getValue(name, outValue))
         {
@@ -77,16 +96,25 @@ struct X_Edict
     }
 
     template<typename T>
-    void getRequiredValue(const char* name, T& outValue) const
+    void getRequiredValue(StringId name, T& outValue) const
     {
         if(!getValue(name, outValue))
         {
-            x_system_error("Missing required value: %s.", name);
+            const char* nameString = name.getOriginalString();
+
+            if(nameString != nullptr)
+            {
+                x_system_error("Missing required value: %s.", nameString);
+            }
+            else
+            {
+                x_system_error("Missing required value (id %u).", (unsigned int)name);
+            }
         }
     }
 
     template<typename T>
-    bool getValue(const char *name, T &outValue) const
+    bool getValue(StringId name, T& outValue) const
     {
         X_EdictAttribute* attribute = getAttribute(name);
 
@@ -96,7 +124,7 @@ struct X_Edict
         }
         else
         {
-            edictParseAttribute(attribute->value, outValue);
+            edictParseAttribute(*attribute, outValue);
 
             return true;
         }
@@ -104,10 +132,63 @@ struct X_Edict
 
     void print();
 
-    X_EdictAttribute* getAttribute(const char* name) const;
-    bool hasAttribute(const char* name) const;
+    X_EdictAttribute* getAttribute(StringId name) const
+    {
+        for(int i = 0; i < totalAttributes; ++i)
+        {
+            if(attributes[i].name == name)
+            {
+                return attributes + i;
+            }
+        }
 
-    mutable X_EdictAttribute attributes[X_EDICT_MAX_ATTRIBUTES];
+        return nullptr;
+    }
+
+    bool hasAttribute(StringId name) const
+    {
+        return getAttribute(name) != nullptr;
+    }
+
+    X_EdictAttribute* attributes;
     int totalAttributes;
 };
 
+// Every edict in an entity lump, parsed into one block: the edicts, then all of their attributes,
+// then the names and values
+class EntityDictionary
+{
+public:
+    EntityDictionary()
+        : edicts(nullptr),
+        totalEdicts(0)
+    {
+
+    }
+
+    ~EntityDictionary()
+    {
+        x_free(edicts);
+    }
+
+    void parse(const char* entityLump);
+
+    X_Edict* begin() const
+    {
+        return edicts;
+    }
+
+    X_Edict* end() const
+    {
+        return edicts + totalEdicts;
+    }
+
+    int size() const
+    {
+        return totalEdicts;
+    }
+
+private:
+    X_Edict* edicts;
+    int totalEdicts;
+};
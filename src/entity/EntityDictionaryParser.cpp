@@ -18,43 +18,129 @@
 
 #include "geo/Vec3.hpp"
 #include "EntityDictionary.hpp"
+#include "memory/Alloc.h"
 
-const char* parseEdict(const char* nextEntry, char* valueData, X_Edict* dest)
+struct EntityLumpSize
 {
-    if(*nextEntry != '{')
-        return nullptr;
+    int totalEdicts;
+    int totalAttributes;
+    int totalStringBytes;
+};
 
-    nextEntry += 2;         // Skip quote and newline
+static const char* skipWhitespace(const char* str)
+{
+    while(*str == ' ' || *str == '\t' || *str == '\n' || *str == '\r')
+    {
+        ++str;
+    }
 
-    dest->totalAttributes = 0;
+    return str;
+}
 
-    while(*nextEntry && *nextEntry != '}')
+static const char* readQuotedString(const char* str, const char*& outStart, int& outLength)
+{
+    if(*str != '"')
     {
-        X_EdictAttribute* att = dest->attributes + dest->totalAttributes++;
-        char* name = att->name;
+        x_system_error("Expected '\"' in entity dictionary, found '%c'", *str);
+    }
 
-        ++nextEntry;        // Skip quote
+    outStart = ++str;
 
-        do
+    while(*str != '"')
+    {
+        if(*str == '\0')
         {
-            *name++ = *nextEntry++;
-        } while(*nextEntry != '"');
+            x_system_error("Unterminated '\"' in entity dictionary");
+        }
+
+        ++str;
+    }
 
-        *name = '\0';
+    outLength = str - outStart;
 
-        nextEntry += 3;     // Skip [" "]
+    return str + 1;
+}
+
+static char* copyString(const char* str, int length, char* dest)
+{
+    memcpy(dest, str, length);
+    dest[length] = '\0';
+
+    return dest;
+}
 
-        att->value = valueData;
+// Walks the whole lump. The first pass only measures it (edicts is null), the second fills in the block.
+static void parseEntityLump(const char* lump, EntityLumpSize& size, X_Edict* edicts, X_EdictAttribute* attributes, char* strings)
+{
+    size.totalEdicts = 0;
+    size.totalAttributes = 0;
+    size.totalStringBytes = 0;
+
+    const char* next = skipWhitespace(lump);
+
+    while(*next == '{')
+    {
+        X_Edict* edict = nullptr;
 
-        do
+        if(edicts != nullptr)
         {
-            *valueData++ = *nextEntry++;
-        } while(*nextEntry != '"');
+            edict = edicts + size.totalEdicts;
+            edict->attributes = attributes + size.totalAttributes;
+            edict->totalAttributes = 0;
+        }
 
-        nextEntry += 2;     // Skip quote and newline
-        *valueData++ = '\0';
+        next = skipWhitespace(next + 1);
+
+        while(*next != '}')
+        {
+            const char* name;
+            const char* value;
+            int nameLength;
+            int valueLength;
+
+            next = readQuotedString(next, name, nameLength);
+            next = readQuotedString(skipWhitespace(next), value, valueLength);
+            next = skipWhitespace(next);
+
+            if(edict != nullptr)
+            {
+                char* nameCopy = copyString(name, nameLength, strings + size.totalStringBytes);
+                char* valueCopy = copyString(value, valueLength, nameCopy + nameLength + 1);
+
+                edict->attributes[edict->totalAttributes++].set(nameCopy, valueCopy);
+            }
+
+            ++size.totalAttributes;
+            size.totalStringBytes += nameLength + valueLength + 2;
+        }
+
+        ++size.totalEdicts;
+        next = skipWhitespace(next + 1);
     }
 
-    return nextEntry + 2;   // Skip '}' and newline
+    if(*next != '\0')
+    {
+        x_system_error("Unexpected '%c' in entity dictionary", *next);
+    }
 }
 
+void EntityDictionary::parse(const char* entityLump)
+{
+    EntityLumpSize size;
+    parseEntityLump(entityLump, size, nullptr, nullptr, nullptr);
+
+    x_free(edicts);
+
+    int edictsSize = sizeof(X_Edict) * size.totalEdicts;
+    int attributesSize = sizeof(X_EdictAttribute) * size.totalAttributes;
+
+    unsigned char* block = (unsigned char*)x_malloc(edictsSize + attributesSize + size.totalStringBytes);
+
+    edicts = (X_Edict*)block;
+    totalEdicts = size.totalEdicts;
+
+    X_EdictAttribute* attributes = (X_EdictAttribute*)(block + edictsSize);
+    char* strings = (char*)(block + edictsSize + attributesSize);
+
+    parseEntityLump(entityLump, size, edicts, attributes, strings);
+}
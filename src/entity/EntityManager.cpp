@@ -16,7 +16,6 @@
 #include "entity/builtin/DoorEntity.hpp"
 #include "EntityManager.hpp"
 #include "EntityDictionary.hpp"
-#include "EntityDictionaryParser.hpp"
 #include "builtin/WorldEntity.hpp"
 #include "builtin/TriggerEntity.hpp"
 #include "EntityBuilder.hpp"
@@ -29,6 +28,7 @@ Entity* EntityManager::createEntityFromEdict(X_Edict& edict, BspLevel& level)
     Entity* entity = tryCreateEntity(edict, level);
     if(!entity)
     {
+        Log::error("No such entity type: %s", edict.getAttribute("classname"_sid)->value);
         return nullptr;
     }
 
@@ -39,7 +39,7 @@ Entity* EntityManager::createEntityFromEdict(X_Edict& edict, BspLevel& level)
 
 Entity* EntityManager::tryCreateEntity(X_Edict &edict, BspLevel &level)
 {
-    X_EdictAttribute* classname = edict.getAttribute("classname");
+    X_EdictAttribute* classname = edict.getAttribute("classname"_sid);
     if(classname == nullptr)
     {
         x_system_error("Edict missing classname");
@@ -63,21 +63,31 @@ Entity* EntityManager::tryCreateEntity(X_Edict &edict, BspLevel &level)
         }
     }
 
-    Log::error("No such entity type: %s", classname->value);
-
     return nullptr;
 }
 
 void EntityManager::createEntitesInLevel(BspLevel& level)
 {
-    const char* nextEntry = level.entityDictionary;
-    char valueData[4096];
-    X_Edict edict;
+    EntityDictionary dictionary;
+    dictionary.parse(level.entityDictionary);
 
-    while((nextEntry = parseEdict(nextEntry, valueData, &edict)) != nullptr)
+    // Most of a level's entities (lights, etc.) have no type, so they're reported all at once
+    int totalSkipped = 0;
+
+    for(X_Edict& edict : dictionary)
     {
-        createEntityFromEdict(edict, level);
+        Entity* entity = tryCreateEntity(edict, level);
+
+        if(entity == nullptr)
+        {
+            ++totalSkipped;
+            continue;
+        }
+
+        registerEntity(entity);
     }
+
+    Log::info("Spawned %d of %d entities (the rest have no registered type)", dictionary.size() - totalSkipped, dictionary.size());
 }
 
 void EntityManager::destroyEntity(Entity* entity)
@@ -147,11 +157,21 @@ static bool splitKeyValuePair(const char* str, XString& outKey, XString& outValu
 
 void EntityManager::cmdEntitySpawn(EngineContext* engineContext, int argc, char** argv)
 {
+    const int MAX_ATTRIBUTES = 16;
+
+    if(argc - 1 > MAX_ATTRIBUTES)
+    {
+        x_console_printf(engineContext->console, "Too many key value pairs (max is %d)\n", MAX_ATTRIBUTES);
+        return;
+    }
+
+    X_EdictAttribute attributes[MAX_ATTRIBUTES];
     X_Edict edict;
+    edict.attributes = attributes;
     edict.totalAttributes = argc - 1;
 
-    XString keys[16];
-    XString values[16];
+    XString keys[MAX_ATTRIBUTES];
+    XString values[MAX_ATTRIBUTES];
 
     for(int i = 1; i < argc; ++i)
     {
@@ -160,10 +180,7 @@ void EntityManager::cmdEntitySpawn(EngineContext* engineContext, int argc, char*
             x_console_printf(engineContext->console, "Invalid key value pair\n");
         }
 
-        X_EdictAttribute* attribute = &edict.attributes[i - 1];
-
-        strcpy(attribute->name, keys[i - 1].c_str());
-        attribute->value = (char *)values[i - 1].c_str();
+        attributes[i - 1].set(keys[i - 1].c_str(), values[i - 1].c_str());
     }
 
     BspLevel* level = engineContext->levelManager->getCurrentLevel();
@@ -20,6 +20,7 @@
 #include "engine/GlobalConfiguration.hpp"
 #include "system/IEntitySystem.hpp"
 #include "memory/FixedSizeArray.hpp"
+#include "error/Log.hpp"
 
 struct X_Edict;
 
@@ -44,7 +45,7 @@ public:
         entities.pushBack(entity);
 
         entity->id = entities.size() - 1;
-        printf("New id: %d\n", entity->id);
+        x_log_debug("New id: %d", entity->id);
     }
 
     void unregisterEntity(Entity* entity)
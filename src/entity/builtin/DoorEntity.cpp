@@ -111,7 +111,7 @@ Entity* DoorEntity::build(EntityBuilder& builder)
     x_console_register_cmd(receiver->console, "door", door);
 
     int angle;
-    builder.edict.getValueOrDefault("angle", angle, -1);
+    builder.edict.getValueOrDefault("angle"_sid, angle, -1);
 
     builder.edict.print();
 
@@ -18,13 +18,15 @@
 #include "entity/EntityDictionary.hpp"
 #include "entity/EntityBuilder.hpp"
 
+constexpr StringId TriggerEntityEvent::Name;
+
 BrushModelPhysicsComponent::BrushModelPhysicsComponent(const EntityBuilder& builder)
     : PhysicsComponent(PhysicsComponentType::brushModel)
 {
     const BrushModelId MISSING_MODEL(-1);
 
     BrushModelId id;
-    builder.edict.getValueOrDefault("model", id, MISSING_MODEL);
+    builder.edict.getValueOrDefault("model"_sid, id, MISSING_MODEL);
 
     model = id.id != MISSING_MODEL.id
             ? x_bsplevel_get_model(builder.level, id.id)
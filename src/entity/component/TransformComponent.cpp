@@ -20,6 +20,6 @@
 
 TransformComponent::TransformComponent(const X_Edict& edict)
 {
-    edict.getValueOrDefault("origin", position, Vec3fp(0, 0, 0));
+    edict.getValueOrDefault("origin"_sid, position, Vec3fp(0, 0, 0));
 }
 
@@ -51,6 +51,8 @@ void __attribute__((noreturn)) x_system_error(const char* format, ...)
 #endif
     
     va_end(list);
+
+    Log::flush();
     printStackTrace();
     exit(-1);
 }
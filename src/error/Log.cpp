@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include "engine/Config.hpp"
 #include "system/File.hpp"
@@ -23,6 +24,16 @@
 #include "error/Error.hpp"
 #include "engine/Init.hpp"
 
+#if X_ENABLE_ASYNC_LOG
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "memory/LockFreeQueue.hpp"
+
+#endif
+
 #if X_ENABLE_COLOR_LOG
 
 #define ANSI_COLOR_RED     "\x1b[1;31m"
@@ -37,6 +48,7 @@
 
 #define ANSI_COLOR_GREEN
 #define ANSI_COLOR_RED
+#define ANSI_COLOR_CYAN
 #define ANSI_COLOR_RESET
 
 #endif
@@ -44,9 +56,133 @@
 static FILE* logFile;
 static bool enableSafeLogging = 1;
 
+#if X_ENABLE_ASYNC_LOG
+
+struct LogRecord
+{
+    LogLevel level;
+    bool isSub;
+    char text[256];
+};
+
+static const int LOG_QUEUE_SIZE = 1024;
+static const int FLUSH_MAX_SPINS = 100000;
+
+static LockFreeQueue<LogRecord, LOG_QUEUE_SIZE> logQueue;
+
+static std::thread writerThread;
+static std::atomic<bool> writerRunning(false);
+static std::atomic<int> totalDroppedMessages(0);
+static std::atomic<int> totalReportedDroppedMessages(0);
+
+#endif
+
+static void get_prefix(LogLevel level, bool isSub, const char** screenPrefix, const char** filePrefix)
+{
+    if(isSub)
+    {
+        *screenPrefix = "\t- ";
+        *filePrefix = "\t- ";
+
+        return;
+    }
+
+    switch(level)
+    {
+        case LogLevel::debug:
+            *screenPrefix = ANSI_COLOR_CYAN "[DBG ]" ANSI_COLOR_RESET " ";
+            *filePrefix = "[DBG] ";
+            break;
+
+        case LogLevel::error:
+            *screenPrefix = ANSI_COLOR_RED "[ERR ]" ANSI_COLOR_RESET " ";
+            *filePrefix = "[ERR] ";
+            break;
+
+        case LogLevel::info:
+        default:
+            *screenPrefix = ANSI_COLOR_GREEN "[INFO]" ANSI_COLOR_RESET " ";
+            *filePrefix = "[INFO] ";
+            break;
+    }
+}
+
+static void write_line(LogLevel level, bool isSub, const char* text)
+{
+    const char* screenPrefix;
+    const char* filePrefix;
+    get_prefix(level, isSub, &screenPrefix, &filePrefix);
+
+    printf("%s%s\n", screenPrefix, text);
+
+    if(logFile)
+    {
+        fprintf(logFile, "%s%s\n", filePrefix, text);
+    }
+}
+
+#if X_ENABLE_ASYNC_LOG
+
+static bool drain_log_queue()
+{
+    bool wroteRecord = false;
+
+    while(logQueue.tryDequeue([](const LogRecord& record) { write_line(record.level, record.isSub, record.text); }))
+    {
+        wroteRecord = true;
+    }
+
+    int totalDropped = totalDroppedMessages.load(std::memory_order_relaxed);
+    int totalReported = totalReportedDroppedMessages.exchange(totalDropped, std::memory_order_relaxed);
+
+    if(totalDropped != totalReported)
+    {
+        char text[64];
+        snprintf(text, sizeof(text), "Log queue full, dropped %d messages", totalDropped - totalReported);
+        write_line(LogLevel::error, false, text);
+    }
+
+    return wroteRecord;
+}
+
+static void writer_thread_main()
+{
+    while(writerRunning.load(std::memory_order_acquire))
+    {
+        if(!drain_log_queue())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    drain_log_queue();
+}
+
+// Also run at exit, since a std::thread that's still joinable when it's destroyed aborts the program
+static void stop_writer_thread()
+{
+    if(writerThread.joinable())
+    {
+        writerRunning.store(false, std::memory_order_release);
+        writerThread.join();
+    }
+
+    // Anything logged after this point is written directly
+    enableSafeLogging = 1;
+}
+
+#endif
+
 void x_log_cleanup(void)
 {
+#if X_ENABLE_ASYNC_LOG
+    stop_writer_thread();
+#endif
+
+    enableSafeLogging = 1;
+
     fclose(logFile);
+    logFile = nullptr;
 }
 
 static void get_log_file_name(char* dest)
@@ -73,85 +209,146 @@ void x_log_init()
     }
 
     enableSafeLogging = 0;
+
+#if X_ENABLE_ASYNC_LOG
+    writerRunning.store(true, std::memory_order_release);
+    writerThread = std::thread(writer_thread_main);
+
+    atexit(stop_writer_thread);
+#endif
 }
 
-static void flush_log_to_file(void)
+void Log::debug(const char* format, ...)
 {
-    // x_file_close(&logFile);
-    
-    // char logFileName[X_FILENAME_MAX_LENGTH];
-    // get_log_file_name(logFileName);
-    
-    // x_file_open_append(&logFile, logFileName);
+    if(!levelIsEnabled(LogLevel::debug))
+    {
+        return;
+    }
+
+    va_list list;
+    va_start(list, format);
+    writeToLog(LogLevel::debug, false, format, list);
+    va_end(list);
 }
 
 void Log::info(const char* format, ...)
 {
-    const char* infoMessageColored = ANSI_COLOR_GREEN "[INFO]" ANSI_COLOR_RESET " ";
-    const char* infoMessage = "[INFO] ";
-
-    writeToLog(infoMessageColored, infoMessage);
+    if(!levelIsEnabled(LogLevel::info))
+    {
+        return;
+    }
 
     va_list list;
     va_start(list, format);
-    writeToLog(format, list);
-
-    writeToLog('\n');
-
+    writeToLog(LogLevel::info, false, format, list);
     va_end(list);
 }
 
 void Log::error(const char* format, ...)
 {
-    const char* infoMessageColored = ANSI_COLOR_RED "[ERR ]" ANSI_COLOR_RESET " ";
-    const char* infoMessage = "[ERR] ";
-
-    writeToLog(infoMessageColored, infoMessage);
+    if(!levelIsEnabled(LogLevel::error))
+    {
+        return;
+    }
 
     va_list list;
     va_start(list, format);
-    writeToLog(format, list);
-
-    writeToLog('\n');
-
+    writeToLog(LogLevel::error, false, format, list);
     va_end(list);
 }
 
 void Log::logSub(const char* format, ...)
 {
-    const char* subText = "\t- ";
-    writeToLog(subText, subText);
+    if(!levelIsEnabled(LogLevel::info))
+    {
+        return;
+    }
 
     va_list list;
     va_start(list, format);
-    writeToLog(format, list);
-
-    writeToLog('\n');
-
+    writeToLog(LogLevel::info, true, format, list);
     va_end(list);
 }
 
-void Log::writeToLog(const char* screenText, const char* fileText)
+void Log::writeToLog(LogLevel level, bool isSub, const char* format, va_list list)
 {
-    fputs(screenText, stdout);
-    fputs(fileText, logFile);
-}
+#if X_ENABLE_ASYNC_LOG
+    // Errors usually come right before we go down, so they skip the queue (after everything
+    // logged before them has been written out) and can't be truncated or dropped
+    if(!enableSafeLogging && level != LogLevel::error)
+    {
+        bool enqueued = logQueue.tryEnqueue([&](LogRecord& record)
+        {
+            va_list recordList;
+            va_copy(recordList, list);
+
+            record.level = level;
+            record.isSub = isSub;
+            vsnprintf(record.text, sizeof(record.text), format, recordList);
+
+            va_end(recordList);
+        });
+
+        if(!enqueued)
+        {
+            totalDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return;
+    }
+
+    flush();
+#endif
+
+    const char* screenPrefix;
+    const char* filePrefix;
+    get_prefix(level, isSub, &screenPrefix, &filePrefix);
 
-void Log::writeToLog(const char* format, va_list list)
-{
     va_list fileList;
     va_copy(fileList, list);
 
+    fputs(screenPrefix, stdout);
     vprintf(format, list);
-    vfprintf(logFile, format, fileList);
+    fputc('\n', stdout);
+
+    if(logFile)
+    {
+        fputs(filePrefix, logFile);
+        vfprintf(logFile, format, fileList);
+        fputc('\n', logFile);
+    }
 
     va_end(fileList);
 }
 
-void Log::writeToLog(char c)
+void Log::flush()
+{
+#if X_ENABLE_ASYNC_LOG
+    // Bounded so a thread that died halfway through enqueuing a message can't hang us
+    for(int i = 0; i < FLUSH_MAX_SPINS && !logQueue.isEmpty(); ++i)
+    {
+        if(!drain_log_queue())
+        {
+            std::this_thread::yield();
+        }
+    }
+#endif
+
+    fflush(stdout);
+
+    if(logFile)
+    {
+        fflush(logFile);
+    }
+}
+
+int Log::getTotalDroppedMessages()
 {
-    fputc(c, stdout);
-    fputc(c, logFile);
+#if X_ENABLE_ASYNC_LOG
+    return totalDroppedMessages.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
 }
 
 // TODO: take parameters into account
@@ -160,3 +357,8 @@ void Log::init(const char* logFile, bool enableLogging)
     x_log_init();
 }
 
+void Log::cleanup()
+{
+    x_log_cleanup();
+}
+
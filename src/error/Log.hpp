@@ -17,28 +17,70 @@
 
 #include <cstdarg>
 
+#define X_LOG_LEVEL_DEBUG 0
+#define X_LOG_LEVEL_INFO 1
+#define X_LOG_LEVEL_ERROR 2
+#define X_LOG_LEVEL_NONE 3
+
+// Messages below this level are compiled out entirely (override with -DX_LOG_MIN_LEVEL=...)
+#ifndef X_LOG_MIN_LEVEL
+#define X_LOG_MIN_LEVEL X_LOG_LEVEL_INFO
+#endif
+
 struct LogConfig;
 
+enum class LogLevel
+{
+    debug = X_LOG_LEVEL_DEBUG,
+    info = X_LOG_LEVEL_INFO,
+    error = X_LOG_LEVEL_ERROR
+};
+
 class Log
 {
 public:
     static void init(const char* logFile, bool enableLogging);
     static void cleanup();
 
+    static void debug(const char* format, ...) __attribute__ ((format (printf, 1, 2)));
     static void info(const char* format, ...) __attribute__ ((format (printf, 1, 2)));
     static void error(const char* format, ...) __attribute__ ((format (printf, 1, 2)));
     static void logSub(const char* format, ...) __attribute__ ((format (printf, 1, 2)));
 
+    // Blocks until every queued message has been written out. Safe to call from a crash handler.
+    static void flush();
+
+    static int getTotalDroppedMessages();
+
+    static constexpr bool levelIsEnabled(LogLevel level)
+    {
+        return (int)level >= X_LOG_MIN_LEVEL;
+    }
+
 private:
-    static void writeToLog(const char* format, va_list list);
-    static void writeToLog(const char* screenText, const char* fileText);
-    static void writeToLog(char c);
+    static void writeToLog(LogLevel level, bool isSub, const char* format, va_list list);
 };
 
 void x_log_init(void);
 void x_log_cleanup(void);
 
 // Here for backwards compatibility
+#if X_LOG_MIN_LEVEL <= X_LOG_LEVEL_INFO
 #define x_log(_args...) Log::info(_args)
+#else
+#define x_log(_args...) ((void)0)
+#endif
+
+#if X_LOG_MIN_LEVEL <= X_LOG_LEVEL_ERROR
 #define x_log_error(_args...) Log::error(_args)
+#else
+#define x_log_error(_args...) ((void)0)
+#endif
+
+// Use this in hot paths: the arguments aren't even evaluated unless debug logging is compiled in
+#if X_LOG_MIN_LEVEL <= X_LOG_LEVEL_DEBUG
+#define x_log_debug(_args...) Log::debug(_args)
+#else
+#define x_log_debug(_args...) ((void)0)
+#endif
 
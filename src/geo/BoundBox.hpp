@@ -50,7 +50,7 @@ struct BoundBoxTemplate
         v[1].z = minValue<T>();
     }
 
-    BoundBoxTemplate(const Vec3Template<T>& mins, const Vec3Template<fp>& maxs)
+    BoundBoxTemplate(const Vec3Template<T>& mins, const Vec3Template<T>& maxs)
         : v({ mins, maxs })
     {
 
@@ -0,0 +1,137 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+
+#include "BoundBoxArray.hpp"
+#include "Frustum.hpp"
+#include "memory/Alloc.h"
+#include "error/Error.hpp"
+#include "math/FixedPointSimd.hpp"
+
+void BoundBoxArray::init(int totalBoxes_)
+{
+    totalBoxes = totalBoxes_;
+    paddedTotalBoxes = (totalBoxes + 3) & ~3;
+
+    int* components = (int*)x_malloc(paddedTotalBoxes * 6 * sizeof(int));
+    memset(components, 0, paddedTotalBoxes * 6 * sizeof(int));
+
+    minX = components + paddedTotalBoxes * 0;
+    minY = components + paddedTotalBoxes * 1;
+    minZ = components + paddedTotalBoxes * 2;
+    maxX = components + paddedTotalBoxes * 3;
+    maxY = components + paddedTotalBoxes * 4;
+    maxZ = components + paddedTotalBoxes * 5;
+
+    outsidePlanes = (unsigned char*)x_malloc(paddedTotalBoxes * 2);
+    intersectPlanes = outsidePlanes + paddedTotalBoxes;
+}
+
+void BoundBoxArray::cleanup()
+{
+    x_free(minX);
+    x_free(outsidePlanes);
+}
+
+void BoundBoxArray::setBox(int id, const BoundBox& box)
+{
+    minX[id] = box.v[0].x;
+    minY[id] = box.v[0].y;
+    minZ[id] = box.v[0].z;
+
+    maxX[id] = box.v[1].x;
+    maxY[id] = box.v[1].y;
+    maxZ[id] = box.v[1].z;
+}
+
+void BoundBoxArray::classifyAgainstFrustum(const X_Frustum& frustum)
+{
+    x_assert(frustum.totalPlanes <= MAX_PLANES, "Too many frustum planes");
+
+    memset(outsidePlanes, 0, paddedTotalBoxes * 2);
+
+    for(int i = 0; i < frustum.totalPlanes; ++i)
+    {
+        classifyAgainstPlane(frustum.planes[i], i);
+    }
+}
+
+#if defined(__SSE2__)
+
+static inline __m128i distance_to_plane_sse2(const Plane& plane, const int* x, const int* y, const int* z)
+{
+    __m128i dist = x_fp_mul_4(_mm_loadu_si128((const __m128i*)x), _mm_set1_epi32(plane.normal.x.internalValue()));
+    dist = _mm_add_epi32(dist, x_fp_mul_4(_mm_loadu_si128((const __m128i*)y), _mm_set1_epi32(plane.normal.y.internalValue())));
+    dist = _mm_add_epi32(dist, x_fp_mul_4(_mm_loadu_si128((const __m128i*)z), _mm_set1_epi32(plane.normal.z.internalValue())));
+
+    return _mm_add_epi32(dist, _mm_set1_epi32(plane.d.internalValue()));
+}
+
+#endif
+
+// Same test as BoundBox::determinePlaneClipFlags(): the corner furthest along the normal decides
+// if the box is outside, and the opposite corner decides if it's inside.
+void BoundBoxArray::classifyAgainstPlane(const Plane& plane, int planeId)
+{
+    const int* furthestX = (plane.normal.x > 0 ? maxX : minX);
+    const int* furthestY = (plane.normal.y > 0 ? maxY : minY);
+    const int* furthestZ = (plane.normal.z > 0 ? maxZ : minZ);
+
+    const int* closestX = (plane.normal.x > 0 ? minX : maxX);
+    const int* closestY = (plane.normal.y > 0 ? minY : maxY);
+    const int* closestZ = (plane.normal.z > 0 ? minZ : maxZ);
+
+    unsigned char planeBit = 1 << planeId;
+
+#if defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+
+    for(int i = 0; i < paddedTotalBoxes; i += 4)
+    {
+        __m128i furthestDist = distance_to_plane_sse2(plane, furthestX + i, furthestY + i, furthestZ + i);
+        __m128i closestDist = distance_to_plane_sse2(plane, closestX + i, closestY + i, closestZ + i);
+
+        int furthestInFront = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(furthestDist, zero)));
+        int closestInFront = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(closestDist, zero)));
+
+        for(int j = 0; j < 4; ++j)
+        {
+            int laneBit = 1 << j;
+
+            if((furthestInFront & laneBit) == 0)
+            {
+                outsidePlanes[i + j] |= planeBit;
+            }
+            else if((closestInFront & laneBit) == 0)
+            {
+                intersectPlanes[i + j] |= planeBit;
+            }
+        }
+    }
+#else
+    for(int i = 0; i < totalBoxes; ++i)
+    {
+        if(!plane.pointOnNormalFacingSide(Vec3fp(fp(furthestX[i]), fp(furthestY[i]), fp(furthestZ[i]))))
+        {
+            outsidePlanes[i] |= planeBit;
+        }
+        else if(!plane.pointOnNormalFacingSide(Vec3fp(fp(closestX[i]), fp(closestY[i]), fp(closestZ[i]))))
+        {
+            intersectPlanes[i] |= planeBit;
+        }
+    }
+#endif
+}
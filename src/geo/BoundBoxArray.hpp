@@ -0,0 +1,70 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "BoundBox.hpp"
+
+struct X_Frustum;
+
+// Bound boxes stored one component per array, so they can be classified against the frustum
+// several at a time. classifyAgainstFrustum() tests every box against every plane up front;
+// getFrustumClipFlags() then gives the same answer BoundBox::determineFrustumClipFlags() would.
+class BoundBoxArray
+{
+public:
+    void init(int totalBoxes_);
+    void cleanup();
+
+    void setBox(int id, const BoundBox& box);
+
+    void classifyAgainstFrustum(const X_Frustum& frustum);
+
+    BoundBoxFrustumFlags getFrustumClipFlags(int id, BoundBoxFrustumFlags parentFlags) const
+    {
+        if(parentFlags == X_BOUNDBOX_TOTALLY_INSIDE_FRUSTUM)
+        {
+            return X_BOUNDBOX_TOTALLY_INSIDE_FRUSTUM;
+        }
+
+        if(outsidePlanes[id] & parentFlags)
+        {
+            return X_BOUNDBOX_TOTALLY_OUTSIDE_FRUSTUM;
+        }
+
+        return (BoundBoxFrustumFlags)(intersectPlanes[id] & parentFlags);
+    }
+
+    static const int MAX_PLANES = 8;
+
+private:
+    void classifyAgainstPlane(const Plane& plane, int planeId);
+
+    // Padded to a multiple of 4 so the SIMD path never needs a remainder loop
+    int* minX;
+    int* minY;
+    int* minZ;
+    int* maxX;
+    int* maxY;
+    int* maxZ;
+
+    // Bit i is set if the box is outside/intersects plane i
+    unsigned char* outsidePlanes;
+    unsigned char* intersectPlanes;
+
+    int totalBoxes;
+    int paddedTotalBoxes;
+};
+
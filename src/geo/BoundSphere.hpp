@@ -19,6 +19,8 @@
 
 struct BoundSphere
 {
+    BoundSphere() { }
+
     BoundSphere(const Vec3fp& center, fp radius)
     {
         this->center = center;
@@ -104,6 +104,9 @@ void Ray3::render(const X_RenderContext& renderContext, X_Color color) const
         // FIXME
         projected[i].x = projected[i].x >> 16;
         projected[i].y = projected[i].y >> 16;
+
+        // Rounding can put an end just outside the view, and the canvas only clamps to the screen
+        renderContext.cam->viewport.clamp(projected[i]);
     }
 
     renderContext.canvas->drawLine(projected[0], projected[1], color);
@@ -140,6 +143,8 @@ void Ray3::renderShaded(const X_RenderContext& renderContext, X_Color color, fp
         // FIXME
         projected[i].x = projected[i].x >> 16;
         projected[i].y = projected[i].y >> 16;
+
+        renderContext.cam->viewport.clamp(projected[i]);
     }
 
     renderContext.canvas->drawLineShaded(projected[0], projected[1], color, intensity[0], intensity[1], renderContext.renderer->colorMap);
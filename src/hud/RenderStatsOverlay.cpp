@@ -0,0 +1,47 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#include <cstdio>
+
+#include "RenderStatsOverlay.hpp"
+#include "render/Screen.hpp"
+#include "render/Font.hpp"
+#include "render/RenderStats.hpp"
+
+void RenderStatsOverlay::render()
+{
+    const int LINE_LENGTH = 32;
+
+    int x = screen->getW() - LINE_LENGTH * font->getW();
+    int y = 0;
+
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        RenderCounter counter = (RenderCounter)i;
+        char line[LINE_LENGTH + 1];
+
+        if(RenderStats::getCapacity(counter) != 0)
+        {
+            snprintf(line, sizeof(line), "%-18s %d/%d", RenderStats::getName(counter), RenderStats::getValue(counter), RenderStats::getCapacity(counter));
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "%-18s %d", RenderStats::getName(counter), RenderStats::getValue(counter));
+        }
+
+        screen->canvas.drawStr(line, *font, { x, y });
+        y += font->getH();
+    }
+}
+
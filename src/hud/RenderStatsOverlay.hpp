@@ -12,9 +12,26 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
-
 #pragma once
 
-class X_Edict;
+#include "OverlayRenderer.hpp"
+
+class Font;
+
+// Shows the last frame's render counters in the top right corner of the screen
+class RenderStatsOverlay : public Overlay
+{
+public:
+    RenderStatsOverlay(const char* name, Screen* screen, const Font* font_)
+        : Overlay(name, screen),
+        font(font_)
+    {
+
+    }
+
+    void render();
+
+private:
+    const Font* font;
+};
 
-const char* parseEdict(const char* nextEntry, char* valueData, X_Edict* dest);
\ No newline at end of file
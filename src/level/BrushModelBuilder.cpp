@@ -55,19 +55,19 @@ void BrushModelBuilder::build()
 void BrushModelBuilder::allocateMemory()
 {
     int totalVertices = options.sidesInBase * 2;
-    dest.vertices = Zone::alloc<BspVertex>(totalVertices);
+    dest.vertices = Zone::alloc<BspVertex>(totalVertices, ZoneTag::level);
     
     int totalEdges = options.sidesInBase * 3 + 1;   // Need an extra edge for edge 0
-    dest.edges = Zone::alloc<BspEdge>(totalEdges);
-    dest.surfaceEdgeIds = Zone::alloc<int>(options.sidesInBase * 2 + 4 * options.sidesInBase);
+    dest.edges = Zone::alloc<BspEdge>(totalEdges, ZoneTag::level);
+    dest.surfaceEdgeIds = Zone::alloc<int>(options.sidesInBase * 2 + 4 * options.sidesInBase, ZoneTag::level);
     
-    dest.faces = Zone::alloc<BspSurface>(totalSurfaces);
-    dest.planes = Zone::alloc<BspPlane>(totalSurfaces);
+    dest.faces = Zone::alloc<BspSurface>(totalSurfaces, ZoneTag::level);
+    dest.planes = Zone::alloc<BspPlane>(totalSurfaces, ZoneTag::level);
     
-    nodes = Zone::alloc<BspNode>(totalSurfaces);
-    leaf = Zone::alloc<BspLeaf>();
+    nodes = Zone::alloc<BspNode>(totalSurfaces, ZoneTag::level);
+    leaf = Zone::alloc<BspLeaf>(1, ZoneTag::level);
     
-    markSurfaces = Zone::alloc<BspSurface*>(totalSurfaces);
+    markSurfaces = Zone::alloc<BspSurface*>(totalSurfaces, ZoneTag::level);
 }
 
 void BrushModelBuilder::buildGeometry()
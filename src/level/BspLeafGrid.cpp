@@ -0,0 +1,144 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#include "BspLeafGrid.hpp"
+#include "level/BspLevel.hpp"
+#include "memory/Alloc.h"
+
+void BspLeafGrid::init(BspLevel& level)
+{
+    rootNode = &level.getLevelRootNode();
+    nodes = level.nodes;
+    leaves = level.leaves;
+
+    const BoundBox& levelBox = rootNode->nodeBoundBox;
+    Vec3 levelSize = levelBox.v[1] - levelBox.v[0];
+
+    origin = levelBox.v[0];
+
+    // Use the smallest power of 2 cell size that keeps the grid under MAX_CELLS
+    for(cellShift = MIN_CELL_SHIFT; ; ++cellShift)
+    {
+        totalCells[0] = (levelSize.x >> (16 + cellShift)) + 1;
+        totalCells[1] = (levelSize.y >> (16 + cellShift)) + 1;
+        totalCells[2] = (levelSize.z >> (16 + cellShift)) + 1;
+
+        if(totalCells[0] * totalCells[1] * totalCells[2] <= MAX_CELLS)
+        {
+            break;
+        }
+    }
+
+    cells = (short*)x_malloc(totalCells[0] * totalCells[1] * totalCells[2] * sizeof(short));
+
+    int cellSize = 1 << (16 + cellShift);
+    int cellId = 0;
+
+    for(int z = 0; z < totalCells[2]; ++z)
+    {
+        for(int y = 0; y < totalCells[1]; ++y)
+        {
+            for(int x = 0; x < totalCells[0]; ++x)
+            {
+                // Points in the cell are at most cellSize - 1 past its min corner
+                BoundBox cellBox;
+                cellBox.v[0] = Vec3(origin.x + x * cellSize, origin.y + y * cellSize, origin.z + z * cellSize);
+                cellBox.v[1] = cellBox.v[0] + Vec3(cellSize - 1, cellSize - 1, cellSize - 1);
+
+                cells[cellId++] = encodeNode(findDeepestNodeContainingBox(rootNode, cellBox));
+            }
+        }
+    }
+}
+
+void BspLeafGrid::cleanup()
+{
+    x_free(cells);
+    cells = nullptr;
+}
+
+short BspLeafGrid::encodeNode(BspNode* node)
+{
+    return node->isLeaf()
+        ? ~(short)(&node->getLeaf() - leaves)
+        : (short)(node - nodes);
+}
+
+// Uses the same distance calculation as the point test. It only ever rounds down, so the corners
+// closest to and furthest from the plane give the smallest and largest distance any point in the
+// box can get.
+BspNode* BspLeafGrid::findDeepestNodeContainingBox(BspNode* node, const BoundBox& box)
+{
+    while(!node->isLeaf())
+    {
+        const Plane& plane = node->plane->plane;
+        Vec3fp closest;
+        Vec3fp furthest;
+
+        closest.x = fp(plane.normal.x > 0 ? box.v[0].x : box.v[1].x);
+        closest.y = fp(plane.normal.y > 0 ? box.v[0].y : box.v[1].y);
+        closest.z = fp(plane.normal.z > 0 ? box.v[0].z : box.v[1].z);
+
+        furthest.x = fp(plane.normal.x > 0 ? box.v[1].x : box.v[0].x);
+        furthest.y = fp(plane.normal.y > 0 ? box.v[1].y : box.v[0].y);
+        furthest.z = fp(plane.normal.z > 0 ? box.v[1].z : box.v[0].z);
+
+        if(plane.pointOnNormalFacingSide(closest))
+        {
+            node = node->frontChild;
+        }
+        else if(!plane.pointOnNormalFacingSide(furthest))
+        {
+            node = node->backChild;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return node;
+}
+
+BspNode* BspLeafGrid::findStartNode(const Vec3fp& point) const
+{
+    if(cells == nullptr)
+    {
+        return rootNode;
+    }
+
+    // Outside the grid wraps around to a huge unsigned value
+    unsigned int x = (unsigned int)(point.x.internalValue() - origin.x) >> (16 + cellShift);
+    unsigned int y = (unsigned int)(point.y.internalValue() - origin.y) >> (16 + cellShift);
+    unsigned int z = (unsigned int)(point.z.internalValue() - origin.z) >> (16 + cellShift);
+
+    if(x >= (unsigned int)totalCells[0] || y >= (unsigned int)totalCells[1] || z >= (unsigned int)totalCells[2])
+    {
+        return rootNode;
+    }
+
+    return decodeNode(cells[(z * totalCells[1] + y) * totalCells[0] + x]);
+}
+
+BspLeaf* BspLeafGrid::descendToLeaf(BspNode* node, const Vec3fp& point)
+{
+    while(!node->isLeaf())
+    {
+        node = node->plane->plane.pointOnNormalFacingSide(point)
+            ? node->frontChild
+            : node->backChild;
+    }
+
+    return &node->getLeaf();
+}
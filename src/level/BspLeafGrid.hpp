@@ -0,0 +1,68 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include "geo/BoundBox.hpp"
+#include "geo/Vec3.hpp"
+#include "level/BspNode.hpp"
+
+struct BspLevel;
+
+// Uniform grid over the level that maps each cell to the deepest node whose subtree holds the whole
+// cell. Finding the leaf a point is in only has to descend from there, and most cells are inside a
+// single leaf, so there's nothing left to descend.
+class BspLeafGrid
+{
+public:
+    BspLeafGrid()
+        : rootNode(nullptr),
+        cells(nullptr)
+    {
+
+    }
+
+    void init(BspLevel& level);
+    void cleanup();
+
+    // Node to start descending from to find the leaf the point is in
+    BspNode* findStartNode(const Vec3fp& point) const;
+
+    static BspLeaf* descendToLeaf(BspNode* node, const Vec3fp& point);
+
+private:
+    static const int MAX_CELLS = 16384;
+    static const int MIN_CELL_SHIFT = 4;
+
+    BspNode* findDeepestNodeContainingBox(BspNode* node, const BoundBox& box);
+    short encodeNode(BspNode* node);
+
+    BspNode* decodeNode(short id) const
+    {
+        return id >= 0
+            ? nodes + id
+            : (BspNode*)(leaves + ~id);
+    }
+
+    BspNode* rootNode;
+    BspNode* nodes;
+    BspLeaf* leaves;
+
+    Vec3 origin;            // Min corner of the grid
+    int cellShift;          // Cells are 1 << cellShift units on each side
+    int totalCells[3];
+
+    short* cells;           // Node id, or ~leaf id if the cell is inside a single leaf
+};
+
@@ -29,16 +29,7 @@
 
 BspLeaf* BspLevel::findLeafPointIsIn(Vec3fp& point)
 {
-    BspNode* node = &getLevelRootNode();
- 
-    do
-    {
-        node = node->plane->plane.pointOnNormalFacingSide(point)
-            ? node->frontChild
-            : node->backChild;
-    } while(!node->isLeaf());
-    
-    return &node->getLeaf();
+    return BspLeafGrid::descendToLeaf(leafGrid.findStartNode(point), point);
 }
 
 void BspLevel::initEmpty()
@@ -59,7 +50,7 @@ void BspLevel::renderPortals(X_RenderContext& renderContext)
 
         if(portal->otherSide != nullptr)
         {
-            portal->aeSurface = renderContext.renderer->activeEdgeContext.addBrushPolygon(portal->poly, portal->plane, bbFlags, 0);
+            portal->aeSurface = renderContext.activeEdgeContext->addBrushPolygon(portal->poly, portal->plane, bbFlags, 0);
 
             if(portal->aeSurface != nullptr)
             {
@@ -74,7 +65,7 @@ void BspLevel::renderPortals(X_RenderContext& renderContext)
 
                 portal->poly.scaleRelativeToCenter(fp::fromFloat(1.1), outline);
 
-                auto outlineSurface = renderContext.renderer->activeEdgeContext.addBrushPolygon(outline, portal->plane, bbFlags, 0);
+                auto outlineSurface = renderContext.activeEdgeContext->addBrushPolygon(outline, portal->plane, bbFlags, 0);
 
                 if(outlineSurface != nullptr)
                 {
@@ -82,63 +73,66 @@ void BspLevel::renderPortals(X_RenderContext& renderContext)
                 }
             }
         }
-        else
-        {
-            portal->aeSurface = nullptr;
-        }
     }
 }
 
-// static void x_bspnode_mark_surfaces_in_node_as_close_to_light(BspNode* node, const X_Light* light, int currentFrame)
-// {
-//     for(int i = 0; i < node->totalSurfaces; ++i)
-//     {
-//         BspSurface* surface = node->firstSurface + i;
+// Surfaces from the last view are gone once the active edge context starts a new one, and a view
+// that doesn't draw the level (like the wireframe view outside of it) won't add new ones
+void BspLevel::clearPortalSurfaces()
+{
+    for(auto portal = portalHead; portal != nullptr; portal = portal->next)
+    {
+        portal->aeSurface = nullptr;
+    }
+}
+
+static void x_bspnode_mark_surfaces_in_node_as_close_to_light(BspNode* node, const X_Light* light, int currentFrame)
+{
+    for(int i = 0; i < node->totalSurfaces; ++i)
+    {
+        BspSurface* surface = node->firstSurface + i;
         
-//         if(surface->lastLightUpdateFrame != currentFrame)
-//         {
-//             surface->lastLightUpdateFrame = currentFrame;
-//             surface->lightsTouchingSurface = 0;
-//         }
+        if(surface->lastLightUpdateFrame != currentFrame)
+        {
+            surface->lastLightUpdateFrame = currentFrame;
+            surface->lightsTouchingSurface = 0;
+        }
         
-//         surface->lightsTouchingSurface |= (1 << light->id);
-//     }
-// }
-
-// static void x_bspnode_mark_surfaces_light_is_close_to(BspNode* node, const X_Light* light, int currentFrame)
-// {
-//     if(node->isLeaf())
-//         return;
-    
-//     Plane* plane = &node->plane->plane;
-
-//     Vec3fp lightPosTemp = MakeVec3fp(light->position);
+        surface->lightsTouchingSurface |= (1 << light->id);
+    }
+}
 
-//     int dist = plane->distanceTo(lightPosTemp).toInt();
+// Pushes the light down the tree, only visiting the sides of each node that are within its radius
+static void x_bspnode_mark_surfaces_light_is_close_to(BspNode* node, const X_Light* light, int currentFrame)
+{
+    if(node->isLeaf())
+        return;
+    
+    int dist = node->plane->plane.distanceTo(light->position).toInt();
     
-//     if(dist > light->intensity)
-//     {
-//         // Too far away from this node on the front side
-//         x_bspnode_mark_surfaces_light_is_close_to(node->frontChild, light, currentFrame);
-//         return;
-//     }
+    if(dist >= light->intensity)
+    {
+        // Too far away from this node on the front side
+        x_bspnode_mark_surfaces_light_is_close_to(node->frontChild, light, currentFrame);
+        return;
+    }
     
-//     if(dist < -light->intensity)
-//     {
-//         // Too far away from this node on the back side
-//         x_bspnode_mark_surfaces_light_is_close_to(node->backChild, light, currentFrame);
-//         return;
-//     }
+    if(dist <= -light->intensity)
+    {
+        // Too far away from this node on the back side
+        x_bspnode_mark_surfaces_light_is_close_to(node->backChild, light, currentFrame);
+        return;
+    }
     
-//     x_bspnode_mark_surfaces_in_node_as_close_to_light(node, light, currentFrame);
-//     x_bspnode_mark_surfaces_light_is_close_to(node->frontChild, light, currentFrame);
-//     x_bspnode_mark_surfaces_light_is_close_to(node->backChild, light, currentFrame);
-// }
+    x_bspnode_mark_surfaces_in_node_as_close_to_light(node, light, currentFrame);
+    x_bspnode_mark_surfaces_light_is_close_to(node->frontChild, light, currentFrame);
+    x_bspnode_mark_surfaces_light_is_close_to(node->backChild, light, currentFrame);
+}
 
-// void x_bsplevel_mark_surfaces_light_is_close_to(BspLevel* level, const X_Light* lights, int currentFrame)
-// {
-//     x_bspnode_mark_surfaces_light_is_close_to(x_bsplevel_get_level_model(level)->rootBspNode, light, currentFrame);
-// }
+void x_bsplevel_mark_surfaces_light_is_close_to(BspLevel* level, const X_Light* light, int currentFrame)
+{
+    x_bspnode_mark_surfaces_light_is_close_to(&level->getLevelRootNode(), light, currentFrame);
+}
 
 void x_bsplevel_get_texture(BspLevel* level, int textureId, int mipMapLevel, Texture* dest)
 {
@@ -169,6 +163,9 @@ void x_bsplevel_cleanup(BspLevel* level)
     x_free(level->textureTexels);
     x_free(level->vertices);
     x_free(level->clipNodes);
+
+    level->nodeBounds.cleanup();
+    level->leafGrid.cleanup();
 }
 
 BspNode** x_bsplevel_find_nodes_intersecting_sphere_recursive(BspNode* node, BoundSphere* sphere, BspNode** nextNodeDest)
@@ -215,7 +212,7 @@ int x_bsplevel_find_nodes_intersecting_sphere(BspLevel* level, BoundSphere* sphe
 
 Portal* BspLevel::addPortal()
 {
-    auto portal = Zone::alloc<Portal>();
+    auto portal = Zone::alloc<Portal>(1, ZoneTag::level);
 
     portal->next = portalHead;
     portal->aeSurface = nullptr;
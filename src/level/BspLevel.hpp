@@ -16,10 +16,12 @@
 #pragma once
 
 #include "geo/BoundBox.hpp"
+#include "geo/BoundBoxArray.hpp"
 #include "geo/Plane.hpp"
 #include "geo/Polygon2.hpp"
 #include "geo/Polygon3.hpp"
 #include "geo/Vec3.hpp"
+#include "level/BspLeafGrid.hpp"
 #include "level/BspModel.hpp"
 #include "level/BspNode.hpp"
 #include "math/Mat4x4.hpp"
@@ -82,6 +84,41 @@ typedef enum X_BspSurfaceFlags
 
 #define X_BSPSURFACE_MAX_LIGHTMAPS 4
 
+// Inclusive rectangle of lightmap lumels
+struct LumelRect
+{
+    static LumelRect empty()
+    {
+        return { 0x7FFF, 0x7FFF, -1, -1 };
+    }
+
+    bool isEmpty() const
+    {
+        return left > right || top > bottom;
+    }
+
+    void add(const LumelRect& rect)
+    {
+        left = std::min(left, rect.left);
+        top = std::min(top, rect.top);
+        right = std::max(right, rect.right);
+        bottom = std::max(bottom, rect.bottom);
+    }
+
+    short left;
+    short top;
+    short right;
+    short bottom;
+};
+
+// Dynamic lighting a cached surface was built with
+struct BspSurfaceLightState
+{
+    unsigned int lights;        // Bit i set if dynamic light i was applied
+    unsigned int lightVersion;  // Renderer light version at the time
+    LumelRect litRect;          // Lumels those lights reach
+};
+
 struct BspSurface
 {
     void calculatePlaneInViewSpace(const Vec3fp& camPos, Mat4x4* viewMatrix, Vec3fp& pointOnSurface, Plane* dest)
@@ -111,10 +148,11 @@ struct BspSurface
     unsigned char* lightmapData;
     unsigned char lightmapStyles[X_BSPSURFACE_MAX_LIGHTMAPS];
     
-    unsigned int lightsTouchingSurface;
+    unsigned int lightsTouchingSurface;     // Only valid if lastLightUpdateFrame is the current frame
     int lastLightUpdateFrame;
     
     X_CacheEntry cachedSurfaces[X_BSPTEXTURE_MIP_LEVELS];   // Cached surface for each mipmap level
+    BspSurfaceLightState cachedLightStates[X_BSPTEXTURE_MIP_LEVELS];
 };
 
 struct BspEdge
@@ -187,9 +225,21 @@ struct BspLevel
         return getLevelModel().getRootNode();
     }
 
+    // Index of a node or leaf in nodeBounds (nodes first, then leaves)
+    int getNodeBoundsId(BspNode& node) const
+    {
+        if(node.isLeaf())
+        {
+            return totalNodes + (int)(&node.getLeaf() - leaves);
+        }
+
+        return (int)(&node - nodes);
+    }
+
     Portal* addPortal();
 
     void renderPortals(X_RenderContext& renderContext);
+    void clearPortalSurfaces();
     
     X_BspLevelFlags flags;
     char name[X_BSPLEVEL_MAX_NAME_LENGTH];
@@ -211,6 +261,9 @@ struct BspLevel
     
     BspNode* nodes;
     int totalNodes;
+
+    BoundBoxArray nodeBounds;
+    BspLeafGrid leafGrid;
     
     X_BspClipNode* clipNodes;
     int totalClipNodes;
@@ -337,12 +337,17 @@ static void x_bsplevel_init_surfaces(BspLevel* level, const X_BspLevelLoader* lo
         surface->faceTexture = level->faceTextures + face->texInfo;
         surface->lightmapData = level->lightmapData + face->lightmapOffset;
         surface->lastVisibleFrame = -1;
+        surface->lightsTouchingSurface = 0;
+        surface->lastLightUpdateFrame = -1;
         
         x_bspsurface_calculate_texture_extents(surface, level);
         
         for(int j = 0; j < 4; ++j)
         {
             x_cacheentry_init(surface->cachedSurfaces + j);
+            surface->cachedLightStates[j].lights = 0;
+            surface->cachedLightStates[j].lightVersion = 0;
+            surface->cachedLightStates[j].litRect = LumelRect::empty();
             surface->lightmapStyles[j] = face->lightmapStyles[j];
         }
     }
@@ -376,6 +381,7 @@ static void x_bsplevel_init_leaves(BspLevel* level, const X_BspLevelLoader* load
         leaf->pvsFromLeaf.setCompressedBytes(level->pvs.getCompressedPvsData() + loadLeaf->pvsOffset);
         leaf->contents = (X_BspLeafContents)loadLeaf->contents;
         leaf->lastVisibleFrame = 0;
+        leaf->bspKeyFrame = -1;
         leaf->firstMarkSurface = level->markSurfaces + loadLeaf->firstMarkSurface;
         leaf->totalMarkSurfaces = loadLeaf->totalMarkSurfaces;
         
@@ -427,9 +433,8 @@ static void x_bsplevel_init_models(BspLevel* level, const X_BspLevelLoader* load
         model->planes = level->planes;
         
         model->clipNodes = level->clipNodes;
-        model->clipNodeRoots[0] = loadModel->rootClipNode;
-        model->clipNodeRoots[1] = loadModel->secondRootClipNode;
-        model->clipNodeRoots[2] = loadModel->thirdRootClipNode;
+        model->clipNodeRoots[BSPCLIPHULL_PLAYER] = loadModel->rootClipNode;
+        model->clipNodeRoots[BSPCLIPHULL_LARGE] = loadModel->secondRootClipNode;
         
         model->center = convert<Vec3fp>(loadModel->origin)
             .toX3dCoords();
@@ -445,6 +450,9 @@ static void x_bsplevel_init_models(BspLevel* level, const X_BspLevelLoader* load
         model->edges = level->edges;
         model->vertices = level->vertices;
         model->flags = 0;
+
+        model->faceWorldVertices = nullptr;
+        model->worldGeometryFrame = -1;
         
         x_link_init(&model->objectsOnModelHead, &model->objectsOnModelTail);
         
@@ -617,6 +625,52 @@ static void x_bsplevel_init_clipnodes(BspLevel* level, X_BspLevelLoader* loader)
     loader->clipNodes.elem = nullptr;
 }
 
+static int x_bsplevel_get_point_hull_child(BspLevel* level, BspNode* node, int firstPointHullNode)
+{
+    if(node->isLeaf())
+    {
+        return node->contents;
+    }
+
+    return firstPointHullNode + (int)(node - level->nodes);
+}
+
+// The point hull doesn't need growing, so it's just the BSP tree. Its nodes are appended to the
+// level's clip nodes so it can be traced like the other hulls.
+static void x_bsplevel_init_point_hull(BspLevel* level)
+{
+    const int MAX_CLIP_NODES = 0x7FFF;
+
+    int firstPointHullNode = level->totalClipNodes;
+    int totalClipNodes = level->totalClipNodes + level->totalNodes;
+
+    if(totalClipNodes > MAX_CLIP_NODES)
+    {
+        x_system_error("Too many nodes to build point hull (%d)", totalClipNodes);
+    }
+
+    level->clipNodes = (X_BspClipNode*)x_realloc(level->clipNodes, totalClipNodes * sizeof(X_BspClipNode));
+    level->totalClipNodes = totalClipNodes;
+
+    for(int i = 0; i < level->totalNodes; ++i)
+    {
+        BspNode* node = level->nodes + i;
+        X_BspClipNode* clipNode = level->clipNodes + firstPointHullNode + i;
+
+        clipNode->planeId = (int)(node->plane - level->planes);
+        clipNode->frontChild = x_bsplevel_get_point_hull_child(level, node->frontChild, firstPointHullNode);
+        clipNode->backChild = x_bsplevel_get_point_hull_child(level, node->backChild, firstPointHullNode);
+    }
+
+    for(int i = 0; i < level->totalModels; ++i)
+    {
+        BspModel* model = level->models + i;
+
+        model->clipNodes = level->clipNodes;
+        model->clipNodeRoots[BSPCLIPHULL_POINT] = x_bsplevel_get_point_hull_child(level, model->rootBspNode, firstPointHullNode);
+    }
+}
+
 static void x_bsplevel_init_collision_hulls(BspLevel* level, X_BspLevelLoader* loader)
 {
     for(int i = 0; i < X_BSPLEVEL_MAX_COLLISION_HULLS; ++i)
@@ -629,6 +683,22 @@ static void x_bsplevel_init_entity_dictionary(BspLevel* level, X_BspLevelLoader*
     loader->entityDictionary = NULL;
 }
 
+static void x_bsplevel_init_node_bounds(BspLevel* level)
+{
+    level->nodeBounds.init(level->totalNodes + level->totalLeaves);
+
+    for(int i = 0; i < level->totalNodes; ++i)
+    {
+        level->nodeBounds.setBox(level->getNodeBoundsId(level->nodes[i]), level->nodes[i].nodeBoundBox);
+    }
+
+    for(int i = 0; i < level->totalLeaves; ++i)
+    {
+        BspNode& leafNode = *(BspNode*)(level->leaves + i);
+        level->nodeBounds.setBox(level->getNodeBoundsId(leafNode), leafNode.nodeBoundBox);
+    }
+}
+
 static void x_bsplevel_init_from_bsplevel_loader(BspLevel* level, X_BspLevelLoader* loader)
 {
     x_bsplevel_allocate_memory(level, loader);
@@ -642,9 +712,12 @@ static void x_bsplevel_init_from_bsplevel_loader(BspLevel* level, X_BspLevelLoad
     x_bsplevel_init_marksurfaces(level, loader);
     x_bsplevel_init_leaves(level, loader);
     x_bsplevel_init_nodes(level, loader);
+    x_bsplevel_init_node_bounds(level);
     x_bsplevel_init_clipnodes(level, loader);
     x_bsplevel_init_surfacedgeids(level, loader);
     x_bsplevel_init_models(level, loader);
+    x_bsplevel_init_point_hull(level);
+    level->leafGrid.init(*level);
     x_bsplevel_init_textures(level, loader);
     x_bsplevel_init_facetextures(level, loader);
     x_bsplevel_init_surfaces(level, loader);
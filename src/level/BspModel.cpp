@@ -17,3 +17,21 @@
 #include "level/BspLevel.hpp"
 #include "render/RenderContext.hpp"
 
+
+static Vec3 makeVec3FromInts(int x, int y, int z)
+{
+    return Vec3(x_fp16x16_from_int(x), x_fp16x16_from_int(y), x_fp16x16_from_int(z));
+}
+
+const BoundBox& x_bspcliphull_get_box(BspClipHull hull)
+{
+    // Quake's hull sizes, converted to X3D coordinates (y points down, so the feet are at max y)
+    static const BoundBox boxes[BSPCLIPHULL_TOTAL] =
+    {
+        BoundBox(makeVec3FromInts(-16, -32, -16), makeVec3FromInts(16, 24, 16)),
+        BoundBox(makeVec3FromInts(-32, -64, -32), makeVec3FromInts(32, 24, 32)),
+        BoundBox(makeVec3FromInts(0, 0, 0), makeVec3FromInts(0, 0, 0))
+    };
+
+    return boxes[hull];
+}
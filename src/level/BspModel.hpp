@@ -27,6 +27,19 @@ struct BspPlane;
 struct BspVertex;
 struct BspEdge;
 
+// Each clip hull is a model's solid space grown by a box, so tracing the box's origin through the
+// hull sweeps the whole box
+enum BspClipHull
+{
+    BSPCLIPHULL_PLAYER = 0,     // Compiled into the map
+    BSPCLIPHULL_LARGE = 1,      // Compiled into the map
+    BSPCLIPHULL_POINT = 2,      // Built from the BSP nodes when the level is loaded
+    BSPCLIPHULL_TOTAL = 3
+};
+
+// Box a clip hull was built for, relative to the origin that's traced through it
+const BoundBox& x_bspcliphull_get_box(BspClipHull hull);
+
 struct BspModel
 {
     BspNode& getRootNode() const
@@ -38,7 +51,7 @@ struct BspModel
     BspNode* rootBspNode;
 
     X_BspClipNode* clipNodes;
-    int clipNodeRoots[3];
+    int clipNodeRoots[BSPCLIPHULL_TOTAL];
 
     BspPlane* planes;
     BspVertex* vertices;
@@ -51,6 +64,12 @@ struct BspModel
     int totalFaces;
     
     Vec3fp center;
+
+    // World space vertices of each face and the world bound box, built once per rendered frame
+    // and shared by every view
+    Vec3fp** faceWorldVertices;
+    BoundBox worldBoundBox;
+    int worldGeometryFrame;
     
     unsigned int flags;
     
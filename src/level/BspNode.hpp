@@ -92,6 +92,7 @@ struct BspLeaf
     BspSurface** firstMarkSurface;
     int totalMarkSurfaces;
     int bspKey;
+    int bspKeyFrame;    // Frame bspKey was assigned in, stale if the leaf wasn't reached
     
     CompressedLeafVisibleSet pvsFromLeaf;
 };
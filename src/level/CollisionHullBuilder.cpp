@@ -24,9 +24,9 @@ void CollisionHullBuilder::build()
     center = polygon.calculateCenter();
     calculateAxisFromOrientation();
 
-    for(int i = 0; i < 1; ++i)
+    for(int i = 0; i < BSPCLIPHULL_TOTAL; ++i)
     {
-        buildClipNodeHull(i);
+        buildClipNodeHull((BspClipHull)i);
     }
 }
 
@@ -43,9 +43,10 @@ void CollisionHullBuilder::calculateAxisFromOrientation()
     axis[5] = forward;
 }
 
-void CollisionHullBuilder::buildClipNodeHull(int level)
+void CollisionHullBuilder::buildClipNodeHull(BspClipHull hull)
 {
-    model.clipNodeRoots[level] = buildHullSidesRecursively(0);
+    currentHull = hull;
+    model.clipNodeRoots[hull] = buildHullSidesRecursively(0);
 }
 
 int CollisionHullBuilder::buildHullSidesRecursively(int depth)
@@ -84,12 +85,31 @@ Vec3fp CollisionHullBuilder::findPointOnPlane(int axisId)
     }
 }
 
+// Distance along the normal to the point in the box that's furthest behind it
+static fp closestDistanceInBox(const Vec3fp& normal, const BoundBox& box)
+{
+    fp x = normal.x * fp(normal.x > 0 ? box.v[0].x : box.v[1].x);
+    fp y = normal.y * fp(normal.y > 0 ? box.v[0].y : box.v[1].y);
+    fp z = normal.z * fp(normal.z > 0 ? box.v[0].z : box.v[1].z);
+
+    return x + y + z;
+}
+
 int CollisionHullBuilder::createCollisionPlane(int axisId)
 {
     Vec3fp pointOnPlane = findPointOnPlane(axisId);
 
     int planeId = allocatePlane();
-    model.planes[planeId].plane = Plane(axis[axisId], pointOnPlane);
+    Plane& plane = model.planes[planeId].plane;
+
+    plane = Plane(axis[axisId], pointOnPlane);
+
+    // The sides are placed for the player's box, so the other hulls are grown (or shrunk) by how
+    // much further their box reaches behind the plane
+    const BoundBox& hullBox = x_bspcliphull_get_box(currentHull);
+    const BoundBox& playerBox = x_bspcliphull_get_box(BSPCLIPHULL_PLAYER);
+
+    plane.d = plane.d + closestDistanceInBox(plane.normal, hullBox) - closestDistanceInBox(plane.normal, playerBox);
 
     return planeId;
 }
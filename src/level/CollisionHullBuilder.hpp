@@ -17,9 +17,9 @@
 
 #include "math/FixedPoint.hpp"
 #include "geo/Vec3.hpp"
+#include "level/BspModel.hpp"
 
 struct Polygon3;
-struct BspModel;
 struct Mat4x4;
 
 class CollisionHullBuilder
@@ -42,7 +42,7 @@ public:
 private:
     Vec3fp& vertexWithLargestProjection(const Vec3fp& axis);
 
-    void buildClipNodeHull(int level);
+    void buildClipNodeHull(BspClipHull hull);
     void calculateAxisFromOrientation();
 
     int buildHullSidesRecursively(int depth);
@@ -68,6 +68,7 @@ private:
 
     int totalPlanes;
     int totalClipNodes;
+    BspClipHull currentHull;
 
     Vec3fp axis[6];
 
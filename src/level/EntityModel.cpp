@@ -14,6 +14,7 @@
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
 #include <new>
+#include <algorithm>
 
 #include "EntityModel.hpp"
 #include "EntityModelLoader.hpp"
@@ -27,6 +28,7 @@
 #include "render/Camera.hpp"
 #include "render/AffineTriangleFiller.hpp"
 #include "geo/PolygonClipper.hpp"
+#include "render/Screen.hpp"
 
 bool x_entitymodel_load_from_file(X_EntityModel* model, const char* fileName)
 {
@@ -52,30 +54,44 @@ void x_entitymodel_get_skin_texture(X_EntityModel* model, int skinId, int textur
 
 void x_entitymodel_cleanup(X_EntityModel* model)
 {
+    bool ownsData = model->fileData == nullptr;
+
     // Each skin allocates its textures together, so just free the first
     for(int i = 0; i < model->totalSkins; ++i)
     {
-        x_free(model->skins[i].textures[0].texels);
+        if(ownsData && model->skins[i].totalTextures > 0)
+        {
+            x_free(model->skins[i].textures[0].texels);
+        }
+
         x_free(model->skins[i].textures);
     }
     
     x_free(model->skins);
-    x_free(model->textureCoords);
-    x_free(model->triangles);
+
+    if(ownsData)
+    {
+        x_free(model->textureCoords);
+        x_free(model->triangles);
+    }
     
     for(int i = 0; i < model->totalFrameGroups; ++i)
     {
         X_EntityFrameGroup* group = model->frameGroups + i;
-        for(int frameId = 0; frameId < group->totalFrames; ++frameId)
+
+        if(ownsData)
         {
-            X_EntityFrame* frame = group->frames + frameId;
-            x_free(frame->vertices);
+            for(int frameId = 0; frameId < group->totalFrames; ++frameId)
+            {
+                x_free(group->frames[frameId].vertexX);
+            }
         }
         
         x_free(group->frames);
     }
     
     x_free(model->frameGroups);
+    x_free(model->fileData);
 }
 
 X_EntityFrame* x_entitymodel_get_frame(X_EntityModel* model, const char* frameName)
@@ -108,12 +124,11 @@ void x_entitymodel_draw_frame_wireframe(X_EntityModel* model, X_EntityFrame* fra
     for(X_EntityTriangle* triangle = model->triangles; triangle < model->triangles + model->totalTriangles; ++triangle)
     {
         Vec3fp v[3];
-        X_EntityVertex* vertices[3];
         
         for(int i = 0; i < 3; ++i)
         {
-            vertices[i] = frame->vertices + triangle->vertexIds[i];
-            v[i] = MakeVec3fp(vertices[i]->v) + MakeVec3fp(pos);
+            int id = triangle->vertexIds[i];
+            v[i] = Vec3fp(frame->vertexX[id], frame->vertexY[id], frame->vertexZ[id]) + MakeVec3fp(pos);
         }
         
         for(int i = 0; i < 3; ++i)
@@ -169,6 +184,19 @@ void drawTriangle(ModelVertex* vertices[3], X_RenderContext* renderContext, Text
 
 #endif
 
+    // Skip triangles that are behind everything in every tile they touch
+    int left = std::min(vertices[0]->x, std::min(vertices[1]->x, vertices[2]->x));
+    int right = std::max(vertices[0]->x, std::max(vertices[1]->x, vertices[2]->x));
+    int top = std::min(vertices[0]->y, std::min(vertices[1]->y, vertices[2]->y));
+    int bottom = std::max(vertices[0]->y, std::max(vertices[1]->y, vertices[2]->y));
+
+    fp closestZ = std::max(filler.vertices[0].z, std::max(filler.vertices[1].z, filler.vertices[2].z));
+
+    if(renderContext->screen->zbufRectIsHidden(left, top, right, bottom, (closestZ >> X_TRIANGLEFILLER_EXTRA_PRECISION).internalValue()))
+    {
+        return;
+    }
+
     x_trianglefiller_fill_textured(&filler, &texture);
 }
 
@@ -216,38 +244,98 @@ void x_polygon3_render_textured(ModelVertex* vertices, int totalVertices, X_Rend
      }
 }
 
+static bool sphereIsOutsideFrustum(const BoundSphere& sphere, const X_Frustum& frustum)
+{
+    for(int i = 0; i < frustum.totalPlanes; ++i)
+    {
+        if(frustum.planes[i].distanceTo(sphere.center) < -sphere.radius)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The transform is a rotation followed by a translation, so the inverse is the transposed rotation
+static Vec3fp transformToModelSpace(const Mat4x4& transformMatrix, const Vec3fp& v)
+{
+    Mat4x4 inverseRotation = transformMatrix;
+    inverseRotation.dropTranslation();
+    inverseRotation.transpose3x3();
+
+    Vec3fp translation(transformMatrix.elem[0][3], transformMatrix.elem[1][3], transformMatrix.elem[2][3]);
+
+    return inverseRotation.transform(v - translation);
+}
+
 void x_entitymodel_render_flat_shaded(X_EntityModel* model, X_EntityFrame* frame, Mat4x4& transformMatrix, X_RenderContext* renderContext)
 {
+    BoundSphere sphere(transformMatrix.transform(frame->boundSphere.center), frame->boundSphere.radius);
+
+    if(sphereIsOutsideFrustum(sphere, *renderContext->viewFrustum))
+    {
+        return;
+    }
+
     Texture skin;
     x_entitymodel_get_skin_texture(model, 0, 0, &skin);
 
+    Vec3fp camPos = transformToModelSpace(transformMatrix, renderContext->camPos);
+
+    // Back faces are culled in model space, and only vertices used by a front face are set up. The
+    // whole frame is transformed in one batch though, since that's cheaper than picking them out.
+    static unsigned char vertexIsUsed[X_ENTITYMODEL_MAX_VERTICES];
+    static Vec3fp frameVertices[X_ENTITYMODEL_MAX_VERTICES];
+    static ModelVertex transformedVertices[X_ENTITYMODEL_MAX_VERTICES];
+    static unsigned short visibleTriangles[X_ENTITYMODEL_MAX_TRIANGLES];
+
+    memset(vertexIsUsed, 0, model->totalVertices);
+
+    int totalVisibleTriangles = 0;
+
     for(int i = 0; i < model->totalTriangles; ++i)
     {
-        Vec3fp v[3];
         X_EntityTriangle* tri = model->triangles + i;
-        ModelVertex modelVertex[3];
+        int v0 = tri->vertexIds[0];
+        Vec3fp toCam = camPos - Vec3fp(frame->vertexX[v0], frame->vertexY[v0], frame->vertexZ[v0]);
 
-        for(int j = 0; j < 3; ++j)
+        if(frame->faceNormals[i].dot(toCam) <= 0)
         {
-            v[j] = MakeVec3fp(frame->vertices[tri->vertexIds[j]].v);
+            continue;
+        }
 
-            Vec3fp transformed = transformMatrix.transform(v[j]);
+        vertexIsUsed[tri->vertexIds[0]] = 1;
+        vertexIsUsed[tri->vertexIds[1]] = 1;
+        vertexIsUsed[tri->vertexIds[2]] = 1;
 
-            v[j] = transformed;
+        visibleTriangles[totalVisibleTriangles++] = i;
+    }
 
-            modelVertex[j].v = v[j];
+    transformMatrix.transformPoints(frame->vertexX, frame->vertexY, frame->vertexZ, frameVertices, model->totalVertices);
 
-            X_EntityTextureCoord* coord = model->textureCoords + tri->vertexIds[j];
+    for(int i = 0; i < model->totalVertices; ++i)
+    {
+        if(!vertexIsUsed[i])
+        {
+            continue;
+        }
 
-            modelVertex[j].s = coord->coord.x;
-            modelVertex[j].t = coord->coord.y;
+        ModelVertex* vertex = transformedVertices + i;
 
-            if(!tri->facesFront && coord->onSeam)
-            {
-                modelVertex[j].s += model->skinWidth / 2;
-            }
+        vertex->v = frameVertices[i];
+        vertex->s = model->textureCoords[i].s;
+        vertex->t = model->textureCoords[i].t;
+    }
 
-            modelVertex[j].z = (1.0_fp / transformed.z).internalValue();
+    for(int i = 0; i < totalVisibleTriangles; ++i)
+    {
+        X_EntityTriangle* tri = model->triangles + visibleTriangles[i];
+        ModelVertex modelVertex[3];
+
+        for(int j = 0; j < 3; ++j)
+        {
+            modelVertex[j] = transformedVertices[tri->vertexIds[j]];
         }
 
         x_polygon3_render_textured(modelVertex, 3, renderContext, &skin);
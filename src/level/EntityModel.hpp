@@ -18,6 +18,8 @@
 #include <math/Mat4x4.hpp>
 #include "render/Texture.hpp"
 #include "geo/Vec3.hpp"
+#include "geo/BoundBox.hpp"
+#include "geo/BoundSphere.hpp"
 
 typedef struct X_EntitySkinTexture
 {
@@ -31,35 +33,36 @@ typedef struct X_EntitySkin
     X_EntitySkinTexture* textures;
 } X_EntitySkin;
 
+// Models are stored with their vertices welded: each vertex has exactly one texture coordinate,
+// so vertices on the skin seam that are used by back facing triangles get their own copy
+#define X_ENTITYMODEL_MAX_VERTICES 2048
+#define X_ENTITYMODEL_MAX_TRIANGLES 4096
+#define X_ENTITYMODEL_MAX_SKIN_SIZE 1024
+
 typedef struct X_EntityTextureCoord
 {
-    Vec2 coord;
-    bool onSeam;
+    int s;
+    int t;
 } X_EntityTextureCoord;
 
 typedef struct X_EntityTriangle
 {
-    int vertexIds[3];
-    bool facesFront;
+    unsigned short vertexIds[3];
 } X_EntityTriangle;
 
-typedef struct X_EntityVertex
-{
-    Vec3 v;
-    int normalIndex;
-} X_EntityVertex;
-
-typedef struct X_EntityBoundBox
-{
-    X_EntityVertex min;
-    X_EntityVertex max;
-} X_EntityBoundBox;
-
 typedef struct X_EntityFrame
 {
-    X_EntityBoundBox boundBox;
+    BoundBox boundBox;
+    BoundSphere boundSphere;
     char name[16];
-    X_EntityVertex* vertices;
+
+    // Vertex positions are stored as separate x, y, and z arrays
+    fp* vertexX;
+    fp* vertexY;
+    fp* vertexZ;
+
+    // One per triangle, pointing away from the side the triangle is visible from
+    Vec3fp* faceNormals;
     
     struct X_EntityFrame* nextInSequence;
 } X_EntityFrame;
@@ -68,7 +71,6 @@ typedef struct X_EntityFrameGroup
 {
     int totalFrames;
     X_EntityFrame* frames;
-    X_EntityBoundBox boundBox;
     x_fp16x16 displayDuration;
 } X_EntityFrameGroup;
 
@@ -80,7 +82,7 @@ typedef struct X_EntityModel
     int skinWidth;
     int skinHeight;
     
-    int totalTextureCoords;
+    int totalVertices;
     X_EntityTextureCoord* textureCoords;
     
     int totalTriangles;
@@ -88,6 +90,10 @@ typedef struct X_EntityModel
     
     int totalFrameGroups;
     X_EntityFrameGroup* frameGroups;
+
+    // Set if the model was loaded from an X3D model file, in which case the texels, texture coords,
+    // triangles, and frame data all point into it
+    unsigned char* fileData;
 } X_EntityModel;
 
 bool x_entitymodel_load_from_file(struct X_EntityModel* model, const char* fileName);
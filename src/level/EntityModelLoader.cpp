@@ -14,6 +14,8 @@
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
 #include <ctype.h>
+#include <math.h>
+#include <algorithm>
 
 #include "EntityModelLoader.hpp"
 #include "EntityModel.hpp"
@@ -62,6 +64,13 @@ static bool read_header(X_EntityModelLoader* loader)
     header->flags = x_file_read_le_int32(file);
     header->averageTriangleSize = x_file_read_le_float32_as_fp16x16(file);
     
+    if(header->skinWidth <= 0 || header->skinWidth > X_ENTITYMODEL_MAX_SKIN_SIZE
+        || header->skinHeight <= 0 || header->skinHeight > X_ENTITYMODEL_MAX_SKIN_SIZE)
+    {
+        x_log_error("Bad model skin size: %dx%d\n", header->skinWidth, header->skinHeight);
+        return 0;
+    }
+    
     return 1;
 }
 
@@ -121,77 +130,259 @@ static void read_skins(X_EntityModelLoader* loader)
 
 static void read_texture_coords(X_EntityModelLoader* loader)
 {
-    X_EntityModel* model = loader->modelDest;
-    
-    model->totalTextureCoords = loader->header.totalVertices;
-    model->textureCoords = (X_EntityTextureCoord*)x_malloc(sizeof(X_EntityTextureCoord) * model->totalTextureCoords);
+    int totalVertices = loader->header.totalVertices;
+    loader->mdlTextureCoords = (X_EntityModelMdlTextureCoord*)x_malloc(sizeof(X_EntityModelMdlTextureCoord) * totalVertices);
     
-    for(int i = 0; i < model->totalTextureCoords; ++i)
+    for(int i = 0; i < totalVertices; ++i)
     {
-        model->textureCoords[i].onSeam = x_file_read_le_int32(&loader->file);
-        x_file_read_vec2(&loader->file, &model->textureCoords[i].coord);
+        X_EntityModelMdlTextureCoord* coord = loader->mdlTextureCoords + i;
+
+        coord->onSeam = x_file_read_le_int32(&loader->file);
+        coord->s = x_file_read_le_int32(&loader->file);
+        coord->t = x_file_read_le_int32(&loader->file);
     }
 }
 
 static void read_triangles(X_EntityModelLoader* loader)
 {
-    X_EntityModel* model = loader->modelDest;
+    int totalTriangles = loader->header.totalTriangles;
+
+    if(totalTriangles > X_ENTITYMODEL_MAX_TRIANGLES)
+    {
+        x_system_error("Model %s has too many triangles (%d, max is %d)", loader->modelDest->name, totalTriangles, X_ENTITYMODEL_MAX_TRIANGLES);
+    }
+
+    loader->mdlTriangles = (X_EntityModelMdlTriangle*)x_malloc(sizeof(X_EntityModelMdlTriangle) * totalTriangles);
     
+    for(int i = 0; i < totalTriangles; ++i)
+    {
+        X_EntityModelMdlTriangle* triangle = loader->mdlTriangles + i;
+
+        triangle->facesFront = x_file_read_le_int32(&loader->file);
+        
+        for(int v = 0; v < 3; ++v)
+        {
+            triangle->vertexIds[v] = x_file_read_le_int32(&loader->file);
+
+            if(triangle->vertexIds[v] < 0 || triangle->vertexIds[v] >= loader->header.totalVertices)
+            {
+                x_system_error("Model %s has a triangle with a bad vertex id: %d", loader->modelDest->name, triangle->vertexIds[v]);
+            }
+        }
+    }
+}
+
+// Back facing triangles use the other half of the skin for vertices on the seam, so give those
+// vertices a second copy with the shifted texture coordinate
+static void split_seam_vertices(X_EntityModelLoader* loader)
+{
+    X_EntityModel* model = loader->modelDest;
+    int totalMdlVertices = loader->header.totalVertices;
+    int maxVertices = totalMdlVertices * 2;
+
+    int* backSideIds = (int*)x_malloc(sizeof(int) * totalMdlVertices);
+    loader->mdlVertexIds = (int*)x_malloc(sizeof(int) * maxVertices);
+    model->textureCoords = (X_EntityTextureCoord*)x_malloc(sizeof(X_EntityTextureCoord) * maxVertices);
+
+    for(int i = 0; i < totalMdlVertices; ++i)
+    {
+        backSideIds[i] = -1;
+        loader->mdlVertexIds[i] = i;
+        model->textureCoords[i].s = loader->mdlTextureCoords[i].s;
+        model->textureCoords[i].t = loader->mdlTextureCoords[i].t;
+    }
+
+    int totalVertices = totalMdlVertices;
+
     model->totalTriangles = loader->header.totalTriangles;
     model->triangles = (X_EntityTriangle*)x_malloc(sizeof(X_EntityTriangle) * model->totalTriangles);
-    
+
     for(int i = 0; i < model->totalTriangles; ++i)
     {
-        model->triangles[i].facesFront = x_file_read_le_int32(&loader->file);
-        
+        X_EntityModelMdlTriangle* mdlTriangle = loader->mdlTriangles + i;
+
         for(int v = 0; v < 3; ++v)
-            model->triangles[i].vertexIds[v] = x_file_read_le_int32(&loader->file);
+        {
+            int id = mdlTriangle->vertexIds[v];
+
+            if(!mdlTriangle->facesFront && loader->mdlTextureCoords[id].onSeam)
+            {
+                if(backSideIds[id] == -1)
+                {
+                    backSideIds[id] = totalVertices;
+                    loader->mdlVertexIds[totalVertices] = id;
+                    model->textureCoords[totalVertices].s = loader->mdlTextureCoords[id].s + model->skinWidth / 2;
+                    model->textureCoords[totalVertices].t = loader->mdlTextureCoords[id].t;
+                    ++totalVertices;
+                }
+
+                id = backSideIds[id];
+            }
+
+            model->triangles[i].vertexIds[v] = id;
+        }
+    }
+
+    if(totalVertices > X_ENTITYMODEL_MAX_VERTICES)
+    {
+        x_system_error("Model %s has too many vertices (%d, max is %d)", model->name, totalVertices, X_ENTITYMODEL_MAX_VERTICES);
     }
+
+    model->totalVertices = totalVertices;
+    model->textureCoords = (X_EntityTextureCoord*)x_realloc(model->textureCoords, sizeof(X_EntityTextureCoord) * totalVertices);
+
+    x_free(backSideIds);
 }
 
-static void read_vertex(X_File* file, X_EntityVertex* vertex, Vec3 scale, Vec3 translation)
+static void read_vertex(X_File* file, Vec3* vertex, Vec3 scale, Vec3 translation)
 {
-    vertex->v.x = x_fp16x16_from_int(x_file_read_char(file));
-    vertex->v.y = x_fp16x16_from_int(x_file_read_char(file));
-    vertex->v.z = x_fp16x16_from_int(x_file_read_char(file));
+    vertex->x = x_fp16x16_from_int(x_file_read_char(file));
+    vertex->y = x_fp16x16_from_int(x_file_read_char(file));
+    vertex->z = x_fp16x16_from_int(x_file_read_char(file));
 
-    vertex->v = MakeVec3(MakeVec3fp(vertex->v).scale(MakeVec3fp(scale))) + translation;
+    *vertex = MakeVec3(MakeVec3fp(*vertex).scale(MakeVec3fp(scale))) + translation;
     
-    vertex->v = x_vec3_convert_quake_coord_to_x3d_coord(&vertex->v);
+    *vertex = x_vec3_convert_quake_coord_to_x3d_coord(vertex);
     
-    vertex->normalIndex = x_file_read_char(file);
+    // Normal index, which isn't used
+    x_file_read_char(file);
+}
+
+static void calculate_frame_bounds(X_EntityModel* model, X_EntityFrame* frame)
+{
+    Vec3 mins(frame->vertexX[0].internalValue(), frame->vertexY[0].internalValue(), frame->vertexZ[0].internalValue());
+    Vec3 maxs = mins;
+
+    for(int i = 1; i < model->totalVertices; ++i)
+    {
+        Vec3 v(frame->vertexX[i].internalValue(), frame->vertexY[i].internalValue(), frame->vertexZ[i].internalValue());
+
+        mins = Vec3(std::min(mins.x, v.x), std::min(mins.y, v.y), std::min(mins.z, v.z));
+        maxs = Vec3(std::max(maxs.x, v.x), std::max(maxs.y, v.y), std::max(maxs.z, v.z));
+    }
+
+    frame->boundBox = BoundBox(mins, maxs);
+
+    Vec3fp center = (MakeVec3fp(mins) + MakeVec3fp(maxs)) / 2;
+    float maxDistSquared = 0;
+
+    for(int i = 0; i < model->totalVertices; ++i)
+    {
+        float dx = (frame->vertexX[i] - center.x).toFloat();
+        float dy = (frame->vertexY[i] - center.y).toFloat();
+        float dz = (frame->vertexZ[i] - center.z).toFloat();
+
+        maxDistSquared = std::max(maxDistSquared, dx * dx + dy * dy + dz * dz);
+    }
+
+    // Round up so rounding the radius can't put a vertex outside the sphere
+    frame->boundSphere = BoundSphere(center, fp::fromFloat(sqrtf(maxDistSquared)) + fp(1));
 }
 
-static void read_boundbox(X_File* file, X_EntityBoundBox* boundBox, Vec3 scale, Vec3 translation)
+static void calculate_face_normals(X_EntityModel* model, X_EntityFrame* frame)
 {
-    read_vertex(file, &boundBox->min, scale, translation);
-    read_vertex(file, &boundBox->max, scale, translation);
+    for(int i = 0; i < model->totalTriangles; ++i)
+    {
+        float v[3][3];
+
+        for(int j = 0; j < 3; ++j)
+        {
+            int id = model->triangles[i].vertexIds[j];
+
+            v[j][0] = frame->vertexX[id].toFloat();
+            v[j][1] = frame->vertexY[id].toFloat();
+            v[j][2] = frame->vertexZ[id].toFloat();
+        }
+
+        // Triangles are visible when their vertices are clockwise on screen, which puts the normal on
+        // the side of (v2 - v0) x (v1 - v0)
+        float a[3] = { v[2][0] - v[0][0], v[2][1] - v[0][1], v[2][2] - v[0][2] };
+        float b[3] = { v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2] };
+
+        float nx = a[1] * b[2] - a[2] * b[1];
+        float ny = a[2] * b[0] - a[0] * b[2];
+        float nz = a[0] * b[1] - a[1] * b[0];
+        float length = sqrtf(nx * nx + ny * ny + nz * nz);
+
+        // Degenerate triangles get a zero normal, so they're never drawn
+        if(length == 0)
+        {
+            frame->faceNormals[i] = Vec3fp(0, 0, 0);
+            continue;
+        }
+
+        frame->faceNormals[i] = Vec3fp(fp::fromFloat(nx / length), fp::fromFloat(ny / length), fp::fromFloat(nz / length));
+    }
 }
 
 static void read_frame(X_EntityModelLoader* loader, X_EntityFrame* frame)
 {
-    read_boundbox(&loader->file, &frame->boundBox, loader->header.scale, loader->header.origin);
+    X_EntityModel* model = loader->modelDest;
+
+    // The stored bound box is quantized to the model's grid, so it's recalculated from the vertices
+    unsigned char packedBoundBox[8];
+    x_file_read_buf(&loader->file, sizeof(packedBoundBox), packedBoundBox);
+
     x_file_read_buf(&loader->file, 16, frame->name);
     
-    frame->vertices = (X_EntityVertex*)x_malloc(sizeof(X_EntityVertex) * loader->header.totalVertices);
-    
     printf("Frame name: %s\n", frame->name);
     
     for(int i = 0; i < loader->header.totalVertices; ++i)
-        read_vertex(&loader->file, frame->vertices + i, loader->header.scale, loader->header.origin);
+        read_vertex(&loader->file, loader->mdlVertices + i, loader->header.scale, loader->header.origin);
+
+    // Positions and normals share one allocation, owned by vertexX
+    fp* positions = (fp*)x_malloc(sizeof(fp) * 3 * model->totalVertices + sizeof(Vec3fp) * model->totalTriangles);
+
+    frame->vertexX = positions;
+    frame->vertexY = positions + model->totalVertices;
+    frame->vertexZ = positions + model->totalVertices * 2;
+    frame->faceNormals = (Vec3fp*)(positions + model->totalVertices * 3);
+
+    for(int i = 0; i < model->totalVertices; ++i)
+    {
+        Vec3fp v = MakeVec3fp(loader->mdlVertices[loader->mdlVertexIds[i]]);
+
+        frame->vertexX[i] = v.x;
+        frame->vertexY[i] = v.y;
+        frame->vertexZ[i] = v.z;
+    }
+
+    calculate_frame_bounds(model, frame);
+    calculate_face_normals(model, frame);
 }
 
 static void read_frame_group(X_EntityModelLoader* loader, X_EntityFrameGroup* group)
 {
-    bool partOfGroup = x_file_read_le_int32(&loader->file);
+    X_File* file = &loader->file;
+    bool partOfGroup = x_file_read_le_int32(file);
     
-    group->totalFrames = (partOfGroup ? x_file_read_le_int32(&loader->file) : 1);
-    group->frames = (X_EntityFrame*)x_malloc(sizeof(X_EntityFrame) * group->totalFrames);
+    group->totalFrames = 1;
+    group->displayDuration = 0;
 
-    if(group->totalFrames != 1)
+    if(partOfGroup)
     {
-        x_system_error("Model %s has a frame group, which is not supported yet (group size = %d)", loader->modelDest->name, group->totalFrames);
+        group->totalFrames = x_file_read_le_int32(file);
+
+        if(group->totalFrames <= 0)
+        {
+            x_system_error("Model %s has an empty frame group", loader->modelDest->name);
+        }
+
+        // Bound box of the whole group, which is recalculated per frame
+        unsigned char packedBoundBox[8];
+        x_file_read_buf(file, sizeof(packedBoundBox), packedBoundBox);
+
+        // Each interval is the time the next frame starts, so the first one is how long a frame is shown
+        for(int i = 0; i < group->totalFrames; ++i)
+        {
+            x_fp16x16 interval = x_file_read_le_float32_as_fp16x16(file);
+
+            if(i == 0)
+                group->displayDuration = interval;
+        }
     }
+
+    group->frames = (X_EntityFrame*)x_malloc(sizeof(X_EntityFrame) * group->totalFrames);
     
     for(int i = 0; i < group->totalFrames; ++i)
         read_frame(loader, group->frames + i);
@@ -203,6 +394,8 @@ static void read_frame_groups(X_EntityModelLoader* loader)
     
     model->totalFrameGroups = loader->header.totalFrames;
     model->frameGroups = (X_EntityFrameGroup*)x_malloc(sizeof(X_EntityFrameGroup) * model->totalFrameGroups);
+
+    loader->mdlVertices = (Vec3*)x_malloc(sizeof(Vec3) * loader->header.totalVertices);
     
     for(int i = 0; i < loader->header.totalFrames; ++i)
         read_frame_group(loader, model->frameGroups + i);
@@ -230,12 +423,23 @@ static void stitch_frames_into_animations(X_EntityModel* model)
     char baseName[16];
     char frameNumber[16];
 
-    model->frameGroups[0].frames[0].nextInSequence = nullptr;
+    // Frames in a group play in order and loop back to the start
+    for(int i = 0; i < model->totalFrameGroups; ++i)
+    {
+        X_EntityFrameGroup* group = model->frameGroups + i;
+
+        for(int j = 0; j < group->totalFrames; ++j)
+        {
+            group->frames[j].nextInSequence = (group->totalFrames > 1 ? group->frames + (j + 1) % group->totalFrames : nullptr);
+        }
+    }
 
     for(int i = 1; i < model->totalFrameGroups; ++i)
     {
+        if(model->frameGroups[i].totalFrames != 1 || model->frameGroups[i - 1].totalFrames != 1)
+            continue;
+
         X_EntityFrame* frame = model->frameGroups[i].frames + 0;
-        frame->nextInSequence = NULL;
         
         if(!split_frame_name_into_base_and_number(frame->name, baseName, frameNumber))
             continue;
@@ -250,21 +454,249 @@ static void stitch_frames_into_animations(X_EntityModel* model)
     }
 }
 
+static void free_mdl_data(X_EntityModelLoader* loader)
+{
+    x_free(loader->mdlTextureCoords);
+    x_free(loader->mdlTriangles);
+    x_free(loader->mdlVertexIds);
+    x_free(loader->mdlVertices);
+}
+
 static bool read_contents(X_EntityModelLoader* loader)
 {
     if(!read_header(loader))
         return 0;
     
+    loader->modelDest->fileData = nullptr;
+
     read_skins(loader);
     read_texture_coords(loader);
     read_triangles(loader);
+    split_seam_vertices(loader);
     read_frame_groups(loader);
     
     stitch_frames_into_animations(loader->modelDest);
+    free_mdl_data(loader);
     
     return 1;
 }
 
+// Checks that count elements starting at offset fit in the file (divides instead of multiplying
+// so a huge count from a corrupt file can't wrap around on a 32-bit size_t)
+static bool section_is_in_file(size_t offset, size_t elementSize, size_t count, size_t fileSize)
+{
+    return offset <= fileSize && offset % 4 == 0 && count <= (fileSize - offset) / elementSize;
+}
+
+static int align_to_4_bytes(int size)
+{
+    return (size + 3) & ~3;
+}
+
+static bool read_model_file_skins(X_EntityModelLoader* loader, X_EntityModelFileHeader* header)
+{
+    X_EntityModel* model = loader->modelDest;
+    size_t fileSize = loader->file.size;
+    size_t offset = header->skinsOffset;
+
+    if(header->skinWidth <= 0 || header->skinWidth > X_ENTITYMODEL_MAX_SKIN_SIZE
+        || header->skinHeight <= 0 || header->skinHeight > X_ENTITYMODEL_MAX_SKIN_SIZE)
+    {
+        x_log_error("Bad model file skin size: %dx%d", header->skinWidth, header->skinHeight);
+        return 0;
+    }
+
+    // Every skin has at least its texture count, so this also bounds the skin allocation
+    if(!section_is_in_file(offset, sizeof(int), header->totalSkins, fileSize))
+        return 0;
+
+    int skinSize = header->skinWidth * header->skinHeight;
+
+    model->totalSkins = header->totalSkins;
+    model->skinWidth = header->skinWidth;
+    model->skinHeight = header->skinHeight;
+    model->skins = (X_EntitySkin*)x_malloc(sizeof(X_EntitySkin) * model->totalSkins);
+
+    for(int i = 0; i < model->totalSkins; ++i)
+    {
+        model->skins[i].totalTextures = 0;
+        model->skins[i].textures = nullptr;
+    }
+
+    for(int i = 0; i < model->totalSkins; ++i)
+    {
+        X_EntitySkin* skin = model->skins + i;
+
+        if(!section_is_in_file(offset, sizeof(int), 1, fileSize))
+            return 0;
+
+        int totalTextures = *(int*)(model->fileData + offset);
+        offset += sizeof(int);
+
+        if(totalTextures <= 0 || !section_is_in_file(offset, sizeof(x_fp16x16) + skinSize, totalTextures, fileSize))
+            return 0;
+
+        x_fp16x16* displayDurations = (x_fp16x16*)(model->fileData + offset);
+        X_Color* texels = (X_Color*)(model->fileData + offset + sizeof(x_fp16x16) * totalTextures);
+
+        skin->totalTextures = totalTextures;
+        skin->textures = (X_EntitySkinTexture*)x_malloc(sizeof(X_EntitySkinTexture) * totalTextures);
+
+        for(int j = 0; j < totalTextures; ++j)
+        {
+            skin->textures[j].displayDuration = displayDurations[j];
+            skin->textures[j].texels = texels + skinSize * j;
+        }
+
+        offset += align_to_4_bytes((sizeof(x_fp16x16) + skinSize) * totalTextures);
+    }
+
+    return 1;
+}
+
+static void read_model_file_frame(X_EntityModel* model, unsigned char* frameData, X_EntityFrame* frame)
+{
+    X_EntityModelFileFrame* fileFrame = (X_EntityModelFileFrame*)frameData;
+
+    memcpy(frame->name, fileFrame->name, sizeof(frame->name));
+    frame->name[sizeof(frame->name) - 1] = '\0';
+
+    frame->boundBox = BoundBox(
+        Vec3(fileFrame->boundBoxMin[0], fileFrame->boundBoxMin[1], fileFrame->boundBoxMin[2]),
+        Vec3(fileFrame->boundBoxMax[0], fileFrame->boundBoxMax[1], fileFrame->boundBoxMax[2]));
+
+    frame->boundSphere = BoundSphere(
+        Vec3fp(fp(fileFrame->boundSphereCenter[0]), fp(fileFrame->boundSphereCenter[1]), fp(fileFrame->boundSphereCenter[2])),
+        fp(fileFrame->boundSphereRadius));
+
+    fp* positions = (fp*)(frameData + sizeof(X_EntityModelFileFrame));
+
+    frame->vertexX = positions;
+    frame->vertexY = positions + model->totalVertices;
+    frame->vertexZ = positions + model->totalVertices * 2;
+    frame->faceNormals = (Vec3fp*)(positions + model->totalVertices * 3);
+}
+
+static bool read_model_file_contents(X_EntityModelLoader* loader)
+{
+    static_assert(sizeof(X_EntityTextureCoord) == 2 * sizeof(int), "Texture coords must match the model file");
+    static_assert(sizeof(X_EntityTriangle) == 3 * sizeof(unsigned short), "Triangles must match the model file");
+    static_assert(sizeof(fp) == sizeof(int) && sizeof(Vec3fp) == 3 * sizeof(int), "Positions must match the model file");
+
+    X_EntityModel* model = loader->modelDest;
+    size_t fileSize = loader->file.size;
+
+    if(fileSize < sizeof(X_EntityModelFileHeader))
+    {
+        x_log_error("Model file is too small to have a header");
+        return 0;
+    }
+
+    model->fileData = (unsigned char*)x_malloc(fileSize);
+    x_file_read_buf(&loader->file, fileSize, model->fileData);
+
+    X_EntityModelFileHeader* header = (X_EntityModelFileHeader*)model->fileData;
+
+    model->totalSkins = 0;
+    model->skins = nullptr;
+    model->totalFrameGroups = 0;
+    model->frameGroups = nullptr;
+
+    if(header->version != X_ENTITYMODEL_FILE_VERSION)
+    {
+        x_log_error("Bad model file version (expected %d): %d", X_ENTITYMODEL_FILE_VERSION, header->version);
+        return 0;
+    }
+
+    if(header->totalSkins <= 0 || header->totalFrames <= 0 || header->totalTriangles < 0 || header->totalTriangles > X_ENTITYMODEL_MAX_TRIANGLES
+        || header->totalVertices <= 0 || header->totalVertices > X_ENTITYMODEL_MAX_VERTICES)
+    {
+        x_log_error("Bad model file counts (%d skins, %d frames, %d vertices, %d triangles)",
+            header->totalSkins, header->totalFrames, header->totalVertices, header->totalTriangles);
+        return 0;
+    }
+
+    model->totalVertices = header->totalVertices;
+    model->totalTriangles = header->totalTriangles;
+
+    size_t frameSize = sizeof(X_EntityModelFileFrame) + 3 * sizeof(fp) * model->totalVertices + sizeof(Vec3fp) * model->totalTriangles;
+
+    if(header->totalFrameGroups <= 0 || header->totalFrameGroups > header->totalFrames)
+    {
+        x_log_error("Bad model file frame group count: %d", header->totalFrameGroups);
+        return 0;
+    }
+
+    if(!section_is_in_file(header->textureCoordsOffset, sizeof(X_EntityTextureCoord), model->totalVertices, fileSize)
+        || !section_is_in_file(header->trianglesOffset, sizeof(X_EntityTriangle), model->totalTriangles, fileSize)
+        || !section_is_in_file(header->frameGroupsOffset, sizeof(X_EntityModelFileFrameGroup), header->totalFrameGroups, fileSize)
+        || !section_is_in_file(header->framesOffset, frameSize, header->totalFrames, fileSize)
+        || !read_model_file_skins(loader, header))
+    {
+        x_log_error("Model file sections extend past the end of the file");
+        return 0;
+    }
+
+    model->textureCoords = (X_EntityTextureCoord*)(model->fileData + header->textureCoordsOffset);
+    model->triangles = (X_EntityTriangle*)(model->fileData + header->trianglesOffset);
+
+    for(int i = 0; i < model->totalTriangles; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            if(model->triangles[i].vertexIds[j] >= model->totalVertices)
+            {
+                x_log_error("Model file has a triangle with a bad vertex id: %d", model->triangles[i].vertexIds[j]);
+                return 0;
+            }
+        }
+    }
+
+    X_EntityModelFileFrameGroup* fileGroups = (X_EntityModelFileFrameGroup*)(model->fileData + header->frameGroupsOffset);
+    int totalGroupedFrames = 0;
+
+    for(int i = 0; i < header->totalFrameGroups; ++i)
+    {
+        if(fileGroups[i].totalFrames <= 0 || fileGroups[i].totalFrames > header->totalFrames - totalGroupedFrames)
+        {
+            x_log_error("Model file frame groups don't add up to %d frames", header->totalFrames);
+            return 0;
+        }
+
+        totalGroupedFrames += fileGroups[i].totalFrames;
+    }
+
+    if(totalGroupedFrames != header->totalFrames)
+    {
+        x_log_error("Model file frame groups don't add up to %d frames", header->totalFrames);
+        return 0;
+    }
+
+    model->totalFrameGroups = header->totalFrameGroups;
+    model->frameGroups = (X_EntityFrameGroup*)x_malloc(sizeof(X_EntityFrameGroup) * model->totalFrameGroups);
+
+    unsigned char* frameData = model->fileData + header->framesOffset;
+
+    for(int i = 0; i < model->totalFrameGroups; ++i)
+    {
+        X_EntityFrameGroup* group = model->frameGroups + i;
+
+        group->totalFrames = fileGroups[i].totalFrames;
+        group->frames = (X_EntityFrame*)x_malloc(sizeof(X_EntityFrame) * group->totalFrames);
+        group->displayDuration = fileGroups[i].displayDuration;
+
+        for(int j = 0; j < group->totalFrames; ++j)
+        {
+            read_model_file_frame(model, frameData, group->frames + j);
+            frameData += frameSize;
+        }
+    }
+
+    stitch_frames_into_animations(model);
+
+    return 1;
+}
+
 static void print_header(X_EntityModelHeader* header)
 {
     printf("Id: %X\n", header->id);
@@ -287,11 +719,38 @@ bool x_entitymodelloader_load_model_from_file(X_EntityModelLoader* loader, const
         return 0;
     
     loader->modelDest = dest;
-    bool success = read_contents(loader);
-    print_header(&loader->header);
+
+    int id = 0;
+    if(loader->file.size >= sizeof(id))
+    {
+        x_file_read_buf(&loader->file, sizeof(id), &id);
+        x_file_seek(&loader->file, 0);
+    }
+
+    bool success;
+    int swappedMagic = 'M' + ('D' << 8) + ('3' << 16) + ('X' << 24);
+
+    if(id == X_ENTITYMODEL_FILE_MAGIC)
+    {
+        success = read_model_file_contents(loader);
+
+        if(!success)
+        {
+            x_entitymodel_cleanup(dest);
+        }
+    }
+    else if(id == swappedMagic)
+    {
+        x_log_error("Model %s was converted for a machine with the other byte order", fileName);
+        success = 0;
+    }
+    else
+    {
+        success = read_contents(loader);
+        print_header(&loader->header);
+    }
     
     x_file_close(&loader->file);
     
     return success;
 }
-
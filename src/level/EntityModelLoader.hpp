@@ -37,13 +37,75 @@ typedef struct X_EntityModelHeader
     x_fp16x16 averageTriangleSize;
 } X_EntityModelHeader;
 
+// X3D's own model format, written by tools/model-convert. Everything is stored in the byte order of
+// the machine it's loaded on, so the whole file is read in one go and the model points into it.
+#define X_ENTITYMODEL_FILE_MAGIC ('X' + ('3' << 8) + ('D' << 16) + ('M' << 24))
+#define X_ENTITYMODEL_FILE_VERSION 2
+
+// Followed by the skins, texture coords, triangles, frame groups, and frames at the given offsets (all 4 byte aligned):
+//    skin:  int totalTextures, x_fp16x16 displayDuration[totalTextures], X_Color texels[totalTextures][skinWidth * skinHeight]
+//    group: X_EntityModelFileFrameGroup
+//    frame: X_EntityModelFileFrame, fp x[totalVertices], y[totalVertices], z[totalVertices], Vec3fp faceNormals[totalTriangles]
+// The frames are stored one group after another, so totalFrames is the sum of the groups' frame counts.
+typedef struct X_EntityModelFileHeader
+{
+    int id;
+    int version;
+    int skinWidth;
+    int skinHeight;
+    int totalSkins;
+    int totalVertices;
+    int totalTriangles;
+    int totalFrames;
+    int skinsOffset;
+    int textureCoordsOffset;
+    int trianglesOffset;
+    int framesOffset;
+    int totalFrameGroups;
+    int frameGroupsOffset;
+} X_EntityModelFileHeader;
+
+typedef struct X_EntityModelFileFrameGroup
+{
+    int totalFrames;
+    x_fp16x16 displayDuration;
+} X_EntityModelFileFrameGroup;
+
+typedef struct X_EntityModelFileFrame
+{
+    char name[16];
+    int boundBoxMin[3];
+    int boundBoxMax[3];
+    int boundSphereCenter[3];
+    int boundSphereRadius;
+} X_EntityModelFileFrame;
+
 struct X_EntityModel;
 
+typedef struct X_EntityModelMdlTextureCoord
+{
+    int s;
+    int t;
+    bool onSeam;
+} X_EntityModelMdlTextureCoord;
+
+typedef struct X_EntityModelMdlTriangle
+{
+    int vertexIds[3];
+    bool facesFront;
+} X_EntityModelMdlTriangle;
+
 typedef struct X_EntityModelLoader
 {
     X_File file;
     X_EntityModelHeader header;
     struct X_EntityModel* modelDest;
+
+    // Quake models store the seam as a flag instead of as separate vertices, so it is split after loading
+    X_EntityModelMdlTextureCoord* mdlTextureCoords;
+    X_EntityModelMdlTriangle* mdlTriangles;
+    int* mdlVertexIds;
+    Vec3* mdlVertices;
 } X_EntityModelLoader;
 
 bool x_entitymodelloader_load_model_from_file(X_EntityModelLoader* loader, const char* fileName, struct X_EntityModel* dest);
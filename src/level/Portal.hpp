@@ -81,8 +81,8 @@ struct Portal
     BoundRect surfaceBoundRect;
 
     BspModel bridgeModel;
-    BspPlane bridgePlanes[6];
-    X_BspClipNode bridgeClipNodes[6];
+    BspPlane bridgePlanes[6 * BSPCLIPHULL_TOTAL];
+    X_BspClipNode bridgeClipNodes[6 * BSPCLIPHULL_TOTAL];
 
 
     Portal* next;
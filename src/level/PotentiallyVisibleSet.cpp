@@ -98,3 +98,13 @@ void DecompressedLeafVisibleSet::markAllLeavesAsVisible(int pvsBytesPerEntry)
 {
     memset(leafPvs, 0xFF, pvsBytesPerEntry);
 }
+
+void DecompressedLeafVisibleSet::addVisibleLeaves(const DecompressedLeafVisibleSet& set, int pvsBytesPerEntry)
+{
+    int totalWords = (pvsBytesPerEntry + sizeof(unsigned int) - 1) / sizeof(unsigned int);
+
+    for(int i = 0; i < totalWords; ++i)
+    {
+        leafPvs[i] |= set.leafPvs[i];
+    }
+}
@@ -67,6 +67,7 @@ public:
     }
     
     void markAllLeavesAsVisible(int pvsBytesPerEntry);
+    void addVisibleLeaves(const DecompressedLeafVisibleSet& set, int pvsBytesPerEntry);
     
 private:
     unsigned int leafPvs[1024 / sizeof(unsigned int)];
@@ -0,0 +1,74 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// Fixed point multiplies on vectors of 16.16 values. Each lane gets the low 32 bits of
+// (a * b) >> 16, which is exactly what fp's operator* gives, so code using these stays
+// bit-identical to the scalar path. The widest kernel the compiler is allowed to use is picked
+// at compile time (e.g. -msse4.1 or -mavx2).
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static inline __m128i x_fp_mul_4(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+    // pmuldq multiplies the even lanes, so the odd lanes are shifted down for a second multiply.
+    // Bits 16..47 of each product are the result: the even ones are shifted down into the low
+    // half of their 64 bits, the odd ones up into the high half.
+    __m128i evenProducts = _mm_mul_epi32(a, b);
+    __m128i oddProducts = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_blend_epi16(_mm_srli_epi64(evenProducts, 16), _mm_slli_epi64(oddProducts, 16), 0xCC);
+#else
+    // SSE2 only has an unsigned 32x32->64 multiply, so the sign is fixed up afterwards
+    __m128i lowHalves = _mm_set_epi32(0, -1, 0, -1);
+
+    __m128i evenProducts = _mm_srli_epi64(_mm_mul_epu32(a, b), 16);
+    __m128i oddProducts = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 16);
+    __m128i product = _mm_or_si128(_mm_and_si128(evenProducts, lowHalves), _mm_andnot_si128(lowHalves, oddProducts));
+
+    // signed(a * b) = unsigned(a * b) - 2^32 * ((a < 0 ? b : 0) + (b < 0 ? a : 0))
+    __m128i correction = _mm_add_epi32(
+        _mm_and_si128(_mm_srai_epi32(a, 31), b),
+        _mm_and_si128(_mm_srai_epi32(b, 31), a));
+
+    return _mm_sub_epi32(product, _mm_slli_epi32(correction, 16));
+#endif
+}
+
+#if defined(__AVX2__)
+
+static inline __m256i x_fp_mul_8(__m256i a, __m256i b)
+{
+    __m256i evenProducts = _mm256_mul_epi32(a, b);
+    __m256i oddProducts = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+
+    return _mm256_blend_epi32(_mm256_srli_epi64(evenProducts, 16), _mm256_slli_epi64(oddProducts, 16), 0xAA);
+}
+
+#endif
+
+#endif
@@ -21,6 +21,7 @@
 #include "render/RenderContext.hpp"
 #include "geo/Ray3.hpp"
 #include "render/Palette.hpp"
+#include "math/FixedPointSimd.hpp"
 
 void Mat4x4::loadIdentity()
 {
@@ -191,6 +192,220 @@ Vec3fp Mat4x4::transformNormal(const Vec3fp& normal) const
         normal.x * elem[2][0] + normal.y * elem[2][1] + normal.z * elem[2][2]);
 }
 
+#if defined(__SSE2__)
+
+#define SHUFFLE_LANES(a, b, i0, i1, i2, i3) \
+    _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(i3, i2, i1, i0)))
+
+// Splits 4 packed Vec3fp's into one register per component
+static inline void load_vec3_4(const Vec3fp* src, __m128i& x, __m128i& y, __m128i& z)
+{
+    const __m128i* packed = (const __m128i*)src;
+
+    __m128i a = _mm_loadu_si128(packed + 0);     // x0 y0 z0 x1
+    __m128i b = _mm_loadu_si128(packed + 1);     // y1 z1 x2 y2
+    __m128i c = _mm_loadu_si128(packed + 2);     // z2 x3 y3 z3
+
+    x = SHUFFLE_LANES(a, SHUFFLE_LANES(b, c, 2, 2, 1, 1), 0, 3, 0, 2);
+    y = SHUFFLE_LANES(SHUFFLE_LANES(a, b, 1, 1, 0, 0), SHUFFLE_LANES(b, c, 3, 3, 2, 2), 0, 2, 0, 2);
+    z = SHUFFLE_LANES(SHUFFLE_LANES(a, b, 2, 2, 1, 1), SHUFFLE_LANES(c, c, 0, 0, 3, 3), 0, 2, 0, 2);
+}
+
+static inline void store_vec3_4(__m128i x, __m128i y, __m128i z, Vec3fp* dest)
+{
+    __m128i* packed = (__m128i*)dest;
+
+    _mm_storeu_si128(packed + 0, SHUFFLE_LANES(SHUFFLE_LANES(x, y, 0, 0, 0, 0), SHUFFLE_LANES(z, x, 0, 0, 1, 1), 0, 2, 0, 2));
+    _mm_storeu_si128(packed + 1, SHUFFLE_LANES(SHUFFLE_LANES(y, z, 1, 1, 1, 1), SHUFFLE_LANES(x, y, 2, 2, 2, 2), 0, 2, 0, 2));
+    _mm_storeu_si128(packed + 2, SHUFFLE_LANES(SHUFFLE_LANES(z, x, 2, 2, 3, 3), SHUFFLE_LANES(y, z, 3, 3, 3, 3), 0, 2, 0, 2));
+}
+
+// Each element of the top 3 rows broadcast to every lane
+struct MatrixLanes
+{
+    MatrixLanes(const Mat4x4& mat, bool translate)
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            for(int j = 0; j < 4; ++j)
+            {
+                int value = (j < 3 || translate ? mat.elem[i][j].internalValue() : 0);
+
+                elem[i][j] = _mm_set1_epi32(value);
+#if defined(__AVX2__)
+                elem8[i][j] = _mm256_set1_epi32(value);
+#endif
+            }
+        }
+    }
+
+    __m128i elem[3][4];
+
+#if defined(__AVX2__)
+    __m256i elem8[3][4];
+#endif
+};
+
+// Same sum as transform(): the w component is 1.0 (or 0 for normals), so the last column is
+// added in as is
+static inline void transform_lanes_4(const MatrixLanes& mat, __m128i& x, __m128i& y, __m128i& z)
+{
+    __m128i result[3];
+
+    for(int i = 0; i < 3; ++i)
+    {
+        __m128i sum = _mm_add_epi32(x_fp_mul_4(mat.elem[i][0], x), x_fp_mul_4(mat.elem[i][1], y));
+        sum = _mm_add_epi32(sum, x_fp_mul_4(mat.elem[i][2], z));
+
+        result[i] = _mm_add_epi32(sum, mat.elem[i][3]);
+    }
+
+    x = result[0];
+    y = result[1];
+    z = result[2];
+}
+
+#if defined(__AVX2__)
+
+static inline void transform_lanes_8(const MatrixLanes& mat, __m256i& x, __m256i& y, __m256i& z)
+{
+    __m256i result[3];
+
+    for(int i = 0; i < 3; ++i)
+    {
+        __m256i sum = _mm256_add_epi32(x_fp_mul_8(mat.elem8[i][0], x), x_fp_mul_8(mat.elem8[i][1], y));
+        sum = _mm256_add_epi32(sum, x_fp_mul_8(mat.elem8[i][2], z));
+
+        result[i] = _mm256_add_epi32(sum, mat.elem8[i][3]);
+    }
+
+    x = result[0];
+    y = result[1];
+    z = result[2];
+}
+
+static inline __m256i combine_lanes(__m128i low, __m128i high)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+#endif
+
+// Returns how many vectors were transformed, the caller finishes off the rest
+static int transform_packed_simd(const Mat4x4& mat, const Vec3fp* src, Vec3fp* dest, int count, bool translate)
+{
+    MatrixLanes lanes(mat, translate);
+    int i = 0;
+
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i x[2], y[2], z[2];
+
+        load_vec3_4(src + i, x[0], y[0], z[0]);
+        load_vec3_4(src + i + 4, x[1], y[1], z[1]);
+
+        __m256i x8 = combine_lanes(x[0], x[1]);
+        __m256i y8 = combine_lanes(y[0], y[1]);
+        __m256i z8 = combine_lanes(z[0], z[1]);
+
+        transform_lanes_8(lanes, x8, y8, z8);
+
+        store_vec3_4(_mm256_castsi256_si128(x8), _mm256_castsi256_si128(y8), _mm256_castsi256_si128(z8), dest + i);
+        store_vec3_4(_mm256_extracti128_si256(x8, 1), _mm256_extracti128_si256(y8, 1), _mm256_extracti128_si256(z8, 1), dest + i + 4);
+    }
+#endif
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i x, y, z;
+
+        load_vec3_4(src + i, x, y, z);
+        transform_lanes_4(lanes, x, y, z);
+        store_vec3_4(x, y, z, dest + i);
+    }
+
+    return i;
+}
+
+static int transform_split_simd(const Mat4x4& mat, const fp* srcX, const fp* srcY, const fp* srcZ, Vec3fp* dest, int count)
+{
+    MatrixLanes lanes(mat, true);
+    int i = 0;
+
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(srcX + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(srcY + i));
+        __m256i z = _mm256_loadu_si256((const __m256i*)(srcZ + i));
+
+        transform_lanes_8(lanes, x, y, z);
+
+        store_vec3_4(_mm256_castsi256_si128(x), _mm256_castsi256_si128(y), _mm256_castsi256_si128(z), dest + i);
+        store_vec3_4(_mm256_extracti128_si256(x, 1), _mm256_extracti128_si256(y, 1), _mm256_extracti128_si256(z, 1), dest + i + 4);
+    }
+#endif
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(srcX + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(srcY + i));
+        __m128i z = _mm_loadu_si128((const __m128i*)(srcZ + i));
+
+        transform_lanes_4(lanes, x, y, z);
+        store_vec3_4(x, y, z, dest + i);
+    }
+
+    return i;
+}
+
+#undef SHUFFLE_LANES
+
+#endif
+
+void Mat4x4::transformPoints(const Vec3fp* src, Vec3fp* dest, int count) const
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    i = transform_packed_simd(*this, src, dest, count, true);
+#endif
+
+    for(; i < count; ++i)
+    {
+        dest[i] = transform(src[i]);
+    }
+}
+
+void Mat4x4::transformPoints(const fp* srcX, const fp* srcY, const fp* srcZ, Vec3fp* dest, int count) const
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    i = transform_split_simd(*this, srcX, srcY, srcZ, dest, count);
+#endif
+
+    for(; i < count; ++i)
+    {
+        dest[i] = transform(Vec3fp(srcX[i], srcY[i], srcZ[i]));
+    }
+}
+
+void Mat4x4::transformNormals(const Vec3fp* src, Vec3fp* dest, int count) const
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    i = transform_packed_simd(*this, src, dest, count, false);
+#endif
+
+    for(; i < count; ++i)
+    {
+        dest[i] = transformNormal(src[i]);
+    }
+}
+
 void Mat4x4::print() const
 {
     for(int i = 0; i < 4; ++i)
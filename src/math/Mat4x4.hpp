@@ -46,6 +46,12 @@ struct Mat4x4
     Vec3fp transform(const Vec3fp& src) const;
     Vec3fp transformNormal(const Vec3fp& normal) const;
 
+    // Batch versions of transform() and transformNormal(), bit-identical to calling them one at a
+    // time. dest may be the same array as src, but they must not otherwise overlap.
+    void transformPoints(const Vec3fp* src, Vec3fp* dest, int count) const;
+    void transformPoints(const fp* srcX, const fp* srcY, const fp* srcZ, Vec3fp* dest, int count) const;
+    void transformNormals(const Vec3fp* src, Vec3fp* dest, int count) const;
+
     void print() const;
 
     void extractViewVectors(Vec3fp& forwardDest, Vec3fp& rightDest, Vec3fp& upDest) const;
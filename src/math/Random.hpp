@@ -0,0 +1,53 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "math/FixedPoint.hpp"
+
+// Linear congruential generator with a fixed default seed, for data that has to come out the same
+// on every run (benchmarks, generated test input). Not for anything that needs good randomness.
+class Random
+{
+public:
+    Random(unsigned int seed_ = 12345)
+        : seed(seed_)
+    {
+
+    }
+
+    unsigned int next()
+    {
+        seed = seed * 1103515245 + 12345;
+
+        return seed;
+    }
+
+    // Scales the whole 32 bit value by the range, so every part of [min, max) can come up
+    int nextInRange(int min, int max)
+    {
+        unsigned int range = (unsigned int)max - (unsigned int)min;
+
+        return min + (int)(((unsigned long long)next() * range) >> 32);
+    }
+
+    fp nextFpInRange(fp min, fp max)
+    {
+        return fp(nextInRange(min.internalValue(), max.internalValue()));
+    }
+
+private:
+    unsigned int seed;
+};
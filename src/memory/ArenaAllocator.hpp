@@ -16,6 +16,7 @@
 #pragma once
 
 #include "Alloc.h"
+#include "MemoryStats.hpp"
 #include "error/Error.hpp"
 
 template<typename T>
@@ -28,6 +29,9 @@ public:
         arenaEnd = arenaStart + maxAllocs;
         nextAlloc = arenaStart;
         name = name_;
+
+        statsTagId = MemoryStats::registerTag(name, MemorySource::arena);
+        MemoryStats::adjustCapacity(statsTagId, sizeof(T) * maxAllocs);
     }
     
     T* alloc()
@@ -40,6 +44,8 @@ public:
     
     void freeAll()
     {
+        MemoryStats::recordArenaReset(statsTagId, totalAllocs() * sizeof(T), totalAllocs());
+
         nextAlloc = arenaStart;
     }
     
@@ -75,6 +81,8 @@ public:
     
     ~ArenaAllocator()
     {
+        MemoryStats::adjustCapacity(statsTagId, -(int)sizeof(T) * maxAllocs());
+
         free(arenaStart);
     }
     
@@ -83,5 +91,6 @@ private:
     T* arenaEnd;
     T* nextAlloc;
     const char* name;
+    int statsTagId;
 };
 
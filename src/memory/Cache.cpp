@@ -15,6 +15,7 @@
 
 #include "Cache.h"
 #include "Alloc.h"
+#include "MemoryStats.hpp"
 #include "error/Log.hpp"
 #include "error/Error.hpp"
 
@@ -51,11 +52,16 @@ void x_cache_init(X_Cache* cache, size_t size, const char* name)
     cache->tail.lruPrev = &cache->head;
     cache->tail.flags = (X_CacheBlockFlags)0;
     
+    cache->statsTagId = MemoryStats::registerTag(name, MemorySource::cache);
+    MemoryStats::adjustCapacity(cache->statsTagId, size);
+    
     x_log("Created cache %s (size = %d bytes)", name, (int)size);    
 }
 
 void x_cache_cleanup(X_Cache* cache)
 {
+    MemoryStats::adjustCapacity(cache->statsTagId, -(int)cache->cacheSize);
+    
     x_free(cache->cacheMem);
 }
 
@@ -136,6 +142,9 @@ static X_CacheBlock* x_cache_try_alloc(X_Cache* cache, size_t size)
             x_cacheblock_split(block, size);
             x_cache_mark_block_as_least_recently_used(cache, block);
             block->flags = (X_CacheBlockFlags)(block->flags & (~X_CACHEBLOCK_FREE));
+            block->pinCount = 0;
+            
+            MemoryStats::recordAlloc(cache->statsTagId, block->size + sizeof(X_CacheBlock));
             
             return block;
         }
@@ -144,8 +153,10 @@ static X_CacheBlock* x_cache_try_alloc(X_Cache* cache, size_t size)
     return NULL;
 }
 
-static void x_cacheblock_free(X_CacheBlock* block)
+static void x_cacheblock_free(X_Cache* cache, X_CacheBlock* block)
 {
+    MemoryStats::recordFree(cache->statsTagId, block->size + sizeof(X_CacheBlock));
+    
     block->cacheEntry->cacheData = NULL;
     block->flags = (X_CacheBlockFlags)(block->flags | X_CACHEBLOCK_FREE);
     
@@ -168,13 +179,13 @@ static bool x_cache_free_least_recently_used_block(X_Cache* cache)
 {
     X_CacheBlock* blockToFree = cache->head.lruNext;
     
+    while(blockToFree != &cache->tail && blockToFree->pinCount > 0)
+        blockToFree = blockToFree->lruNext;
+    
     if(blockToFree == &cache->tail)
         return 0;
     
-    cache->head.lruNext = blockToFree->lruNext;
-    blockToFree->lruNext->lruPrev = &cache->head;
-    
-    x_cacheblock_free(blockToFree);
+    x_cacheblock_free(cache, blockToFree);
     return 1;
 }
 
@@ -216,7 +227,7 @@ void x_cache_flush(X_Cache* cache)
         X_CacheBlock* next = block->next;
         
         if(!x_cacheblock_is_free(block))
-            x_cacheblock_free(block);
+            x_cacheblock_free(cache, block);
         
         block = next;
     }
@@ -224,3 +235,18 @@ void x_cache_flush(X_Cache* cache)
     x_log("Flushed cache %s", cache->name);
 }
 
+void x_cache_pin(X_Cache* cache, X_CacheEntry* entry)
+{
+    x_assert(x_cachentry_is_in_cache(entry), "Pinning entry that isn't in cache %s", cache->name);
+    
+    ++((X_CacheBlock*)entry->cacheData)->pinCount;
+}
+
+void x_cache_unpin(X_Cache* cache, X_CacheEntry* entry)
+{
+    X_CacheBlock* block = (X_CacheBlock*)entry->cacheData;
+    
+    x_assert(block != NULL && block->pinCount > 0, "Unpinning entry that isn't pinned in cache %s", cache->name);
+    
+    --block->pinCount;
+}
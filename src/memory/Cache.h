@@ -39,6 +39,7 @@ typedef struct X_CacheBlock
     struct X_CacheBlock* lruPrev;
     
     X_CacheEntry* cacheEntry;
+    int pinCount;
 } X_CacheBlock;
 
 typedef struct X_Cache
@@ -50,6 +51,8 @@ typedef struct X_Cache
     
     void* cacheMem;
     size_t cacheSize;
+    
+    int statsTagId;
 } X_Cache;
 
 void x_cache_init(X_Cache* cache, size_t size, const char* name);
@@ -60,6 +63,11 @@ void* x_cache_get_cached_data(X_Cache* cache, X_CacheEntry* entry);
 
 void x_cache_flush(X_Cache* cache);
 
+// A pinned entry is never evicted to make room for another one, so its data stays valid while
+// other entries get allocated. Pins nest, and every pin needs an unpin.
+void x_cache_pin(X_Cache* cache, X_CacheEntry* entry);
+void x_cache_unpin(X_Cache* cache, X_CacheEntry* entry);
+
 static inline bool x_cachentry_is_in_cache(const X_CacheEntry* entry)
 {
     return entry->cacheData != NULL;
@@ -0,0 +1,250 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#include <cstdio>
+#include <cstdlib>
+
+#include "FrameAllocator.hpp"
+#include "error/Error.hpp"
+#include "error/Log.hpp"
+#include "util/SpinLock.hpp"
+
+#if X_ENABLE_THREADS
+std::atomic<int> FrameAllocator::currentFrame(0);
+#else
+int FrameAllocator::currentFrame;
+#endif
+
+int FrameAllocator::defaultBufferSize = 256 * 1024;
+
+namespace
+{
+    struct OverflowChunk
+    {
+        OverflowChunk* next;
+    };
+
+    struct FrameBuffer
+    {
+        unsigned char* start = nullptr;
+        int size = 0;
+        int used = 0;
+
+        OverflowChunk* overflowHead = nullptr;
+        int overflowBytes = 0;
+
+        void freeOverflow()
+        {
+            while(overflowHead)
+            {
+                OverflowChunk* next = overflowHead->next;
+                free(overflowHead);
+                overflowHead = next;
+            }
+
+            overflowBytes = 0;
+        }
+
+        void resize(int newSize)
+        {
+            free(start);
+
+            start = (unsigned char*)malloc(newSize);
+
+            if(!start)
+            {
+                x_system_error("Out of memory allocating %d byte frame buffer", newSize);
+            }
+
+            size = newSize;
+        }
+    };
+
+    int roundUpToPage(int size)
+    {
+        const int PAGE_SIZE = 4096;
+
+        return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    }
+
+    unsigned char* alignPointer(unsigned char* ptr, int alignment)
+    {
+        size_t address = (size_t)ptr;
+
+        return (unsigned char*)((address + alignment - 1) & ~(size_t)(alignment - 1));
+    }
+}
+
+struct FrameAllocator::Arena
+{
+    ~Arena()
+    {
+        for(int i = 0; i < 2; ++i)
+        {
+            buffers[i].freeOverflow();
+            free(buffers[i].start);
+        }
+    }
+
+    FrameBuffer& getBufferForFrame(int frame)
+    {
+        FrameBuffer& buffer = buffers[frame & 1];
+
+        if(frame == lastFrame)
+        {
+            return buffer;
+        }
+
+        // The other buffer still holds last frame's allocations, so only this one can be reused.
+        updateHighWaterMark(buffer);
+
+        if(buffer.overflowBytes > 0)
+        {
+            Log::info("Frame allocator overflowed %d byte buffer, high-water mark is %d bytes", buffer.size, highWaterMark);
+        }
+
+        buffer.freeOverflow();
+
+        if(buffer.size < highWaterMark || buffer.start == nullptr)
+        {
+            int newSize = roundUpToPage(highWaterMark > FrameAllocator::defaultBufferSize
+                ? highWaterMark
+                : FrameAllocator::defaultBufferSize);
+
+            buffer.resize(newSize);
+        }
+
+        buffer.used = 0;
+        lastFrame = frame;
+
+        return buffer;
+    }
+
+    void* allocOverflow(FrameBuffer& buffer, int size, int alignment)
+    {
+        int chunkSize = sizeof(OverflowChunk) + alignment + size;
+        OverflowChunk* chunk = (OverflowChunk*)malloc(chunkSize);
+
+        if(!chunk)
+        {
+            x_system_error("Out of memory allocating %d bytes from frame allocator", size);
+        }
+
+        chunk->next = buffer.overflowHead;
+        buffer.overflowHead = chunk;
+        buffer.overflowBytes += size;
+
+        ++totalOverflows;
+        updateHighWaterMark(buffer);
+
+        return alignPointer((unsigned char*)(chunk + 1), alignment);
+    }
+
+    void updateHighWaterMark(FrameBuffer& buffer)
+    {
+        int bytesUsed = buffer.used + buffer.overflowBytes;
+
+        if(bytesUsed > highWaterMark)
+        {
+            highWaterMark = bytesUsed;
+        }
+    }
+
+    FrameBuffer buffers[2];
+    int lastFrame = -1;
+    int highWaterMark = 0;
+    int totalOverflows = 0;
+};
+
+FrameAllocator::Arena& FrameAllocator::getArena()
+{
+    static X_THREAD_LOCAL Arena arena;
+
+    return arena;
+}
+
+void FrameAllocator::init(int bytesPerBuffer)
+{
+    Log::info("Initializing frame allocator (%d bytes per buffer)", bytesPerBuffer);
+
+    defaultBufferSize = bytesPerBuffer;
+}
+
+void FrameAllocator::beginFrame()
+{
+    ++currentFrame;
+}
+
+void FrameAllocator::cleanup()
+{
+    Arena& arena = getArena();
+
+    for(int i = 0; i < 2; ++i)
+    {
+        arena.buffers[i].freeOverflow();
+        free(arena.buffers[i].start);
+
+        arena.buffers[i] = FrameBuffer();
+    }
+
+    arena.lastFrame = -1;
+}
+
+int FrameAllocator::getCurrentFrame()
+{
+    return currentFrame;
+}
+
+void* FrameAllocator::allocBytes(int size, int alignment)
+{
+    Arena& arena = getArena();
+    FrameBuffer& buffer = arena.getBufferForFrame(currentFrame);
+
+    unsigned char* ptr = alignPointer(buffer.start + buffer.used, alignment);
+    unsigned char* end = ptr + size;
+
+    if(end > buffer.start + buffer.size)
+    {
+        return arena.allocOverflow(buffer, size, alignment);
+    }
+
+    buffer.used = end - buffer.start;
+
+    return ptr;
+}
+
+void FrameAllocator::getStats(FrameAllocatorStats& dest)
+{
+    Arena& arena = getArena();
+    FrameBuffer& buffer = arena.buffers[currentFrame & 1];
+    bool usedThisFrame = arena.lastFrame == currentFrame;
+
+    dest.bufferSize = buffer.size;
+    dest.usedBytes = usedThisFrame ? buffer.used : 0;
+    dest.overflowBytes = usedThisFrame ? buffer.overflowBytes : 0;
+    dest.highWaterMark = arena.highWaterMark;
+    dest.totalOverflows = arena.totalOverflows;
+}
+
+void FrameAllocator::print()
+{
+    FrameAllocatorStats stats;
+    getStats(stats);
+
+    printf("=======Frame Allocator=======\n");
+    printf("Frame: %d\n", getCurrentFrame());
+    printf("Used: %d/%d bytes (%d overflow)\n", stats.usedBytes, stats.bufferSize, stats.overflowBytes);
+    printf("High-water mark: %d bytes, %d overflows\n", stats.highWaterMark, stats.totalOverflows);
+    printf("=============================\n");
+}
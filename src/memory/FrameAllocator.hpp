@@ -0,0 +1,71 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include "engine/Config.hpp"
+
+#if X_ENABLE_THREADS
+#include <atomic>
+#endif
+
+struct FrameAllocatorStats
+{
+    int bufferSize;         // Size of each of the two bump buffers
+    int usedBytes;          // Bytes handed out from the current buffer this frame
+    int overflowBytes;      // Bytes that didn't fit and fell back to malloc this frame
+    int highWaterMark;      // Most bytes ever used by a single frame
+    int totalOverflows;
+};
+
+// Scratch memory for data that only needs to live for the current frame and the next one.
+// Each thread gets two bump buffers and flips between them at frame boundaries, so
+// resetting one never invalidates what was allocated last frame. Allocations that don't fit
+// fall back to malloc and the buffer is grown to the high-water mark on its next reset.
+class FrameAllocator
+{
+public:
+    static void init(int bytesPerBuffer);
+    static void beginFrame();
+    static void cleanup();
+
+    template<typename T>
+    static T* alloc(int count = 1)
+    {
+        return (T*)allocBytes(count * sizeof(T), alignof(T));
+    }
+
+    static void* allocBytes(int size, int alignment = ALIGN);
+
+    static int getCurrentFrame();
+
+    // Stats are for the calling thread's arena
+    static void getStats(FrameAllocatorStats& dest);
+    static void print();
+
+private:
+    struct Arena;
+
+    static Arena& getArena();
+
+    static const int ALIGN = 8;
+
+#if X_ENABLE_THREADS
+    static std::atomic<int> currentFrame;
+#else
+    static int currentFrame;
+#endif
+
+    static int defaultBufferSize;
+};
@@ -105,7 +105,7 @@ struct List
 
     static Link* createNode()
     {
-        return Zone::alloc<Link>();
+        return Zone::alloc<Link>(1, ZoneTag::containers);
     }
 
     static void destroyNode(Link* link)
@@ -0,0 +1,130 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+
+// Bounded multi-producer/multi-consumer queue. Each slot carries a sequence number that
+// tells producers and consumers whose turn it is to touch it, so the only contention is
+// a CAS on the head or tail position. Size must be a power of 2.
+template<typename T, int Size>
+class LockFreeQueue
+{
+public:
+    LockFreeQueue()
+        : enqueuePos(0),
+        dequeuePos(0)
+    {
+        static_assert((Size & (Size - 1)) == 0, "LockFreeQueue size must be a power of 2");
+
+        for(int i = 0; i < Size; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Claims a slot and lets fill() write the item in place. Returns false if the queue is full.
+    template<typename Func>
+    bool tryEnqueue(Func&& fill)
+    {
+        unsigned int pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        while(true)
+        {
+            slot = &slots[pos & MASK];
+            unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+            int diff = (int)(sequence - pos);
+
+            if(diff == 0)
+            {
+                if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(slot->item);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Takes the oldest item and hands it to consume(). Returns false if the queue is empty.
+    template<typename Func>
+    bool tryDequeue(Func&& consume)
+    {
+        unsigned int pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        while(true)
+        {
+            slot = &slots[pos & MASK];
+            unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+            int diff = (int)(sequence - (pos + 1));
+
+            if(diff == 0)
+            {
+                if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        consume(slot->item);
+        slot->sequence.store(pos + MASK + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<unsigned int> sequence;
+        T item;
+    };
+
+    static const unsigned int MASK = Size - 1;
+
+    Slot slots[Size];
+
+    // Keep the producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<unsigned int> enqueuePos;
+    alignas(64) std::atomic<unsigned int> dequeuePos;
+};
@@ -23,6 +23,12 @@
 #include "memory/String.h"
 #include "engine/Init.hpp"
 #include "util/Json.hpp"
+#include "util/SpinLock.hpp"
+
+#if X_ENABLE_THREADS
+#include <atomic>
+#include <mutex>
+#endif
 
 unsigned char* Hunk::memoryStart;
 unsigned char* Hunk::memoryEnd;
@@ -30,7 +36,38 @@ unsigned char* Hunk::memoryEnd;
 unsigned char* Hunk::highMark;
 unsigned char* Hunk::lowMark;
 
-Zone::Block* Zone::rover;
+int Hunk::peakUsedBytes;
+
+unsigned int Zone::flBitmap;
+unsigned int Zone::slBitmap[Zone::FL_INDEX_COUNT];
+Zone::Block* Zone::freeLists[Zone::FL_INDEX_COUNT][Zone::SL_INDEX_COUNT];
+
+Zone::Block* Zone::firstBlock;
+int Zone::totalBytes;
+int Zone::usedBytes;
+int Zone::peakUsedBytes;
+int Zone::totalUsedBlocks;
+
+static SpinLock zoneLock;
+
+#if X_ENABLE_THREADS
+static std::atomic<int> zoneCachedBytes(0);
+#else
+static int zoneCachedBytes;
+#endif
+
+struct Zone::ThreadCache
+{
+    Block* head[THREAD_CACHE_TOTAL_CLASSES];
+    int count[THREAD_CACHE_TOTAL_CLASSES];
+};
+
+Zone::ThreadCache& Zone::getThreadCache()
+{
+    static X_THREAD_LOCAL ThreadCache cache;
+
+    return cache;
+}
 
 void Hunk::init(int size)
 {
@@ -73,6 +110,9 @@ void* Hunk::allocLow(int size, const char* name)
     header->size = size;
     header->sentinel = SENTINEL;
 
+    MemoryStats::recordAlloc(MemoryStats::registerTag(name, MemorySource::hunk), size);
+    peakUsedBytes = X_MAX(peakUsedBytes, getUsedBytes());
+
     return header + 1;
 }
 
@@ -96,9 +136,19 @@ void* Hunk::allocHigh(int size, const char* name)
     header->size = size;
     header->sentinel = SENTINEL;
 
+    MemoryStats::recordAlloc(MemoryStats::registerTag(name, MemorySource::hunk), size);
+    peakUsedBytes = X_MAX(peakUsedBytes, getUsedBytes());
+
     return highMark;
 }
 
+void Hunk::getStats(MemorySourceStats& dest)
+{
+    dest.capacityBytes = memoryEnd - memoryStart;
+    dest.usedBytes = getUsedBytes();
+    dest.peakBytes = peakUsedBytes;
+}
+
 void Hunk::print()
 {
     unsigned char* ptr = memoryStart;
@@ -135,223 +185,430 @@ void Cache::freeAbove(void* ptr)
 {
 }
 
-void* Zone::tryAllocChunk(int size)
+static inline int findLastSet(unsigned int x)
 {
-    size = nearestPowerOf2(size + sizeof(Block), 8);
-
-    Block* start = rover;
-    Block* block = rover;
-
-    do
-    {
-        if(block->isFree() && block->getSize() >= size)
-        {
-            break;
-        }
+    return 31 - __builtin_clz(x);
+}
 
-        block = block->next;
+static inline int findFirstSet(unsigned int x)
+{
+    return __builtin_ctz(x);
+}
 
-        if(block == start)
-        {
-            return nullptr;
-        }
+int Zone::getBlockSizeForRequest(int size)
+{
+    size = nearestPowerOf2(size + HEADER_SIZE, ALIGN_SIZE);
 
-    } while(true);
+    return size < MIN_BLOCK_SIZE
+        ? MIN_BLOCK_SIZE
+        : size;
+}
 
-    block->setIsFree(false);
-    block->trySplit(size);
+void Zone::mappingInsert(int size, int& fl, int& sl)
+{
+    if(size < SMALL_BLOCK_SIZE)
+    {
+        fl = 0;
+        sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+    }
+    else
+    {
+        fl = findLastSet(size);
+        sl = (size >> (fl - SL_INDEX_COUNT_LOG2)) ^ (1 << SL_INDEX_COUNT_LOG2);
+        fl -= FL_INDEX_SHIFT - 1;
+    }
+}
 
-    rover = block->next;
+// Rounds the size up to the next list so any block we find there is guaranteed to be big enough
+void Zone::mappingSearch(int size, int& fl, int& sl)
+{
+    if(size >= SMALL_BLOCK_SIZE)
+    {
+        size += (1 << (findLastSet(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
 
-    return chunkFromBlock(block);
+    mappingInsert(size, fl, sl);
 }
 
-void* Zone::allocChunk(int size)
+void Zone::insertFreeBlock(Block* block)
 {
-    void* chunk = tryAllocChunk(size);
+    int fl, sl;
+    mappingInsert(block->getSize(), fl, sl);
 
-    if(!chunk)
+    Block* head = freeLists[fl][sl];
+
+    block->nextFree = head;
+    block->prevFree = nullptr;
+
+    if(head)
     {
-        x_system_error("Can't allocate %d bytes in zone", size);
+        head->prevFree = block;
     }
 
-    return chunk;
+    freeLists[fl][sl] = block;
+
+    flBitmap |= (1u << fl);
+    slBitmap[fl] |= (1u << sl);
+
+    block->setIsFree(true);
 }
 
-void Zone::free(void* mem)
+void Zone::removeFreeBlock(Block* block)
 {
-    if(!mem)
+    int fl, sl;
+    mappingInsert(block->getSize(), fl, sl);
+
+    if(block->prevFree)
     {
-        return;
+        block->prevFree->nextFree = block->nextFree;
     }
+    else
+    {
+        freeLists[fl][sl] = block->nextFree;
 
-    Block* block = blockFromChunk(mem);
+        if(!freeLists[fl][sl])
+        {
+            slBitmap[fl] &= ~(1u << sl);
 
-    block = block->tryMergeWithAdjacentBlocks();
-    block->setIsFree(true);
+            if(!slBitmap[fl])
+            {
+                flBitmap &= ~(1u << fl);
+            }
+        }
+    }
+
+    if(block->nextFree)
+    {
+        block->nextFree->prevFree = block->prevFree;
+    }
+
+    block->setIsFree(false);
 }
 
-enum ReallocSource
+Zone::Block* Zone::findFreeBlock(int size)
 {
-    SOURCE_ZONE = 0,
-    SOURCE_STACK = 1,
-    SOURCE_HEAP = 2
-};
+    int fl, sl;
+    mappingSearch(size, fl, sl);
 
-void* Zone::reallocChunk(void* ptr, int newSize)
-{
-    if(!ptr)
+    if(fl >= FL_INDEX_COUNT)
     {
-        return allocChunk(newSize);
+        return nullptr;
     }
 
-    // Request to shrink the block size
-    Block* block = blockFromChunk(ptr);
-    if(newSize <= block->getSize())
+    unsigned int slMap = slBitmap[fl] & (~0u << sl);
+
+    if(!slMap)
     {
-        auto split = block->trySplit(newSize);
-        if(!split)
+        // Nothing left in this first level, so move up to the next one that has something
+        unsigned int flMap = fl + 1 < 32
+            ? flBitmap & (~0u << (fl + 1))
+            : 0;
+
+        if(!flMap)
         {
-            return ptr;
+            return nullptr;
         }
 
-        split->tryMergeWithAdjacentBlocks();
-
-        return ptr;
+        fl = findFirstSet(flMap);
+        slMap = slBitmap[fl];
     }
 
-    int blockSize = block->getSize();
+    sl = findFirstSet(slMap);
+
+    return freeLists[fl][sl];
+}
+
+// Expects the lock to be held
+Zone::Block* Zone::allocBlock(int size)
+{
+    Block* block = findFreeBlock(size);
 
-    // Try and avoid a copy by merging with the next block (if it's free and is big enough)
-    if(block->next->isFree() && block->next->getSize() + blockSize >= newSize)
+    if(!block)
     {
-        block = block->mergeWithNext(block->next);
-        block->trySplit(newSize);
+        return nullptr;
+    }
+
+    removeFreeBlock(block);
+
+    usedBytes += block->getSize();
+    ++totalUsedBlocks;
+
+    trimUsedBlock(block, size);
+
+    peakUsedBytes = X_MAX(peakUsedBytes, usedBytes);
+
+    return block;
+}
+
+// Expects the lock to be held
+void Zone::releaseBlock(Block* block)
+{
+    Block* prev = block->prevPhysical;
 
-        return ptr;
+    if(prev && prev->isFree())
+    {
+        removeFreeBlock(prev);
+        prev->setSize(prev->getSize() + block->getSize());
+        block = prev;
     }
 
-    // Not ideal, but try and merge with the previous block. This will still cause a copy
-    // but we won't have to do another allocation, a copy, and then a free (which may fail)
-    if(block->prev->isFree() && block->prev->getSize() + blockSize >= newSize)
+    Block* next = block->getNextPhysical();
+
+    if(next->isFree())
     {
-        auto newBlock = block->prev->mergeWithNext(block);
-        void* newChunk = blockFromChunk(newBlock);
+        removeFreeBlock(next);
+        block->setSize(block->getSize() + next->getSize());
+    }
 
-        memmove(newChunk, ptr, blockSize);
+    block->getNextPhysical()->prevPhysical = block;
 
-        auto split = block->trySplit(newSize);
-        if(split)
-        {
-            split->tryMergeWithAdjacentBlocks();
-        }
+    insertFreeBlock(block);
+}
 
-        return ptr;
+// Gives the end of a used block back to the zone if the leftover is big enough to be its own block
+void Zone::trimUsedBlock(Block* block, int size)
+{
+    int sizeLeft = block->getSize() - size;
+
+    if(sizeLeft < MIN_BLOCK_SIZE)
+    {
+        return;
     }
 
-    // Worst case, have to do a new allocation
-    ReallocSource source;
-    void* newChunk = tryAllocChunk(newSize);
-    void* tempBuf = nullptr;
-    void* chunk = nullptr;
+    Block* split = (Block*)((unsigned char*)block + size);
+
+    split->sizeAndFlags = sizeLeft;
+    split->prevPhysical = block;
+    block->setSize(size);
 
-    // Find a temporary place to put the data
-    if(newChunk)
+    usedBytes -= sizeLeft;
+
+    releaseBlock(split);
+}
+
+bool Zone::tryCacheBlock(Block* block)
+{
+    int size = block->getSize();
+
+    if(size > THREAD_CACHE_MAX_BLOCK_SIZE)
     {
-        chunk = ptr;
-        source = SOURCE_ZONE;    
+        return false;
     }
-    else if(newSize <= 1024)
+
+    ThreadCache& zoneThreadCache = getThreadCache();
+    int cacheClass = size / THREAD_CACHE_GRANULARITY;
+
+    if(zoneThreadCache.count[cacheClass] == THREAD_CACHE_MAX_BLOCKS_PER_CLASS)
     {
-        tempBuf = alloca(newSize);
-        source = SOURCE_STACK;
+        return false;
     }
-    else
+
+    block->nextFree = zoneThreadCache.head[cacheClass];
+    zoneThreadCache.head[cacheClass] = block;
+    ++zoneThreadCache.count[cacheClass];
+
+    zoneCachedBytes += size;
+
+    return true;
+}
+
+Zone::Block* Zone::tryTakeCachedBlock(int size)
+{
+    if(size > THREAD_CACHE_MAX_BLOCK_SIZE)
     {
-        // Now we're really getting desperate...
-        tempBuf = malloc(newSize);
-        source = SOURCE_HEAP;
+        return nullptr;
     }
 
-    if(source != SOURCE_ZONE)
+    // Blocks are cached by their size rounded down, so round up to make sure what we get fits
+    ThreadCache& zoneThreadCache = getThreadCache();
+    int cacheClass = (size + THREAD_CACHE_GRANULARITY - 1) / THREAD_CACHE_GRANULARITY;
+
+    if(cacheClass >= THREAD_CACHE_TOTAL_CLASSES || zoneThreadCache.count[cacheClass] == 0)
     {
-        memcpy(tempBuf, ptr, block->getSize());
-        Zone::free(ptr);
-        newChunk = tryAllocChunk(newSize);
-        chunk = tempBuf;
+        return nullptr;
     }
 
-    if(chunk && newChunk)
+    Block* block = zoneThreadCache.head[cacheClass];
+    zoneThreadCache.head[cacheClass] = block->nextFree;
+    --zoneThreadCache.count[cacheClass];
+
+    zoneCachedBytes -= block->getSize();
+
+    return block;
+}
+
+void Zone::flushThreadCache()
+{
+    ThreadCache& zoneThreadCache = getThreadCache();
+    std::lock_guard<SpinLock> guard(zoneLock);
+
+    for(int i = 0; i < THREAD_CACHE_TOTAL_CLASSES; ++i)
     {
-        memmove(newChunk, chunk, blockSize);
+        Block* block = zoneThreadCache.head[i];
+
+        while(block)
+        {
+            Block* next = block->nextFree;
+
+            zoneCachedBytes -= block->getSize();
+            usedBytes -= block->getSize();
+            --totalUsedBlocks;
+
+            releaseBlock(block);
+
+            block = next;
+        }
+
+        zoneThreadCache.head[i] = nullptr;
+        zoneThreadCache.count[i] = 0;
     }
+}
+
+void* Zone::tryAllocChunk(int size, ZoneTag tag)
+{
+    int blockSize = getBlockSizeForRequest(size);
 
-    if(source == SOURCE_HEAP)
+    Block* block = tryTakeCachedBlock(blockSize);
+
+    if(!block)
     {
-        free(tempBuf);
+        std::lock_guard<SpinLock> guard(zoneLock);
+        block = allocBlock(blockSize);
     }
 
-    if(!newChunk)
+    if(!block)
     {
-        x_system_error("Failed to realloc mem in zone of size %d\n", newSize);
+        return nullptr;
     }
 
-    return newChunk;
+    block->tagId = MemoryStats::getZoneTagId(tag);
+    MemoryStats::recordAlloc(block->tagId, block->getSize());
+
+    return chunkFromBlock(block);
 }
 
-Zone::Block* Zone::Block::tryMergeWithAdjacentBlocks()
+void* Zone::allocChunk(int size, ZoneTag tag)
 {
-    Block* block = this;
+    void* chunk = tryAllocChunk(size, tag);
 
-    if(prev->isFree())
+    if(!chunk)
     {
-        block = block->prev->mergeWithNext(block);
+        // The memory we need might be parked in our cache in blocks of the wrong size
+        flushThreadCache();
+        chunk = tryAllocChunk(size, tag);
     }
 
-    if(block->next->isFree())
+    if(!chunk)
     {
-        block = block->mergeWithNext(block->next);
+        x_system_error("Can't allocate %d bytes in zone", size);
     }
 
-    return block;
+    return chunk;
 }
 
-Zone::Block* Zone::Block::mergeWithNext(Block* next)
+void Zone::free(void* mem)
 {
-    if(this == next)
+    if(!mem)
     {
-        return this;
+        return;
     }
 
-    if(Zone::rover == next)
+    Block* block = blockFromChunk(mem);
+
+    MemoryStats::recordFree(block->tagId, block->getSize());
+
+    if(tryCacheBlock(block))
     {
-        Zone::rover = this;
+        return;
     }
 
-    next->unlink();
+    std::lock_guard<SpinLock> guard(zoneLock);
 
-    setSize(getSize() + next->getSize());
+    usedBytes -= block->getSize();
+    --totalUsedBlocks;
 
-    return this;
+    releaseBlock(block);
 }
 
-Zone::Block* Zone::Block::trySplit(int size)
+void* Zone::reallocChunk(void* ptr, int newSize)
 {
-    int sizeLeft = getSize() - size;
-    if(sizeLeft < Block::MIN_SIZE)
+    if(!ptr)
     {
-        return nullptr;
+        return allocChunk(newSize, ZoneTag::general);
     }
 
-    Block* split = (Block*)((unsigned char*)this + size);
+    Block* block = blockFromChunk(ptr);
+    int blockSize = getBlockSizeForRequest(newSize);
+    int oldSize = block->getSize();
+    int tagId = block->tagId;
+
+    {
+        std::lock_guard<SpinLock> guard(zoneLock);
+
+        // Request to shrink the block size
+        if(blockSize <= oldSize)
+        {
+            trimUsedBlock(block, blockSize);
+            MemoryStats::recordResize(tagId, oldSize, block->getSize());
+
+            return ptr;
+        }
+
+        // Try and avoid a copy by merging with the next block (if it's free and is big enough)
+        Block* next = block->getNextPhysical();
+        int nextSize = next->isFree() ? next->getSize() : 0;
+
+        if(oldSize + nextSize >= blockSize)
+        {
+            removeFreeBlock(next);
+
+            block->setSize(oldSize + nextSize);
+            block->getNextPhysical()->prevPhysical = block;
+            usedBytes += nextSize;
+
+            trimUsedBlock(block, blockSize);
+            MemoryStats::recordResize(tagId, oldSize, block->getSize());
+            peakUsedBytes = X_MAX(peakUsedBytes, usedBytes);
+
+            return ptr;
+        }
+
+        // Not ideal, but try and merge with the previous block. This will still cause a copy
+        // but we won't have to do another allocation, a copy, and then a free (which may fail)
+        Block* prev = block->prevPhysical;
+
+        if(prev && prev->isFree() && prev->getSize() + oldSize + nextSize >= blockSize)
+        {
+            removeFreeBlock(prev);
+
+            if(nextSize != 0)
+            {
+                removeFreeBlock(next);
+            }
+
+            prev->setSize(prev->getSize() + oldSize + nextSize);
+            prev->getNextPhysical()->prevPhysical = prev;
+            usedBytes += prev->getSize() - oldSize;
+
+            void* newChunk = chunkFromBlock(prev);
+            memmove(newChunk, ptr, oldSize - HEADER_SIZE);
+
+            prev->tagId = tagId;
+            trimUsedBlock(prev, blockSize);
+            MemoryStats::recordResize(tagId, oldSize, prev->getSize());
+            peakUsedBytes = X_MAX(peakUsedBytes, usedBytes);
+
+            return newChunk;
+        }
+    }
 
-    split->setIsFree(true);
-    split->setSize(sizeLeft);
+    // Worst case, have to do a new allocation
+    void* newChunk = allocChunk(newSize, (ZoneTag)tagId);
 
-    setSize(size);
-    insertAfterThis(split);
+    memcpy(newChunk, ptr, oldSize - HEADER_SIZE);
+    Zone::free(ptr);
 
-    return split;
+    return newChunk;
 }
 
 void Zone::init(int size)
@@ -359,33 +616,86 @@ void Zone::init(int size)
     Log::logSub("Init zone size = %d", size);
 
     unsigned char* mem = (unsigned char*)Hunk::allocLow(size, "zone");
-    Block* block = (Block*)(mem + sizeof(Block));
 
-    block->next = block;
-    block->prev = block;
-    block->setSize(size);
-    block->setIsFree(true);
+    flBitmap = 0;
+
+    for(int i = 0; i < FL_INDEX_COUNT; ++i)
+    {
+        slBitmap[i] = 0;
+
+        for(int j = 0; j < SL_INDEX_COUNT; ++j)
+        {
+            freeLists[i][j] = nullptr;
+        }
+    }
+
+    // One giant free block, followed by an empty used block so we never merge past the end
+    int blockSize = (size - HEADER_SIZE) & ~(ALIGN_SIZE - 1);
+
+    firstBlock = (Block*)mem;
+    firstBlock->prevPhysical = nullptr;
+    firstBlock->sizeAndFlags = blockSize;
 
-    rover = block;
+    Block* sentinel = firstBlock->getNextPhysical();
+    sentinel->prevPhysical = firstBlock;
+    sentinel->sizeAndFlags = 0;
+
+    insertFreeBlock(firstBlock);
+
+    totalBytes = blockSize;
+    usedBytes = 0;
+    peakUsedBytes = 0;
+    totalUsedBlocks = 0;
+}
+
+void Zone::getStats(ZoneStats& dest)
+{
+    std::lock_guard<SpinLock> guard(zoneLock);
+
+    dest.totalBytes = totalBytes;
+    dest.usedBytes = usedBytes;
+    dest.peakUsedBytes = peakUsedBytes;
+    dest.cachedBytes = zoneCachedBytes;
+    dest.freeBytes = totalBytes - usedBytes;
+    dest.totalUsedBlocks = totalUsedBlocks;
+    dest.largestFreeBlock = 0;
+    dest.totalFreeBlocks = 0;
+
+    for(int i = 0; i < FL_INDEX_COUNT; ++i)
+    {
+        for(int j = 0; j < SL_INDEX_COUNT; ++j)
+        {
+            for(Block* block = freeLists[i][j]; block != nullptr; block = block->nextFree)
+            {
+                dest.largestFreeBlock = X_MAX(dest.largestFreeBlock, block->getSize());
+                ++dest.totalFreeBlocks;
+            }
+        }
+    }
 }
 
 void Zone::print()
 {
-    Block* start = rover;
-    Block* block = start;
+    ZoneStats stats;
+    getStats(stats);
 
     printf("============zone============\n");
 
-    do
     {
-        printf("Block size: %d, free: %d, next: %lld, prev: %lld\n",
-            block->getSize(),
-            block->isFree(),
-            (long long)block->next,
-            (long long)block->prev);
+        std::lock_guard<SpinLock> guard(zoneLock);
+
+        for(Block* block = firstBlock; block->getSize() != 0; block = block->getNextPhysical())
+        {
+            printf("Block size: %d, free: %d\n",
+                block->getSize(),
+                block->isFree());
+        }
+    }
 
-        block = block->next;
-    } while(block != start);
+    printf("----------------------------\n");
+    printf("Used: %d/%d bytes (%d cached) in %d blocks\n", stats.usedBytes, stats.totalBytes, stats.cachedBytes, stats.totalUsedBlocks);
+    printf("Free: %d bytes in %d blocks, largest %d\n", stats.freeBytes, stats.totalFreeBlocks, stats.largestFreeBlock);
+    printf("Fragmentation: %.1f%%\n", stats.getFragmentation() * 100.0f);
 
     printf("============================\n");
 }
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "DLink.hpp"
+#include "MemoryStats.hpp"
 
 struct MemoryConfig;
 
@@ -36,6 +37,7 @@ public:
     static void init(int size);
     static void cleanup();
 
+    static void getStats(MemorySourceStats& dest);
     static void print();
 
 private:
@@ -48,6 +50,11 @@ private:
 
     static void printHighHunk(unsigned char* ptr);
 
+    static int getUsedBytes()
+    {
+        return (lowMark - memoryStart) + (memoryEnd - highMark);
+    }
+
     static const unsigned int SENTINEL = 0xEC53DB01;
 
     static unsigned char* memoryStart;
@@ -56,6 +63,8 @@ private:
     static unsigned char* highMark;
     static unsigned char* lowMark;
 
+    static int peakUsedBytes;
+
     friend class Cache;    
 };
 
@@ -86,15 +95,39 @@ private:
     friend class Hunk;
 };
 
+struct ZoneStats
+{
+    int totalBytes;
+    int usedBytes;          // Includes blocks parked in the per-thread caches
+    int peakUsedBytes;
+    int cachedBytes;
+    int freeBytes;
+    int largestFreeBlock;
+    int totalUsedBlocks;
+    int totalFreeBlocks;
+
+    // 0 when all free memory is one block, approaching 1 as it gets scattered into small pieces
+    float getFragmentation() const
+    {
+        return freeBytes == 0
+            ? 0.0f
+            : 1.0f - (float)largestFreeBlock / freeBytes;
+    }
+};
+
+// General purpose allocator. Uses two-level segregated fit (TLSF) so alloc and free are O(1)
+// and fragmentation stays bounded. Small blocks are recycled through a per-thread cache that
+// doesn't need the lock; everything else goes through a spinlock.
 class Zone
 {
 public:
     template<typename T>
-    static T* alloc(int count = 1)
+    static T* alloc(int count = 1, ZoneTag tag = ZoneTag::general)
     {
-        return (T*)allocChunk(count * sizeof(T));
+        return (T*)allocChunk(count * sizeof(T), tag);
     }
 
+    // Keeps the tag the block was allocated with
     template<typename T>
     static T* realloc(T* ptr, int newCount)
     {
@@ -104,58 +137,117 @@ public:
     static void init(int size);
     static void free(void* ptr);
 
+    // Returns the calling thread's cached blocks to the zone. Worker threads should call this
+    // before they exit.
+    static void flushThreadCache();
+
+    static void getStats(ZoneStats& dest);
     static void print();
 
 private:
-    struct Block : DLink<Block>
+    struct Block
     {
         int getSize() const
         {
-            return flags & SIZE_MASK;
+            return sizeAndFlags & SIZE_MASK;
         }
 
         void setSize(int size)
         {
-            flags = (flags & ~SIZE_MASK) | size;
+            sizeAndFlags = (sizeAndFlags & ~SIZE_MASK) | size;
         }
 
         bool isFree() const
         {
-            return (flags & FREE_MASK) != 0;
+            return (sizeAndFlags & FREE_MASK) != 0;
         }
 
         void setIsFree(bool free)
         {
-            flags = (flags & ~FREE_MASK) | ((int)free << FREE_BIT);
+            sizeAndFlags = (sizeAndFlags & ~FREE_MASK) | (unsigned int)free;
+        }
+
+        Block* getNextPhysical()
+        {
+            return (Block*)((unsigned char*)this + getSize());
         }
 
-        Block* mergeWithNext(Block* next);
-        Block* trySplit(int size);
-        Block* tryMergeWithAdjacentBlocks();
+        static const unsigned int FREE_MASK = 1;
+        static const unsigned int SIZE_MASK = ~7u;
 
-        static const int MIN_SIZE = 64;
-        static const unsigned int SIZE_MASK = 0x00FFFFFF;
-        static const int FREE_BIT = 31;
-        static const unsigned int FREE_MASK = (1 << FREE_BIT);
+        Block* prevPhysical;
+        unsigned int sizeAndFlags;
+        int tagId;              // Memory stats tag for used blocks
 
-        unsigned int flags;
+        // Only valid while the block is free (or sitting in a thread cache)
+        Block* nextFree;
+        Block* prevFree;
     };
 
+    struct ThreadCache;
+
+    static const int ALIGN_SIZE_LOG2 = 3;
+    static const int ALIGN_SIZE = 1 << ALIGN_SIZE_LOG2;
+
+    static const int SL_INDEX_COUNT_LOG2 = 4;
+    static const int SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+
+    static const int FL_INDEX_MAX = 30;
+    static const int FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+    static const int FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+
+    // Blocks smaller than this all live in first level 0, split linearly
+    static const int SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT;
+
+    // Everything up to the free list links, rounded up to keep chunks aligned
+    static const int HEADER_SIZE = (sizeof(Block*) + sizeof(int) * 2 + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+    static const int MIN_BLOCK_SIZE = HEADER_SIZE + sizeof(Block*) * 2;
+
+    static const int THREAD_CACHE_GRANULARITY = 16;
+    static const int THREAD_CACHE_MAX_BLOCK_SIZE = 256;
+    static const int THREAD_CACHE_TOTAL_CLASSES = THREAD_CACHE_MAX_BLOCK_SIZE / THREAD_CACHE_GRANULARITY + 1;
+    static const int THREAD_CACHE_MAX_BLOCKS_PER_CLASS = 32;
+
     static Block* blockFromChunk(void* ptr)
     {
-        return (Block *)((unsigned char*)ptr - sizeof(Block));
+        return (Block *)((unsigned char*)ptr - HEADER_SIZE);
     }
 
     static void* chunkFromBlock(Block* block)
     {
-        return (void *)((unsigned char*)block + sizeof(Block));
+        return (void *)((unsigned char*)block + HEADER_SIZE);
     }
 
-    static Block* rover;
+    static int getBlockSizeForRequest(int size);
 
-    static void* tryAllocChunk(int size);
-    static void* allocChunk(int size);
+    static void mappingInsert(int size, int& fl, int& sl);
+    static void mappingSearch(int size, int& fl, int& sl);
+
+    static void insertFreeBlock(Block* block);
+    static void removeFreeBlock(Block* block);
+    static Block* findFreeBlock(int size);
+
+    static Block* allocBlock(int size);
+    static void releaseBlock(Block* block);
+    static void trimUsedBlock(Block* block, int size);
+
+    static ThreadCache& getThreadCache();
+    static bool tryCacheBlock(Block* block);
+    static Block* tryTakeCachedBlock(int size);
+
+    static void* tryAllocChunk(int size, ZoneTag tag);
+    static void* allocChunk(int size, ZoneTag tag);
     static void* reallocChunk(void* ptr, int newSize);
+
+    static unsigned int flBitmap;
+    static unsigned int slBitmap[FL_INDEX_COUNT];
+    static Block* freeLists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+    static Block* firstBlock;
+    static int totalBytes;
+    static int usedBytes;
+    static int peakUsedBytes;
+    static int totalUsedBlocks;
 };
 
 class ConfigurationFile;
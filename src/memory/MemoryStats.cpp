@@ -0,0 +1,287 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#include <cstdio>
+#include <cstring>
+
+#include "MemoryStats.hpp"
+#include "Memory.hpp"
+#include "FrameAllocator.hpp"
+#include "error/Error.hpp"
+#include "util/SpinLock.hpp"
+
+#if X_ENABLE_THREADS
+#include <atomic>
+#include <mutex>
+#endif
+
+#if X_ENABLE_THREADS
+typedef std::atomic<int> Counter;
+#else
+typedef int Counter;
+#endif
+
+struct MemoryStats::Tag
+{
+    char name[16];
+    MemorySource source;
+    Counter capacityBytes;
+    Counter liveBytes;
+    Counter peakBytes;
+    Counter liveAllocs;
+    Counter totalAllocs;
+};
+
+// The zone tags are registered up front so their ids match the enum
+MemoryStats::Tag MemoryStats::tags[MemoryStats::MAX_TAGS] =
+{
+    { "general", MemorySource::zone },
+    { "level", MemorySource::zone },
+    { "json", MemorySource::zone },
+    { "file", MemorySource::zone },
+    { "engine", MemorySource::zone },
+    { "containers", MemorySource::zone }
+};
+
+int MemoryStats::totalTags = (int)ZoneTag::TOTAL;
+
+static SpinLock tagLock;
+
+static const char* sourceNames[] =
+{
+    "hunk",
+    "zone",
+    "cache",
+    "arena",
+    "frame"
+};
+
+int MemoryStats::registerTag(const char* name, MemorySource source)
+{
+    std::lock_guard<SpinLock> guard(tagLock);
+
+    int total = totalTags;
+
+    for(int i = 0; i < total; ++i)
+    {
+        if(tags[i].source == source && strncmp(tags[i].name, name, sizeof(tags[i].name) - 1) == 0)
+        {
+            return i;
+        }
+    }
+
+    if(total == MAX_TAGS)
+    {
+        x_system_error("Too many memory tags (registering %s)", name);
+    }
+
+    Tag& tag = tags[total];
+
+    strncpy(tag.name, name, sizeof(tag.name) - 1);
+    tag.name[sizeof(tag.name) - 1] = '\0';
+    tag.source = source;
+
+    totalTags = total + 1;
+
+    return total;
+}
+
+void MemoryStats::raisePeak(Tag& tag, int liveBytes)
+{
+#if X_ENABLE_THREADS
+    int peak = tag.peakBytes.load(std::memory_order_relaxed);
+
+    while(liveBytes > peak && !tag.peakBytes.compare_exchange_weak(peak, liveBytes, std::memory_order_relaxed))
+    {
+    }
+#else
+    if(liveBytes > tag.peakBytes)
+    {
+        tag.peakBytes = liveBytes;
+    }
+#endif
+}
+
+void MemoryStats::recordAlloc(int tagId, int size)
+{
+    Tag& tag = tags[tagId];
+
+    ++tag.liveAllocs;
+    ++tag.totalAllocs;
+
+    int liveBytes = (tag.liveBytes += size);
+    raisePeak(tag, liveBytes);
+}
+
+void MemoryStats::recordFree(int tagId, int size)
+{
+    Tag& tag = tags[tagId];
+
+    --tag.liveAllocs;
+    tag.liveBytes -= size;
+}
+
+void MemoryStats::recordResize(int tagId, int oldSize, int newSize)
+{
+    Tag& tag = tags[tagId];
+
+    int liveBytes = (tag.liveBytes += newSize - oldSize);
+    raisePeak(tag, liveBytes);
+}
+
+void MemoryStats::recordArenaReset(int tagId, int usedBytes, int totalAllocs)
+{
+    Tag& tag = tags[tagId];
+
+    tag.liveBytes = usedBytes;
+    tag.liveAllocs = totalAllocs;
+    tag.totalAllocs += totalAllocs;
+
+    raisePeak(tag, usedBytes);
+}
+
+void MemoryStats::adjustCapacity(int tagId, int bytes)
+{
+    tags[tagId].capacityBytes += bytes;
+}
+
+int MemoryStats::getTotalTags()
+{
+    std::lock_guard<SpinLock> guard(tagLock);
+
+    return totalTags;
+}
+
+void MemoryStats::getTagStats(int tagId, MemoryTagStats& dest)
+{
+    const Tag& tag = tags[tagId];
+
+    strcpy(dest.name, tag.name);
+    dest.source = tag.source;
+    dest.capacityBytes = tag.capacityBytes;
+    dest.liveBytes = tag.liveBytes;
+    dest.peakBytes = tag.peakBytes;
+    dest.liveAllocs = tag.liveAllocs;
+    dest.totalAllocs = tag.totalAllocs;
+}
+
+void MemoryStats::getSourceStats(MemorySource source, MemorySourceStats& dest)
+{
+    switch(source)
+    {
+        case MemorySource::hunk:
+            Hunk::getStats(dest);
+            return;
+
+        case MemorySource::zone:
+        {
+            ZoneStats zoneStats;
+            Zone::getStats(zoneStats);
+
+            dest.capacityBytes = zoneStats.totalBytes;
+            dest.usedBytes = zoneStats.usedBytes;
+            dest.peakBytes = zoneStats.peakUsedBytes;
+
+            return;
+        }
+
+        case MemorySource::frame:
+        {
+            FrameAllocatorStats frameStats;
+            FrameAllocator::getStats(frameStats);
+
+            dest.capacityBytes = frameStats.bufferSize * 2;
+            dest.usedBytes = frameStats.usedBytes + frameStats.overflowBytes;
+            dest.peakBytes = frameStats.highWaterMark;
+
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    // Caches and arenas are the sum of their tags
+    dest.capacityBytes = 0;
+    dest.usedBytes = 0;
+    dest.peakBytes = 0;
+
+    int total = getTotalTags();
+
+    for(int i = 0; i < total; ++i)
+    {
+        if(tags[i].source == source)
+        {
+            dest.capacityBytes += tags[i].capacityBytes;
+            dest.usedBytes += tags[i].liveBytes;
+            dest.peakBytes += tags[i].peakBytes;
+        }
+    }
+}
+
+const char* MemoryStats::getSourceName(MemorySource source)
+{
+    return sourceNames[(int)source];
+}
+
+bool MemoryStats::dumpJson(const char* fileName)
+{
+    FILE* file = fopen(fileName, "w");
+
+    if(!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "{\n    \"sources\": {\n");
+
+    for(int i = 0; i < (int)MemorySource::TOTAL; ++i)
+    {
+        MemorySourceStats stats;
+        getSourceStats((MemorySource)i, stats);
+
+        fprintf(file, "        \"%s\": { \"capacity\": %d, \"used\": %d, \"peak\": %d }%s\n",
+            sourceNames[i],
+            stats.capacityBytes,
+            stats.usedBytes,
+            stats.peakBytes,
+            i + 1 < (int)MemorySource::TOTAL ? "," : "");
+    }
+
+    fprintf(file, "    },\n    \"tags\": [\n");
+
+    int total = getTotalTags();
+
+    for(int i = 0; i < total; ++i)
+    {
+        MemoryTagStats stats;
+        getTagStats(i, stats);
+
+        // Tag names come from code, so they never need escaping
+        fprintf(file, "        { \"name\": \"%s\", \"source\": \"%s\", \"capacity\": %d, \"live\": %d, \"peak\": %d, \"liveAllocs\": %d, \"totalAllocs\": %d }%s\n",
+            stats.name,
+            sourceNames[(int)stats.source],
+            stats.capacityBytes,
+            stats.liveBytes,
+            stats.peakBytes,
+            stats.liveAllocs,
+            stats.totalAllocs,
+            i + 1 < total ? "," : "");
+    }
+
+    fprintf(file, "    ]\n}\n");
+    fclose(file);
+
+    return true;
+}
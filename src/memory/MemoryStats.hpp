@@ -0,0 +1,94 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+enum class MemorySource
+{
+    hunk,
+    zone,
+    cache,
+    arena,
+    frame,
+    TOTAL
+};
+
+// Tags for zone allocations. They're fixed so they're cheap to pass on every allocation;
+// the hunk, caches and arenas are tagged by the name they're created with instead.
+enum class ZoneTag
+{
+    general,
+    level,
+    json,
+    file,
+    engine,
+    containers,
+    TOTAL
+};
+
+struct MemoryTagStats
+{
+    char name[16];
+    MemorySource source;
+    int capacityBytes;      // Only for tags that reserve memory up front (caches and arenas)
+    int liveBytes;
+    int peakBytes;
+    int liveAllocs;
+    int totalAllocs;
+};
+
+struct MemorySourceStats
+{
+    int capacityBytes;
+    int usedBytes;
+    int peakBytes;
+};
+
+// Tracks live bytes, peak bytes and allocation counts per tag across all of the allocators.
+class MemoryStats
+{
+public:
+    // Returns the id of the tag with the given name and source, creating it if needed
+    static int registerTag(const char* name, MemorySource source);
+
+    static int getZoneTagId(ZoneTag tag)
+    {
+        return (int)tag;
+    }
+
+    static void recordAlloc(int tagId, int size);
+    static void recordFree(int tagId, int size);
+    static void recordResize(int tagId, int oldSize, int newSize);
+
+    // Arenas are reset wholesale, so they report how much they used since the last reset
+    static void recordArenaReset(int tagId, int usedBytes, int totalAllocs);
+    static void adjustCapacity(int tagId, int bytes);
+
+    static int getTotalTags();
+    static void getTagStats(int tagId, MemoryTagStats& dest);
+    static void getSourceStats(MemorySource source, MemorySourceStats& dest);
+    static const char* getSourceName(MemorySource source);
+
+    static bool dumpJson(const char* fileName);
+
+private:
+    struct Tag;
+
+    static void raisePeak(Tag& tag, int liveBytes);
+
+    static const int MAX_TAGS = 64;
+
+    static Tag tags[MAX_TAGS];
+    static int totalTags;
+};
@@ -46,6 +46,11 @@ public:
         return find(val) != end();
     }
 
+    bool isEmpty() const
+    {
+        return begin() == end();
+    }
+
     T* begin()
     {
         return elements.begin();
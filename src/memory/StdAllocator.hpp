@@ -25,7 +25,7 @@ public:
 
     value_type* allocate(std::size_t n)
     {
-        return Zone::alloc<T>(n);
+        return Zone::alloc<T>(n, ZoneTag::containers);
     }
 
     void deallocate(value_type* ptr, std::size_t) noexcept
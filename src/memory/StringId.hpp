@@ -71,6 +71,16 @@ public:
 #endif
     }
 
+    // The string the id was made from, which is only kept in debug builds
+    const char* getOriginalString() const
+    {
+#ifdef DEBUG_STRINGID
+        return originalString;
+#else
+        return nullptr;
+#endif
+    }
+
     static StringId fromString(const char* str)
     {
 #ifdef DEBUG_STRINGID
@@ -20,15 +20,17 @@
 #include "memory/OldLink.hpp"
 #include "memory/BitSet.hpp"
 
-struct X_RayTracer;
 struct Entity;
+struct Ray3;
+struct RayCollision;
 
 typedef enum X_BoxColliderFlags
 {
     X_BOXCOLLIDER_APPLY_GRAVITY = 1,
     X_BOXCOLLIDER_APPLY_FRICTION = 2,
     X_BOXCOLLIDER_ON_GROUND = 4,
-    BOXCOLLIDER_IN_PORTAL = 8
+    BOXCOLLIDER_IN_PORTAL = 8,
+    X_BOXCOLLIDER_RESTING = 16
 } X_BoxColliderFlags;
 
 enum BoxColliderCollisionType
@@ -58,16 +60,28 @@ struct X_BoxCollider
     X_BoxCollider()
         : standingOnEntity(nullptr)
     {
-        static BoundBox box;
+        // Colliders are the player's size unless given a box
+        BoundBox box = x_bspcliphull_get_box(BSPCLIPHULL_PLAYER);
         x_boxcollider_init(this, &box, X_BOXCOLLIDER_APPLY_GRAVITY);
     }
-    
-    bool traceRay(X_RayTracer& tracer);
+
+    // Also picks the clip hull the box is traced through
+    void setBoundBox(const BoundBox& box);
+
+    // Sweeps the box along a ray between two positions of the collider's origin
+    bool traceBox(BspLevel& level, const Ray3& ray, RayCollision& collisionDest);
+
+    // Makes a resting collider run its move traces again on the next step
+    void wake()
+    {
+        flags.reset(X_BOXCOLLIDER_RESTING);
+    }
 
     Flags<X_BoxColliderFlags> flags;
 
     BoundBox boundBox;
     int levelCollisionHull;
+    Vec3fp hullOffset;      // From the collider's origin to where the hull's origin is in the box
     Vec3fp velocity;
     Vec3fp* gravity;
     fp bounceCoefficient;
@@ -76,6 +90,7 @@ struct X_BoxCollider
     BoxColliderCollisionInfo collisionInfo;
 
     Entity* standingOnEntity;
+    Vec3fp restingPosition;     // Only valid while resting
     
     Portal* currentPortal;
     
@@ -19,6 +19,13 @@
 
 void BoxColliderEngine::runStep()
 {
+    if(stillResting())
+    {
+        return;
+    }
+
+    collider.wake();
+
     if(collider.flags.hasFlag(X_BOXCOLLIDER_ON_GROUND) && collider.velocity.y >= fp::fromInt(0))
     {
         applyFriction();
@@ -126,6 +133,7 @@ void BoxColliderEngine::useResultsFromMoveLogic(BoxColliderMoveLogic& moveLogic)
         collider.flags.set(X_BOXCOLLIDER_ON_GROUND);
 
         linkToModelStandingOn(lastHitWall.hitModel);
+        tryStartResting(lastHitWall);
     }
     else
     {
@@ -133,6 +141,31 @@ void BoxColliderEngine::useResultsFromMoveLogic(BoxColliderMoveLogic& moveLogic)
     }
 }
 
+// A resting collider skips its step until it's given a velocity, is moved, or what it's standing on
+// moves (which moves it too)
+bool BoxColliderEngine::stillResting()
+{
+    return collider.flags.hasFlag(X_BOXCOLLIDER_RESTING)
+        && collider.velocity == Vec3fp(0, 0, 0)
+        && transformComponent.getPosition() == collider.restingPosition;
+}
+
+void BoxColliderEngine::tryStartResting(const RayCollision& floor)
+{
+    const fp MAX_RESTING_SPEED = fp::fromFloat(1.0);
+
+    // Stay awake in triggers so they keep getting trigger events
+    if(floor.triggerCollision.hitTrigger || collider.velocity.length() >= MAX_RESTING_SPEED)
+    {
+        return;
+    }
+
+    collider.velocity = Vec3fp(0, 0, 0);
+    collider.restingPosition = transformComponent.getPosition();
+
+    collider.flags.set(X_BOXCOLLIDER_RESTING);
+}
+
 void BoxColliderEngine::applyFriction()
 {
     fp currentSpeed = collider.velocity.length();
@@ -154,7 +187,7 @@ void x_boxcollider_init(X_BoxCollider* collider, BoundBox* boundBox, Flags<X_Box
 {
     static Vec3fp gravity = { 0, fp::fromFloat(320), 0 };
     
-    collider->boundBox = *boundBox;
+    collider->setBoundBox(*boundBox);
     collider->flags = flags;
     collider->gravity = &gravity;
     collider->frictionCoefficient = x_fp16x16_from_float(50.0);
@@ -166,6 +199,68 @@ void x_boxcollider_init(X_BoxCollider* collider, BoundBox* boundBox, Flags<X_Box
     x_link_init_self(&collider->objectsOnModel);
 }
 
+static bool boxFitsInHull(const Vec3& boxSize, BspClipHull hull)
+{
+    const BoundBox& hullBox = x_bspcliphull_get_box(hull);
+    Vec3 hullSize = hullBox.v[1] - hullBox.v[0];
+
+    return boxSize.x <= hullSize.x && boxSize.y <= hullSize.y && boxSize.z <= hullSize.z;
+}
+
+void X_BoxCollider::setBoundBox(const BoundBox& box)
+{
+    const x_fp16x16 MAX_POINT_SIZE = x_fp16x16_from_int(3);
+
+    boundBox = box;
+
+    // Use the smallest hull the box fits in, or the largest if it doesn't fit in any
+    Vec3 size = box.v[1] - box.v[0];
+    BspClipHull hull;
+
+    if(size.x < MAX_POINT_SIZE && size.y < MAX_POINT_SIZE && size.z < MAX_POINT_SIZE)
+    {
+        hull = BSPCLIPHULL_POINT;
+    }
+    else if(boxFitsInHull(size, BSPCLIPHULL_PLAYER))
+    {
+        hull = BSPCLIPHULL_PLAYER;
+    }
+    else
+    {
+        hull = BSPCLIPHULL_LARGE;
+    }
+
+    levelCollisionHull = hull;
+
+    // Line the box up with the hull's box at the feet and centered horizontally
+    const BoundBox& hullBox = x_bspcliphull_get_box(hull);
+
+    Vec3 offset;
+
+    offset.x = (box.v[0].x + box.v[1].x - hullBox.v[0].x - hullBox.v[1].x) / 2;
+    offset.y = box.v[1].y - hullBox.v[1].y;
+    offset.z = (box.v[0].z + box.v[1].z - hullBox.v[0].z - hullBox.v[1].z) / 2;
+
+    hullOffset = MakeVec3fp(offset);
+}
+
+bool X_BoxCollider::traceBox(BspLevel& level, const Ray3& ray, RayCollision& collisionDest)
+{
+    Ray3 hullRay(ray.v[0] + hullOffset, ray.v[1] + hullOffset);
+    BspRayTracer tracer(hullRay, &level, levelCollisionHull);
+
+    bool hitSomething = tracer.trace();
+    collisionDest = tracer.getCollision();
+
+    if(hitSomething)
+    {
+        collisionDest.location.point = collisionDest.location.point - hullOffset;
+        collisionDest.plane.d = -collisionDest.plane.normal.dot(collisionDest.location.point);
+    }
+
+    return hitSomething;
+}
+
 void BoxColliderEngine::resetCollisionState()
 {
     collider.collisionInfo.type = BOXCOLLIDER_COLLISION_NONE;
@@ -61,6 +61,9 @@ private:
 
     void useResultsFromMoveLogic(BoxColliderMoveLogic& moveLogic);
 
+    bool stillResting();
+    void tryStartResting(const RayCollision& floor);
+
     void resetCollisionState();
 
     void unlinkFromModelStandingOn();
@@ -17,8 +17,6 @@
 #include "level/BspLevel.hpp"
 #include "level/Portal.hpp"
 
-using BoxRayTracer = BspRayTracer;
-
 static bool planeIsFloorSurface(const Plane& plane)
 {
     const fp MAX_FLOOR_Y_NORMAL = fp::fromFloat(-0.7);
@@ -162,10 +160,8 @@ bool BoxColliderMoveLogic::tryPushIntoGround(fp distance)
 
 bool BoxColliderMoveLogic::traceRay(const Ray3& ray, RayCollision& collision)
 {
-    BoxRayTracer tracer(ray, &level, 0);
-
-    bool hitSomething = tracer.trace();
-    auto& tracerCollision = tracer.getCollision();
+    RayCollision tracerCollision;
+    bool hitSomething = collider.traceBox(level, ray, tracerCollision);
 
     if(tracerCollision.triggerCollision.hitTrigger)
     {
@@ -106,19 +106,18 @@ void PhysicsEngine::pushBrushEntity(Entity* brushEntity, const Vec3fp& movement,
         {
             // Move the object along with us
             transform->setPosition(transform->getPosition() + movement);
+            boxColliderComponent->wake();
         }
         else
         {
             // Try moving the object into us in the reverse direction that we're moving
             Vec3fp position = transform->getPosition();
             Ray3 ray(position, position - movement);
+            RayCollision collision;
 
-            // For now, we are using hull 0, which is wrong
-            BspRayTracer tracer(ray, &level, 0);
-
-            if(tracer.trace() && tracer.getCollision().entity == brushEntity)
+            if(boxColliderComponent->traceBox(level, ray, collision) && collision.entity == brushEntity)
             {
-                Vec3fp newPosition = tracer.getCollision().location.point + movement;
+                Vec3fp newPosition = collision.location.point + movement;
                 transform->setPosition(newPosition);
 
                 boxColliderComponent->standingOnEntity = brushEntity;
@@ -26,13 +26,13 @@
 #include "Camera.hpp"
 #include "util/StopWatch.hpp"
 #include "geo/Ray3.hpp"
+#include "RenderStats.hpp"
 
-int g_sortCount;
 int g_stackCount;
 
 void x_ae_context_begin_render(X_AE_Context* context, X_RenderContext* renderContext)
 {
-    g_sortCount = 0;
+    context->totalSorts = 0;
     g_stackCount = 0;
 
     context->renderContext = renderContext;
@@ -41,6 +41,8 @@ void x_ae_context_begin_render(X_AE_Context* context, X_RenderContext* renderCon
     
     context->resetArenas();
     context->resetNewEdges();
+    context->resizeVertexCache(renderContext->level->totalVertices);
+    context->resetCoverage();
 }
 
 static bool edge_is_flipped(int edgeId)
@@ -67,9 +69,11 @@ static bool project_polygon3(Polygon3* poly, Mat4x4* viewMatrix, Viewport* viewp
 
     closestZ = maxValue<fp>();
 
+    viewMatrix->transformPoints(poly->vertices, poly->vertices, poly->totalVertices);
+
     for(int i = 0; i < poly->totalVertices; ++i)
     {
-        Vec3fp transformed = viewMatrix->transform(poly->vertices[i]);
+        Vec3fp transformed = poly->vertices[i];
 
         if(transformed.z < minZ)
         {
@@ -92,6 +96,7 @@ static bool project_polygon3(Polygon3* poly, Mat4x4* viewMatrix, Viewport* viewp
 X_AE_Surface* X_AE_Context::createSurface(BspSurface* bspSurface, int bspKey)
 {
     X_AE_Surface* surface = surfaces.alloc();
+    RenderStats::add(RenderCounter::polygonsEmitted);
 
     surface->last = &surface->spanHead;
     surface->bspKey = bspKey;
@@ -314,6 +319,36 @@ Vec3fp transform(Mat4x4& mat, Vec3fp v)
         mat.elem[2][0] * v.x + mat.elem[2][1] * v.y + mat.elem[2][2] * v.z + mat.elem[2][3]);
 }
 
+static const fp MIN_PROJECTED_Z = fp::fromFloat(0.5);
+
+// Level vertices are shared by several faces, so each one is only transformed and projected
+// the first time it's seen in a frame. Only valid for the level model since submodels have
+// their own origin.
+X_AE_CachedVertex* X_AE_Context::getCachedVertex(int vertexId)
+{
+    X_AE_CachedVertex* cached = cachedVertices + vertexId;
+
+    if(cached->frameProjected == renderContext->currentFrame)
+    {
+        return cached;
+    }
+
+    cached->frameProjected = renderContext->currentFrame;
+    cached->transformed = transform(*renderContext->viewMatrix, currentModel->vertices[vertexId].v);
+
+    Vec3fp clamped = cached->transformed;
+
+    if(clamped.z < MIN_PROJECTED_Z)
+    {
+        clamped.z = MIN_PROJECTED_Z;
+    }
+
+    renderContext->cam->viewport.project(clamped, cached->projected);
+    renderContext->cam->viewport.clampfp(cached->projected);
+
+    return cached;
+}
+
 X_AE_Edge* X_AE_Context::addEdgeFromClippedRay(Ray3& clipped, X_AE_Surface* aeSurface, BspEdge* bspEdge, bool lastWasClipped, Vec2& lastProjected)
 {
     Vec2_fp16x16 projected[2];
@@ -358,10 +393,13 @@ void X_AE_Context::processPolygon(BspSurface* bspSurface,
 
     ClipContext context(renderContext->viewFrustum, (int)geoFlags);
 
-    Vec3fp lastTransformed;
     Vec2 lastProjected;
 
-    const fp minZ = fp::fromFloat(0.5);
+    const fp minZ = MIN_PROJECTED_Z;
+
+    // Every edge that bounds the surface, for the coverage buffer
+    X_AE_Edge* surfaceEdges[32 + 1];
+    int totalSurfaceEdges = 0;
 
     for(int i = 0; i < bspSurface->totalEdges; ++i)
     {
@@ -372,33 +410,42 @@ void X_AE_Context::processPolygon(BspSurface* bspSurface,
         context.ray.v[0] = currentModel->vertices[vertexIds[i]].v;
         context.ray.v[1] = currentModel->vertices[vertexIds[next]].v;
 
-        bool lastWasClipped = context.lastVertexWasClipped();
-
         if(!context.clip())
         {
             continue;
         }
 
-        if(lastWasClipped)
-        {
-            context.ray.v[0] = transform(*renderContext->viewMatrix, context.ray.v[0]);
-        }
-        else
+        int rayVertexIds[2] = { vertexIds[i], vertexIds[next] };
+        Vec2_fp16x16 projected[2];
+
+        for(int j = 0; j < 2; ++j)
         {
-            context.ray.v[0] = lastTransformed;
-        }
+            // Endpoints that weren't clipped are still level vertices, so they can come from the cache
+            bool endpointClipped = (context.clipFlags & (1 << j)) == 0;
 
-        context.ray.v[1] = transform(*renderContext->viewMatrix, context.ray.v[1]);
+            if(!endpointClipped)
+            {
+                X_AE_CachedVertex* cached = getCachedVertex(rayVertexIds[j]);
+
+                context.ray.v[j] = cached->transformed;
+                projected[j] = cached->projected;
+            }
+            else
+            {
+                context.ray.v[j] = transform(*renderContext->viewMatrix, context.ray.v[j]);
+            }
 
-        lastTransformed = context.ray.v[1];
+            closestZ = std::min(closestZ, context.ray.v[j].z);
 
-        for(int i = 0; i < 2; ++i)
-        {
-            closestZ = std::min(closestZ, context.ray.v[i].z);
+            if(context.ray.v[j].z < minZ)
+            {
+                context.ray.v[j].z = minZ;
+            }
 
-            if(context.ray.v[i].z < minZ)
+            if(endpointClipped)
             {
-                context.ray.v[i].z = minZ;
+                renderContext->cam->viewport.project(context.ray.v[j], projected[j]);
+                renderContext->cam->viewport.clampfp(projected[j]);
             }
         }
 
@@ -410,12 +457,18 @@ void X_AE_Context::processPolygon(BspSurface* bspSurface,
             if(cachedEdge != nullptr)
             {
                 cachedEdge->emitCachedEdge(aeSurface);
+                surfaceEdges[totalSurfaceEdges++] = cachedEdge;
                 context.clipFlags = 0;
                 continue;
             }
         }
 
-        X_AE_Edge* edge = addEdgeFromClippedRay(context.ray, aeSurface, bspEdge, lastWasClipped, lastProjected);
+        X_AE_Edge* edge = addEdge(projected + 0, projected + 1, aeSurface, bspEdge);
+
+        if(!edge->isHorizontal)
+        {
+            surfaceEdges[totalSurfaceEdges++] = edge;
+        }
 
         if(edge->isLeadingEdge)
         {
@@ -446,7 +499,12 @@ void X_AE_Context::processPolygon(BspSurface* bspSurface,
                 closestZ = std::min(closestZ, ray.v[i].z);
             }
 
-            addEdgeFromClippedRay(ray, aeSurface, currentModel->edges + 0, true, lastProjected);
+            X_AE_Edge* edge = addEdgeFromClippedRay(ray, aeSurface, currentModel->edges + 0, true, lastProjected);
+
+            if(!edge->isHorizontal)
+            {
+                surfaceEdges[totalSurfaceEdges++] = edge;
+            }
         }
     }
 
@@ -473,6 +531,136 @@ void X_AE_Context::processPolygon(BspSurface* bspSurface,
     aeSurface->closestZ = closestZ.toFp16x16();
     
     aeSurface->calculateInverseZGradient(renderContext->camPos, &renderContext->cam->viewport, renderContext->viewMatrix, firstVertex);
+
+    if(renderContext->renderer->occlusionCull)
+    {
+        addSurfaceCoverage(aeSurface, surfaceEdges, totalSurfaceEdges, context.rightClipped);
+    }
+}
+
+// Marks the pixels the surface will be drawn on. Level surfaces arrive front to back, so
+// anything added later that lands on these pixels is hidden. The span bounds are worked out
+// from the edges exactly the way processEdge() will see them.
+void X_AE_Context::addSurfaceCoverage(X_AE_Surface* surface, X_AE_Edge** surfaceEdges, int totalSurfaceEdges, bool rightClipped)
+{
+    const short NO_EDGE = -0x7FFF;
+
+    int top = 0x7FFFFFFF;
+    int bottom = -1;
+
+    for(int i = 0; i < totalSurfaceEdges; ++i)
+    {
+        top = std::min(top, (int)surfaceEdges[i]->startY);
+        bottom = std::max(bottom, (int)surfaceEdges[i]->endY);
+    }
+
+    top = std::max(top, 0);
+    bottom = std::min(bottom, screen->getH() - 1);
+
+    for(int y = top; y <= bottom; ++y)
+    {
+        coverageLeft[y] = NO_EDGE;
+        coverageRight[y] = NO_EDGE;
+    }
+
+    for(int i = 0; i < totalSurfaceEdges; ++i)
+    {
+        X_AE_Edge* edge = surfaceEdges[i];
+
+        // The surface is enabled by edges it's on the right side of
+        short* dest = (edge->surfaces[X_AE_EDGE_RIGHT_SURFACE] == surface ? coverageLeft : coverageRight);
+
+        int startY = std::max((int)edge->startY, top);
+        int endY = std::min((int)edge->endY, bottom);
+
+        fp x = edge->x + edge->xSlope * (startY - edge->startY);
+
+        for(int y = startY; y <= endY; ++y)
+        {
+            dest[y] = x.toInt();
+            x += edge->xSlope;
+        }
+    }
+
+    for(int y = top; y <= bottom; ++y)
+    {
+        int left = coverageLeft[y];
+        int right = coverageRight[y];
+
+        if(left == NO_EDGE)
+        {
+            continue;
+        }
+
+        if(right == NO_EDGE)
+        {
+            if(!rightClipped)
+            {
+                continue;
+            }
+
+            // Stays on the surface stack until the end of the scanline (spans are half-open)
+            right = screen->canvas.getW();
+        }
+
+        coverage.addSpan(y, std::max(left, 0), std::min(right, screen->canvas.getW()));
+    }
+}
+
+bool X_AE_Context::boxIsOccluded(const BoundBox& box)
+{
+    Vec3fp center(
+        fp((box.v[0].x + box.v[1].x) / 2),
+        fp((box.v[0].y + box.v[1].y) / 2),
+        fp((box.v[0].z + box.v[1].z) / 2));
+
+    Vec3fp transformedCenter = transform(*renderContext->viewMatrix, center);
+
+    // Most boxes that aren't occluded have a hole right in the middle, which is much cheaper
+    // to find than projecting all eight corners
+    if(transformedCenter.z >= MIN_PROJECTED_Z)
+    {
+        Vec2_fp16x16 projectedCenter;
+        renderContext->cam->viewport.project(transformedCenter, projectedCenter);
+
+        int x = x_fp16x16_to_int(projectedCenter.x);
+        int y = x_fp16x16_to_int(projectedCenter.y);
+
+        if(x >= 0 && x < screen->getW() && y >= 0 && y < screen->getH() && !coverage.pixelIsCovered(x, y))
+        {
+            return false;
+        }
+    }
+
+    Vec2_fp16x16 min(0x7FFFFFFF, 0x7FFFFFFF);
+    Vec2_fp16x16 max(-0x7FFFFFFF, -0x7FFFFFFF);
+
+    for(int i = 0; i < 8; ++i)
+    {
+        Vec3fp corner(fp(box.v[i & 1].x), fp(box.v[(i >> 1) & 1].y), fp(box.v[(i >> 2) & 1].z));
+        Vec3fp transformed = transform(*renderContext->viewMatrix, corner);
+
+        // Can't bound the projection of anything close to the camera
+        if(transformed.z < MIN_PROJECTED_Z)
+        {
+            return false;
+        }
+
+        Vec2_fp16x16 projected;
+        renderContext->cam->viewport.project(transformed, projected);
+
+        min.x = std::min(min.x, projected.x);
+        min.y = std::min(min.y, projected.y);
+        max.x = std::max(max.x, projected.x);
+        max.y = std::max(max.y, projected.y);
+    }
+
+    // Pad by a pixel for rounding in the projection and edge stepping
+    return coverage.rectIsCovered(
+        x_fp16x16_to_int(min.x) - 1,
+        x_fp16x16_to_int(min.y) - 1,
+        x_fp16x16_to_int(max.x) + 1,
+        x_fp16x16_to_int(max.y) + 1);
 }
 
 void X_AE_Context::addPolygon(Polygon3* polygon, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int* edgeIds, int bspKey, bool inSubmodel)
@@ -543,7 +731,7 @@ void X_AE_Context::addLevelPolygon(BspLevel* level, int* edgeIds, int totalEdges
 
 void X_AE_Context::addSubmodelRecursive(Polygon3* poly, BspNode* node, int* edgeIds, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey)
 {
-    if(!node->isVisibleThisFrame(renderContext->currentFrame))
+    if(!node->isVisibleThisFrame(renderContext->pvsFrame))
         return;
     
     if(poly->totalVertices < 3)
@@ -555,6 +743,11 @@ void X_AE_Context::addSubmodelRecursive(Polygon3* poly, BspNode* node, int* edge
             return;
         
         BspLeaf* leaf = (BspLeaf*)node;
+
+        // Leaf was culled, so its key is left over from an earlier frame
+        if(leaf->bspKeyFrame != renderContext->currentFrame)
+            return;
+
         addPolygon(poly, bspSurface, geoFlags, edgeIds, leaf->bspKey, true);
         return;
     }
@@ -571,12 +764,13 @@ void X_AE_Context::addSubmodelRecursive(Polygon3* poly, BspNode* node, int* edge
     addSubmodelRecursive(&back, node->backChild, backEdges, bspSurface, geoFlags, bspKey);
 }
 
-void X_AE_Context::addSubmodelPolygon(BspLevel* level, int* edgeIds, int totalEdges, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey)
+// The world space vertices are shared between views, which is fine since the root node always
+// splits the polygon into copies before anything touches its vertices
+void X_AE_Context::addSubmodelPolygon(BspLevel* level, const Vec3fp* worldVertices, int* edgeIds, int totalEdges, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey)
 {
     x_ae_surface_reset_current_parent(this);
     
-    InternalPolygon3 poly;
-    get_model_polygon_from_edges(currentModel, edgeIds, totalEdges, &poly, &currentModel->center);
+    Polygon3 poly(const_cast<Vec3fp*>(worldVertices), totalEdges);
     
     addSubmodelRecursive(&poly, &level->getLevelRootNode(), edgeIds, bspSurface, geoFlags, bspKey);
 }
@@ -598,6 +792,61 @@ X_AE_Surface* X_AE_Context::addBrushPolygon(Polygon3& polygon, Plane& polygonPla
     return currentParent;
 }
 
+// Spans must be sorted by y and then by x, which is the order the scan produces them in for a
+// surface. Everything outside of the region is marked as covered, so occlusion culling throws
+// away whatever can only be seen there.
+void X_AE_Context::setDrawRegion(const PortalSpan* regionSpans, const PortalSpan* regionSpansEnd)
+{
+    int screenW = screen->canvas.getW();
+    int screenH = screen->canvas.getH();
+    int totalRegionSpans = regionSpansEnd - regionSpans;
+
+    drawRegionSpans = regionSpans;
+    drawRegionLineStart = FrameAllocator::alloc<int>(screenH + 1);
+
+    int spanId = 0;
+
+    for(int y = 0; y <= screenH; ++y)
+    {
+        while(spanId < totalRegionSpans && regionSpans[spanId].y < y)
+            ++spanId;
+
+        drawRegionLineStart[y] = spanId;
+    }
+
+    for(int y = 0; y < screenH; ++y)
+    {
+        int x = 0;
+
+        for(int i = drawRegionLineStart[y]; i < drawRegionLineStart[y + 1]; ++i)
+        {
+            if(regionSpans[i].left > x)
+                coverage.addSpan(y, x, regionSpans[i].left);
+
+            x = std::max(x, (int)regionSpans[i].right);
+        }
+
+        if(x < screenW)
+            coverage.addSpan(y, x, screenW);
+    }
+}
+
+// Limits drawing to a rectangle of the screen (for a viewport that doesn't cover the whole screen)
+void X_AE_Context::setDrawRect(int left, int top, int right, int bottom)
+{
+    int totalLines = bottom - top;
+    PortalSpan* spans = FrameAllocator::alloc<PortalSpan>(totalLines);
+
+    for(int i = 0; i < totalLines; ++i)
+    {
+        spans[i].left = left;
+        spans[i].right = right;
+        spans[i].y = top + i;
+    }
+
+    setDrawRegion(spans, spans + totalLines);
+}
+
 void X_AE_Context::emitSpan(int left, int right, int y, X_AE_Surface* surface)
 {
     if(left == right)
@@ -605,6 +854,24 @@ void X_AE_Context::emitSpan(int left, int right, int y, X_AE_Surface* surface)
     
     surface = surface->parent;
 
+    if(drawRegionSpans == nullptr)
+    {
+        appendSpan(left, right, y, surface);
+        return;
+    }
+
+    for(int i = drawRegionLineStart[y]; i < drawRegionLineStart[y + 1]; ++i)
+    {
+        int clippedLeft = std::max(left, (int)drawRegionSpans[i].left);
+        int clippedRight = std::min(right, (int)drawRegionSpans[i].right);
+
+        if(clippedLeft < clippedRight)
+            appendSpan(clippedLeft, clippedRight, y, surface);
+    }
+}
+
+void X_AE_Context::appendSpan(int left, int right, int y, X_AE_Surface* surface)
+{
     X_AE_Span* span = spans.alloc();
     
     span->x1 = left;
@@ -725,8 +992,11 @@ void X_AE_Context::addActiveEdge(X_AE_Edge* edge, int y)
     // Advance the edge
     edge->x += edge->xSlope;
     
+    // The list stays sorted from the last scanline, so only edges that crossed their neighbor move
     while(edge->x < edge->prev->x)
     {
+        ++totalSorts;
+
         X_AE_Edge* prev = edge->prev;
         prev->next = edge->next;
         edge->next->prev = prev;
@@ -739,6 +1009,118 @@ void X_AE_Context::addActiveEdge(X_AE_Edge* edge, int y)
     }
 }
 
+static unsigned int new_edge_sort_key(fp x)
+{
+    // Flip the sign bit so signed fixed-point values sort correctly as unsigned
+    return (unsigned int)x.internalValue() ^ 0x80000000u;
+}
+
+static void insertion_sort_new_edges(X_AE_EdgeSortEntry* entries, int count)
+{
+    for(int i = 1; i < count; ++i)
+    {
+        X_AE_EdgeSortEntry entry = entries[i];
+        int j = i - 1;
+
+        while(j >= 0 && entries[j].key > entry.key)
+        {
+            entries[j + 1] = entries[j];
+            --j;
+        }
+
+        entries[j + 1] = entry;
+    }
+}
+
+// Stable LSD radix sort on the 32 bit key, one byte at a time. Returns whichever buffer holds the result.
+static X_AE_EdgeSortEntry* radix_sort_new_edges(X_AE_EdgeSortEntry* entries, X_AE_EdgeSortEntry* temp, int count)
+{
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+        int offsets[256] = { 0 };
+
+        for(int i = 0; i < count; ++i)
+        {
+            ++offsets[(entries[i].key >> shift) & 0xFF];
+        }
+
+        // Every key has the same digit (always true for the high bytes on a small screen)
+        if(offsets[(entries[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        int total = 0;
+
+        for(int i = 0; i < 256; ++i)
+        {
+            int bucketSize = offsets[i];
+            offsets[i] = total;
+            total += bucketSize;
+        }
+
+        for(int i = 0; i < count; ++i)
+        {
+            temp[offsets[(entries[i].key >> shift) & 0xFF]++] = entries[i];
+        }
+
+        X_SWAP(entries, temp);
+    }
+
+    return entries;
+}
+
+// Sorts the edges that start on scanline y by x. Edges at the same x keep the order the old
+// linked list insertion gave them: left edges most recent first, then right edges oldest first.
+int X_AE_Context::sortNewEdges(int y, X_AE_EdgeSortEntry** sortedDest)
+{
+    const int RADIX_SORT_MIN_EDGES = 64;
+
+    // Most scanlines don't start any edges
+    if(newEdges[y].next == &newRightEdge && newEdges[y].rightHead == NULL)
+    {
+        return 0;
+    }
+
+    X_AE_EdgeSortEntry* entries = newEdgeSortBuffer;
+    int count = 0;
+
+    for(X_AE_Edge* edge = newEdges[y].next; edge != &newRightEdge; edge = edge->next)
+    {
+        entries[count].key = new_edge_sort_key(edge->x);
+        entries[count].edge = edge;
+        ++count;
+    }
+
+    int firstRightEdge = count;
+
+    for(X_AE_Edge* edge = newEdges[y].rightHead; edge != NULL; edge = edge->next)
+    {
+        entries[count].key = new_edge_sort_key(edge->x);
+        entries[count].edge = edge;
+        ++count;
+    }
+
+    // Right edges were pushed onto the front of their list, so put them back in the order they were added
+    for(int i = firstRightEdge, j = count - 1; i < j; ++i, --j)
+    {
+        X_SWAP(entries[i], entries[j]);
+    }
+
+    if(count < RADIX_SORT_MIN_EDGES)
+    {
+        insertion_sort_new_edges(entries, count);
+    }
+    else
+    {
+        entries = radix_sort_new_edges(entries, newEdgeSortTemp, count);
+    }
+
+    *sortedDest = entries;
+
+    return count;
+}
+
 void X_AE_Context::processEdges(int y)
 {
     background.crossCount = 1;
@@ -751,25 +1133,25 @@ void X_AE_Context::processEdges(int y)
 
     X_AE_Edge* activeEdge = leftEdge.next;
 
-    X_AE_Edge* newEdge = newEdges[y].next;
+    X_AE_EdgeSortEntry* sortedNewEdges;
+    int totalNewEdges = sortNewEdges(y, &sortedNewEdges);
 
-    
-    while(newEdge != &newRightEdge)
+    // Both lists are sorted, so merge them in one pass
+    for(int i = 0; i < totalNewEdges; ++i)
     {
+        X_AE_Edge* newEdge = sortedNewEdges[i].edge;
+
         while(activeEdge->x <= newEdge->x)
             activeEdge = activeEdge->next;
         
-        X_AE_Edge* newEdgeNext = newEdge->next;
         X_AE_Edge* prev = activeEdge->prev;
         prev->next = newEdge;
         newEdge->prev = prev;
         
         newEdge->next = activeEdge;
         activeEdge->prev = newEdge;
-        
-        newEdge = newEdgeNext;
     }
-    
+
 
     for(X_AE_Edge* edge = leftEdge.next; edge != &rightEdge; )
     {
@@ -837,15 +1219,6 @@ void __attribute__((hot)) x_ae_context_scan_edges(X_AE_Context* context)
     
     // return;
     
-    static bool initialized = 0;
-
-    if(!initialized)
-    {
-        x_console_register_var(context->renderContext->engineContext->console, &g_sortCount, "sortCount", X_CONSOLEVAR_INT, "0", 0);
-        x_console_register_var(context->renderContext->engineContext->console, &g_stackCount, "stackCount", X_CONSOLEVAR_INT, "0", 0);
-        initialized = 1;
-    }
-
     context->resetBackgroundSurface();
 
     // Don't bother removing the edges from the last scanline
@@ -853,13 +1226,21 @@ void __attribute__((hot)) x_ae_context_scan_edges(X_AE_Context* context)
 
     StopWatch::start("scan-active-edge");
     
-    for(int i = 0; i < context->renderContext->cam->viewport.h; ++i)
+    const Viewport& viewport = context->renderContext->cam->viewport;
+
+    for(int i = viewport.screenPos.y; i < viewport.screenPos.y + viewport.h; ++i)
     {
         context->processEdges(i);
     }
 
     StopWatch::stop("scan-active-edge");
 
+    RenderStats::add(RenderCounter::edgesGenerated, context->edges.totalAllocs());
+    RenderStats::add(RenderCounter::spansGenerated, context->spans.totalAllocs());
+    RenderStats::recordUsage(RenderCounter::edgeArena, context->edges.totalAllocs(), context->edges.maxAllocs());
+    RenderStats::recordUsage(RenderCounter::surfaceArena, context->surfaces.totalAllocs(), context->surfaces.maxAllocs());
+    RenderStats::recordUsage(RenderCounter::spanArena, context->spans.totalAllocs(), context->spans.maxAllocs());
+
     StopWatch::start("render-spans");
 
     int count = 0;
@@ -878,11 +1259,19 @@ void __attribute__((hot)) x_ae_context_scan_edges(X_AE_Context* context)
         X_AE_SurfaceRenderContext surfaceRenderContext;
         x_ae_surfacerendercontext_init(&surfaceRenderContext, surface, context->renderContext);
         x_ae_surfacerendercontext_render_spans(&surfaceRenderContext);
+        x_ae_surfacerendercontext_release(&surfaceRenderContext);
     }
 
     StopWatch::stop("render-spans");
 }
 
+// Registered once for the renderer's own context, which draws the views when there's only one
+void x_ae_context_register_console_vars(X_AE_Context* context, Console* console)
+{
+    x_console_register_var(console, &context->totalSorts, "sortCount", X_CONSOLEVAR_INT, "0", 0);
+    x_console_register_var(console, &g_stackCount, "stackCount", X_CONSOLEVAR_INT, "0", 0);
+}
+
 bool x_ae_surface_point_is_in_surface_spans(X_AE_Surface* surface, int x, int y)
 {
     X_AE_Span* span = surface->spanHead.next;
@@ -28,6 +28,10 @@
 #include "memory/BitSet.hpp"
 
 #include "memory/ArenaAllocator.hpp"
+#include "memory/FrameAllocator.hpp"
+#include "CoverageBuffer.hpp"
+
+struct Console;
 
 #define X_AE_SURFACE_MAX_SPANS 332
 
@@ -226,8 +230,27 @@ typedef struct X_AE_DummyEdge
     struct X_AE_Edge* next;
     
     struct X_AE_Edge* deleteHead;
+    
+    // New edges starting on this scanline, unsorted. Edges with a right surface are kept
+    // separately because they sort after left edges at the same x.
+    struct X_AE_Edge* rightHead;
 } X_AE_DummyEdge;
 
+struct X_AE_EdgeSortEntry
+{
+    unsigned int key;
+    X_AE_Edge* edge;
+};
+
+// A level vertex transformed into view space and projected onto the screen. Valid only
+// for the frame it was projected in.
+struct X_AE_CachedVertex
+{
+    int frameProjected;
+    Vec3fp transformed;
+    Vec2_fp16x16 projected;
+};
+
 #define X_ACTIVE_SURFACES_SIZE 32
 
 struct X_AE_Context
@@ -236,7 +259,13 @@ struct X_AE_Context
         : edges(maxEdges, "EdgeArena"),
         surfaces(maxSurfaces, "SurfaceArena"),
         spans(maxSpans, "SpanArena"),
-        screen(screen_)
+        screen(screen_),
+        cachedVertices(nullptr),
+        totalCachedVertices(0),
+        coverageLeft(nullptr),
+        coverageRight(nullptr),
+        drawRegionSpans(nullptr),
+        drawRegionLineStart(nullptr)
     {
         initSentinalEdges();
         initEdges();
@@ -245,7 +274,9 @@ struct X_AE_Context
     
     ~X_AE_Context()
     {
-        x_free(newEdges);
+        x_free(newEdgeSortBuffer);
+        x_free(newEdgeSortTemp);
+        x_free(cachedVertices);
     }
     
     ArenaAllocator<X_AE_Edge> edges;
@@ -255,6 +286,9 @@ struct X_AE_Context
     X_AE_DummyEdge* newEdges;
     X_AE_Edge newRightEdge;
     
+    X_AE_EdgeSortEntry* newEdgeSortBuffer;
+    X_AE_EdgeSortEntry* newEdgeSortTemp;
+    
     X_AE_Edge leftEdge;
     X_AE_Edge rightEdge;
     
@@ -268,20 +302,43 @@ struct X_AE_Context
     
     BspModel* currentModel;
     X_AE_Surface* currentParent;
+    
+    // Indexed by level vertex id
+    X_AE_CachedVertex* cachedVertices;
+    int totalCachedVertices;
+    
+    // Filled from level surfaces as they're added (which is front to back)
+    CoverageBuffer coverage;
+    short* coverageLeft;
+    short* coverageRight;
+    
+    // If set, only these spans of the screen get drawn (for rendering the view through a portal)
+    const PortalSpan* drawRegionSpans;
+    int* drawRegionLineStart;       // Index of the first region span on each scanline
+
+    int totalSorts;                 // Edges moved to keep the active edge list sorted, for the last view
 
-    void addSubmodelPolygon(BspLevel* level, int* edgeIds, int totalEdges, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey);
+    void setDrawRegion(const PortalSpan* spans, const PortalSpan* spansEnd);
+    void setDrawRect(int left, int top, int right, int bottom);
+
+    void addSubmodelPolygon(BspLevel* level, const Vec3fp* worldVertices, int* edgeIds, int totalEdges, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey);
     void addLevelPolygon(BspLevel* level, int* edgeIds, int totalEdges, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey);
 
     // !-- To be made private --!
     X_AE_Edge* getCachedEdge(BspEdge* edge, int currentFrame) const;
+    X_AE_CachedVertex* getCachedVertex(int vertexId);
+    void addSurfaceCoverage(X_AE_Surface* surface, X_AE_Edge** surfaceEdges, int totalSurfaceEdges, bool rightClipped);
+    bool boxIsOccluded(const BoundBox& box);
     X_AE_Surface* createSurface(BspSurface* bspSurface, int bspKey);
     void emitEdges(X_AE_Surface* surface, Vec2_fp16x16* v2d, int totalVertices, int* clippedEdgeIds);
     void addPolygon(Polygon3* polygon, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int* edgeIds, int bspKey, bool inSubmodel);
     void addSubmodelRecursive(Polygon3* poly, BspNode* node, int* edgeIds, BspSurface* bspSurface, BoundBoxFrustumFlags geoFlags, int bspKey);
     void emitSpan(int left, int right, int y, X_AE_Surface* surface);
+    void appendSpan(int left, int right, int y, X_AE_Surface* surface);
 
     void processEdge(X_AE_Edge* edge, int y);
     void addActiveEdge(X_AE_Edge* edge, int y);
+    int sortNewEdges(int y, X_AE_EdgeSortEntry** sortedDest);
     void processEdges(int y);
 
     void processPolygon(BspSurface* bspSurface,
@@ -316,11 +373,12 @@ private:
             edge->bspEdge = NULL;
             edge->frameCreated = -1;
         }
+
+        newEdges = nullptr;
         
-        // FIXME: screen is not getting initalized before calling this;
-        
-        //newEdges = (X_AE_DummyEdge*)x_malloc(x_screen_h(screen) * sizeof(X_AE_DummyEdge));
-        newEdges = (X_AE_DummyEdge*)x_malloc(640 * sizeof(X_AE_DummyEdge));
+        // Worst case is every edge starting on the same scanline
+        newEdgeSortBuffer = (X_AE_EdgeSortEntry*)x_malloc(edges.maxAllocs() * sizeof(X_AE_EdgeSortEntry));
+        newEdgeSortTemp = (X_AE_EdgeSortEntry*)x_malloc(edges.maxAllocs() * sizeof(X_AE_EdgeSortEntry));
     }
     
     void initSurfaces()
@@ -368,8 +426,32 @@ private:
         surfaces.freeAll();
     }
     
+    void resetCoverage()
+    {
+        coverage.reset(screen->getW(), screen->getH());
+        coverageLeft = FrameAllocator::alloc<short>(screen->getH());
+        coverageRight = FrameAllocator::alloc<short>(screen->getH());
+        
+        drawRegionSpans = nullptr;
+    }
+    
+    void resizeVertexCache(int totalVertices)
+    {
+        if(totalVertices <= totalCachedVertices)
+            return;
+        
+        cachedVertices = (X_AE_CachedVertex*)x_realloc(cachedVertices, totalVertices * sizeof(X_AE_CachedVertex));
+        totalCachedVertices = totalVertices;
+        
+        for(int i = 0; i < totalCachedVertices; ++i)
+            cachedVertices[i].frameProjected = -1;
+    }
+    
     void resetNewEdges()
     {
+        // Sized to the screen every frame, so it follows video restarts
+        newEdges = FrameAllocator::alloc<X_AE_DummyEdge>(screen->getH());
+
         newRightEdge.x = rightEdge.x;
         newRightEdge.next = &newRightEdge;    // Loop back around
         
@@ -379,39 +461,32 @@ private:
             newEdges[i].next = (X_AE_Edge*)&newRightEdge;
             newEdges[i].x = x_fp16x16_from_float(-1000);
             newEdges[i].deleteHead = NULL;
+            newEdges[i].rightHead = NULL;
         }
     }
     
     bool addEdgeToStartingScanline(X_AE_Edge* newEdge)
     {
-        X_AE_Edge* edge = (X_AE_Edge*)&newEdges[newEdge->startY];
-        
-        // FIXME: why is this check here?
-        if(!edge)
-            return false;
-        
         if(newEdge->endY < 0)
             return false;
         
         newEdge->nextDelete = newEdges[newEdge->endY].deleteHead;
         newEdges[newEdge->endY].deleteHead = newEdge;
         
-        fp edgeX = newEdge->x;
+        // Sorted when the scanline is processed (see sortNewEdges())
+        X_AE_DummyEdge* scanline = &newEdges[newEdge->startY];
         
         if(newEdge->surfaces[X_AE_EDGE_RIGHT_SURFACE] != NULL)
         {
-            edgeX += fp(1);
+            newEdge->next = scanline->rightHead;
+            scanline->rightHead = newEdge;
         }
-        
-        // TODO: the edges should be moved into an array in sorted - doing it a linked list is O(n^2)
-        while(edge->next->x < edgeX)
+        else
         {
-            edge = edge->next;
+            newEdge->next = scanline->next;
+            scanline->next = newEdge;
         }
         
-        newEdge->next = edge->next;
-        edge->next = newEdge;
-        
         return true;
     }
     
@@ -444,6 +519,8 @@ void x_ae_context_begin_render(X_AE_Context* context, X_RenderContext* renderCon
 
 void x_ae_context_scan_edges(X_AE_Context* context);
 
+void x_ae_context_register_console_vars(X_AE_Context* context, Console* console);
+
 int x_ae_context_find_surface_point_is_in(X_AE_Context* context, int x, int y, BspLevel* level);
 
 static inline fp x_ae_surface_calculate_inverse_z_at_screen_point(const X_AE_Surface* surface, int x, int y)
@@ -34,3 +34,11 @@ void Camera::updateFrustum()
     viewport.updateFrustum(position, forward, right, up);
 }
 
+void Camera::updateFrustumForScreenRect(const Vec2& topLeft, const Vec2& bottomRight)
+{
+    Vec3fp forward, up, right;
+    viewMatrix.extractViewVectors(forward, right, up);
+
+    viewport.updateFrustumForScreenRect(position, forward, right, up, topLeft, bottomRight);
+}
+
@@ -35,6 +35,7 @@ class EntityBuilder;
 struct Camera
 {
     void updateFrustum();
+    void updateFrustumForScreenRect(const Vec2& topLeft, const Vec2& bottomRight);
     void overrideBspLeaf(int leafId, BspLevel* level);
 
     Flags<CameraobjectFlags> flags;
@@ -0,0 +1,92 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+
+#include "CoverageBuffer.hpp"
+#include "memory/Alloc.h"
+
+CoverageBuffer::~CoverageBuffer()
+{
+    x_free(bits);
+}
+
+void CoverageBuffer::reset(int screenW, int screenH)
+{
+    int newWordsPerScanline = (screenW + 63) / 64;
+
+    if(screenH != h || newWordsPerScanline != wordsPerScanline)
+    {
+        bits = (uint64_t*)x_realloc(bits, screenH * newWordsPerScanline * sizeof(uint64_t));
+    }
+
+    w = screenW;
+    h = screenH;
+    wordsPerScanline = newWordsPerScanline;
+    isEmpty = true;
+
+    memset(bits, 0, h * wordsPerScanline * sizeof(uint64_t));
+}
+
+bool CoverageBuffer::rectIsCovered(int left, int top, int right, int bottom) const
+{
+    if(isEmpty)
+    {
+        return false;
+    }
+
+    left = std::max(left, 0);
+    right = std::min(right, w - 1);
+    top = std::max(top, 0);
+    bottom = std::min(bottom, h - 1);
+
+    if(left > right)
+    {
+        return true;
+    }
+
+    int firstWord = left >> 6;
+    int lastWord = right >> 6;
+
+    uint64_t firstMask = maskFrom(left);
+    uint64_t lastMask = maskTo(right);
+
+    if(firstWord == lastWord)
+    {
+        firstMask &= lastMask;
+        lastMask = firstMask;
+    }
+
+    for(int y = top; y <= bottom; ++y)
+    {
+        const uint64_t* scanline = bits + y * wordsPerScanline;
+
+        if((scanline[firstWord] & firstMask) != firstMask || (scanline[lastWord] & lastMask) != lastMask)
+        {
+            return false;
+        }
+
+        for(int i = firstWord + 1; i < lastWord; ++i)
+        {
+            if(scanline[i] != ~(uint64_t)0)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+// Records which pixels are already covered by geometry drawn earlier in the frame. Since the
+// level is drawn front to back, anything whose screen footprint is completely covered can be
+// skipped. Stored as one bit per pixel, 64 pixels to a word.
+class CoverageBuffer
+{
+public:
+    CoverageBuffer()
+        : bits(nullptr),
+        w(0),
+        h(0),
+        wordsPerScanline(0),
+        isEmpty(true)
+    {
+
+    }
+
+    ~CoverageBuffer();
+
+    void reset(int screenW, int screenH);
+
+    // Marks pixels [left, right) on scanline y, which must already be on screen
+    void addSpan(int y, int left, int right)
+    {
+        if(left >= right)
+        {
+            return;
+        }
+
+        uint64_t* scanline = bits + y * wordsPerScanline;
+
+        int last = right - 1;
+        int firstWord = left >> 6;
+        int lastWord = last >> 6;
+
+        if(firstWord == lastWord)
+        {
+            scanline[firstWord] |= maskFrom(left) & maskTo(last);
+        }
+        else
+        {
+            scanline[firstWord] |= maskFrom(left);
+
+            for(int i = firstWord + 1; i < lastWord; ++i)
+            {
+                scanline[i] = ~(uint64_t)0;
+            }
+
+            scanline[lastWord] |= maskTo(last);
+        }
+
+        isEmpty = false;
+    }
+
+    // Rectangle is inclusive and is clamped to the screen
+    bool rectIsCovered(int left, int top, int right, int bottom) const;
+
+    bool pixelIsCovered(int x, int y) const
+    {
+        if(x < 0 || x >= w || y < 0 || y >= h)
+        {
+            return false;
+        }
+
+        return (bits[y * wordsPerScanline + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+private:
+    static uint64_t maskFrom(int x)
+    {
+        return ~(uint64_t)0 << (x & 63);
+    }
+
+    static uint64_t maskTo(int x)
+    {
+        return ~(uint64_t)0 >> (63 - (x & 63));
+    }
+
+    uint64_t* bits;
+    int w;
+    int h;
+    int wordsPerScanline;
+    bool isEmpty;
+};
+
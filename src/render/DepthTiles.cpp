@@ -0,0 +1,126 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "DepthTiles.hpp"
+#include "memory/Alloc.h"
+
+DepthTiles::~DepthTiles()
+{
+    x_free(tiles);
+}
+
+static inline x_fp0x16 farthest_depth_in_row(const x_fp0x16* row, int count)
+{
+    x_fp0x16 farthest = row[0];
+
+#if defined(__SSE2__)
+    if(count == DepthTiles::TILE_SIZE)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)row);
+        __m128i b = _mm_loadu_si128((const __m128i*)(row + 8));
+        __m128i m = _mm_min_epi16(a, b);
+
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 8));
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 4));
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 2));
+
+        return (x_fp0x16)_mm_cvtsi128_si32(m);
+    }
+#endif
+
+    for(int i = 1; i < count; ++i)
+    {
+        farthest = std::min(farthest, row[i]);
+    }
+
+    return farthest;
+}
+
+void DepthTiles::build(const x_fp0x16* zbuf, int screenW, int screenH)
+{
+    int newTilesW = (screenW + TILE_SIZE - 1) >> TILE_SHIFT;
+    int newTilesH = (screenH + TILE_SIZE - 1) >> TILE_SHIFT;
+
+    if(newTilesW != tilesW || newTilesH != tilesH)
+    {
+        tiles = (x_fp0x16*)x_realloc(tiles, newTilesW * newTilesH * sizeof(x_fp0x16));
+        tilesW = newTilesW;
+        tilesH = newTilesH;
+    }
+
+    for(int tileY = 0; tileY < tilesH; ++tileY)
+    {
+        int top = tileY << TILE_SHIFT;
+        int bottom = std::min(top + TILE_SIZE, screenH);
+
+        for(int tileX = 0; tileX < tilesW; ++tileX)
+        {
+            int left = tileX << TILE_SHIFT;
+            int count = std::min(TILE_SIZE, screenW - left);
+
+            x_fp0x16 farthest = farthest_depth_in_row(zbuf + top * screenW + left, count);
+
+            for(int y = top + 1; y < bottom; ++y)
+            {
+                farthest = std::min(farthest, farthest_depth_in_row(zbuf + y * screenW + left, count));
+            }
+
+            tiles[tileY * tilesW + tileX] = farthest;
+        }
+    }
+
+    isValid = true;
+}
+
+bool DepthTiles::rectIsHidden(const x_fp0x16* zbuf, int screenW, int screenH, int left, int top, int right, int bottom, int closestZ)
+{
+    left = std::max(left, 0);
+    right = std::min(right, screenW - 1);
+    top = std::max(top, 0);
+    bottom = std::min(bottom, screenH - 1);
+
+    if(left > right || top > bottom)
+    {
+        return true;
+    }
+
+    if(!isValid)
+    {
+        build(zbuf, screenW, screenH);
+    }
+
+    for(int tileY = top >> TILE_SHIFT; tileY <= (bottom >> TILE_SHIFT); ++tileY)
+    {
+        const x_fp0x16* row = tiles + tileY * tilesW;
+
+        for(int tileX = left >> TILE_SHIFT; tileX <= (right >> TILE_SHIFT); ++tileX)
+        {
+            // The depth test passes if z >= zbuf, so it can pass somewhere in this tile
+            if(closestZ >= row[tileX])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
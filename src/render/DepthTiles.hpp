@@ -0,0 +1,58 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "math/FixedPoint.hpp"
+
+// Coarse copy of the z-buffer that holds the farthest depth in each tile of the screen. A triangle
+// whose closest point is farther than that can't pass the depth test anywhere in the tile. The
+// tiles are built the first time they're needed after invalidate(), which has to be called after
+// the level is drawn. Drawing models only ever brings depth closer, so the tiles stay conservative
+// while they're drawn.
+class DepthTiles
+{
+public:
+    DepthTiles()
+        : tiles(nullptr),
+        tilesW(0),
+        tilesH(0),
+        isValid(false)
+    {
+
+    }
+
+    ~DepthTiles();
+
+    void invalidate()
+    {
+        isValid = false;
+    }
+
+    // Rect is inclusive and is clamped to the screen. closestZ is in the same units as the z-buffer.
+    bool rectIsHidden(const x_fp0x16* zbuf, int screenW, int screenH, int left, int top, int right, int bottom, int closestZ);
+
+    static const int TILE_SHIFT = 4;
+    static const int TILE_SIZE = 1 << TILE_SHIFT;
+
+private:
+    void build(const x_fp0x16* zbuf, int screenW, int screenH);
+
+    x_fp0x16* tiles;
+    int tilesW;
+    int tilesH;
+    bool isValid;
+};
+
@@ -32,6 +32,7 @@ typedef struct X_Light
     Vec3fp position;
     Vec3fp direction;
     x_fp24x8 intensity;
+    unsigned int version;       // Renderer light version when the light last changed
 } X_Light;
 
 static inline bool x_light_is_free(X_Light* light)
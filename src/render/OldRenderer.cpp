@@ -29,6 +29,7 @@
 #include "entity/component/TransformComponent.hpp"
 #include "entity/Entity.hpp"
 #include "level/LevelManager.hpp"
+#include "RenderStats.hpp"
 
 static void x_renderer_init_console_vars(OldRenderer* renderer, Console* console)
 {
@@ -37,6 +38,12 @@ static void x_renderer_init_console_vars(OldRenderer* renderer, Console* console
     x_console_register_var(console, &renderer->frustumClip, "frustumClip", X_CONSOLEVAR_BOOL, "1", 0);
     x_console_register_var(console, &renderer->wireframe, "wireframe", X_CONSOLEVAR_BOOL, "0", 0);
     x_console_register_var(console, &renderer->maxFramesPerSecond, "maxFps", X_CONSOLEVAR_INT, "60", 0);
+    x_console_register_var(console, &renderer->occlusionCull, "render.occlusionCull", X_CONSOLEVAR_BOOL, "1", 0);
+    x_console_register_var(console, &renderer->totalOcclusionTests, "render.occlusionTests", X_CONSOLEVAR_INT, "0", 0);
+    x_console_register_var(console, &renderer->totalOccludedNodes, "render.occludedNodes", X_CONSOLEVAR_INT, "0", 0);
+    x_console_register_var(console, &renderer->totalCulledBrushModels, "render.culledBrushModels", X_CONSOLEVAR_INT, "0", 0);
+
+    x_ae_context_register_console_vars(&renderer->activeEdgeContext, console);
 }
 
 static void cmd_res(EngineContext* context, int argc, char* argv[])
@@ -141,6 +148,70 @@ static void cmd_lighting(EngineContext* context, int argc, char* argv[])
     x_cache_flush(&context->renderer->surfaceCache);
 }
 
+static void cmd_surfacelayout(EngineContext* context, int argc, char* argv[])
+{
+    if(argc != 2 || (strcmp(argv[1], "linear") != 0 && strcmp(argv[1], "tiled") != 0))
+    {
+        x_console_print(context->console, "Usage: surfacelayout [linear/tiled] -> sets how cached surface texels are stored");
+        return;
+    }
+
+#ifdef __nspire__
+    if(strcmp(argv[1], "tiled") == 0)
+    {
+        // The assembly span drawer only knows how to walk linear surfaces
+        x_console_print(context->console, "Tiled surfaces are not supported on this platform");
+        return;
+    }
+#endif
+
+    context->renderer->surfaceTexelLayout = (strcmp(argv[1], "tiled") == 0 ? SURFACE_TEXELS_TILED : SURFACE_TEXELS_LINEAR);
+
+    // Cached surfaces are in the old layout
+    x_cache_flush(&context->renderer->surfaceCache);
+}
+
+static void cmd_renderstats(EngineContext* context, int argc, char* argv[])
+{
+    if(argc == 3 && strcmp(argv[1], "record") == 0)
+    {
+        if(!RenderStats::startRecording(argv[2]))
+        {
+            x_console_printf(context->console, "Failed to open %s for writing\n", argv[2]);
+            return;
+        }
+
+        x_console_printf(context->console, "Recording render stats to %s\n", argv[2]);
+        return;
+    }
+
+    if(argc == 2 && strcmp(argv[1], "stop") == 0)
+    {
+        RenderStats::stopRecording();
+        return;
+    }
+
+    if(argc != 1)
+    {
+        x_console_print(context->console, "Usage: render.stats [record file/stop] -> prints the last frame's render counters or streams them to a CSV/JSON file\n");
+        return;
+    }
+
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        RenderCounter counter = (RenderCounter)i;
+
+        if(RenderStats::getCapacity(counter) != 0)
+        {
+            x_console_printf(context->console, "%-20s %8d / %d\n", RenderStats::getName(counter), RenderStats::getValue(counter), RenderStats::getCapacity(counter));
+        }
+        else
+        {
+            x_console_printf(context->console, "%-20s %8d\n", RenderStats::getName(counter), RenderStats::getValue(counter));
+        }
+    }
+}
+
 static void cmd_scalescreen(EngineContext* context, int argc, char* argv[])
 {
     if(argc != 2)
@@ -221,9 +292,51 @@ static void x_renderer_init_dynamic_lights(OldRenderer* renderer)
     {
         renderer->dynamicLights[i].flags = X_LIGHT_FREE;
         renderer->dynamicLights[i].id = i;
+        renderer->dynamicLights[i].version = 0;
     }
     
-    renderer->dynamicLightsNeedingUpdated = 0;
+    renderer->dynamicLightVersion = 0;
+}
+
+X_Light* OldRenderer::addDynamicLight()
+{
+    for(int i = 0; i < X_RENDERER_MAX_LIGHTS; ++i)
+    {
+        X_Light* light = dynamicLights + i;
+
+        if(x_light_is_free(light))
+        {
+            light->flags = X_LIGHT_ENABLED;
+            dynamicLightChanged(light);
+
+            return light;
+        }
+    }
+
+    return nullptr;
+}
+
+void OldRenderer::removeDynamicLight(X_Light* light)
+{
+    light->flags = X_LIGHT_FREE;
+    dynamicLightChanged(light);
+}
+
+// Must be called after moving a light or changing its intensity, so the surfaces it touches get rebuilt
+void OldRenderer::dynamicLightChanged(X_Light* light)
+{
+    light->version = ++dynamicLightVersion;
+}
+
+void OldRenderer::markSurfacesTouchedByDynamicLights(BspLevel* level)
+{
+    for(int i = 0; i < X_RENDERER_MAX_LIGHTS; ++i)
+    {
+        if(x_light_is_enabled(dynamicLights + i))
+        {
+            x_bsplevel_mark_surfaces_light_is_close_to(level, dynamicLights + i, currentFrame);
+        }
+    }
 }
 
 static void x_renderer_console_cmds(Console* console)
@@ -235,6 +348,8 @@ static void x_renderer_console_cmds(Console* console)
     x_console_register_cmd(console, "surfid", cmd_surfid);    
     x_console_register_cmd(console, "lighting", cmd_lighting);
     x_console_register_cmd(console, "scalescreen", cmd_scalescreen);
+    x_console_register_cmd(console, "surfacelayout", cmd_surfacelayout);
+    x_console_register_cmd(console, "render.stats", cmd_renderstats);
 }
 
 static void x_renderer_set_default_values(OldRenderer* renderer, Screen* screen, int fov)
@@ -245,6 +360,8 @@ static void x_renderer_set_default_values(OldRenderer* renderer, Screen* screen,
     renderer->fullscreen = 0;
     renderer->fov = fov;
     renderer->enableLighting = 1;
+    renderer->writeWorldDepth = true;
+    renderer->surfaceTexelLayout = SURFACE_TEXELS_LINEAR;
     renderer->scaleScreen = 0;
     renderer->maxFramesPerSecond = 60;
 }
@@ -21,18 +21,14 @@
 #include "Light.hpp"
 #include "memory/CircularQueue.hpp"
 #include "Camera.hpp"
+#include "SurfaceLayout.hpp"
+#include "software/ViewWorkers.hpp"
+#include "util/SpinLock.hpp"
 
 #define X_RENDERER_FILL_DISABLED -1
 
 #define X_RENDERER_MAX_LIGHTS 32
 
-struct PortalSpan
-{
-    short left;
-    short right;
-    int y;
-};
-
 struct ScheduledPortal
 {
     Portal* portal;
@@ -49,17 +45,27 @@ struct OldRenderer
 
     void scheduleNextLevelOfPortals(X_RenderContext& renderContext, int recursionDepth);
     void renderScheduledPortal(ScheduledPortal* scheduledPortal, EngineContext& engineContext, X_RenderContext* renderContext);
-    void renderCamera(Camera* cam, EngineContext* engineContext);
+    void renderPortals(Camera* cam, EngineContext* engineContext);
+
+    X_Light* addDynamicLight();
+    void removeDynamicLight(X_Light* light);
+    void dynamicLightChanged(X_Light* light);
+    void markSurfacesTouchedByDynamicLights(BspLevel* level);
     
     X_AE_Context activeEdgeContext;
+    ViewWorkers viewWorkers;
+    
     X_Cache surfaceCache;
+    Mutex surfaceCacheLock;                     // Held while building or pinning surfaces
+    SurfaceTexelLayout surfaceTexelLayout;      // Layout of the surfaces in surfaceCache
     
     X_Light dynamicLights[X_RENDERER_MAX_LIGHTS];
-    unsigned int dynamicLightsNeedingUpdated;
+    unsigned int dynamicLightVersion;       // Bumped every time a dynamic light changes
     
     X_Color* colorMap;
     
     int currentFrame;
+    DecompressedLeafVisibleSet framePvs;     // Union of every camera's PVS for the current frame
     
     int fillColor;
     bool showFps;
@@ -76,10 +82,17 @@ struct OldRenderer
     
     int totalSurfacesRendered;
 
+    bool occlusionCull;
+    int totalOcclusionTests;
+    int totalOccludedNodes;
+    int totalCulledBrushModels;
+
     bool wireframe;
 
-    int totalRenderedPortals;
-    int maxRenderedPortals;
+    bool writeWorldDepth;       // Only needed if something gets depth tested against the level this frame
+
+    int totalRenderedPortals;       // Over all the views this frame
+    int maxRenderedPortals;         // Per view
     int maxPortalDepth;
     
     int maxFramesPerSecond;
@@ -27,6 +27,7 @@ struct Mat4x4;
 struct BspLevel;
 struct BspModel;
 struct Screen;
+struct X_AE_Context;
 
 typedef struct X_RenderContext
 {
@@ -39,8 +40,10 @@ typedef struct X_RenderContext
     Mat4x4* viewMatrix;
     EngineContext* engineContext;
     BspLevel* level;
+    X_AE_Context* activeEdgeContext;    // Where the view's polygons get added
     
     int currentFrame;
+    int pvsFrame;       // Frame the potentially visible leaves were marked in, shared between views
     Vec3fp camPos;
 } X_RenderContext;
 
@@ -0,0 +1,171 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#include <cstring>
+
+#include "RenderStats.hpp"
+
+RenderStats::Counter RenderStats::counters[(int)RenderCounter::TOTAL];
+
+FILE* RenderStats::recordFile = nullptr;
+bool RenderStats::recordJson = false;
+int RenderStats::totalRecordedFrames = 0;
+
+struct CounterInfo
+{
+    const char* name;
+    bool hasCapacity;
+};
+
+static const CounterInfo counterInfo[] =
+{
+    { "nodesVisited", false },
+    { "nodesFrustumCulled", false },
+    { "polygonsEmitted", false },
+    { "edgesGenerated", false },
+    { "spansGenerated", false },
+    { "texelsDrawn", false },
+    { "surfaceCacheHits", false },
+    { "surfaceCacheMisses", false },
+    { "edgeArena", true },
+    { "surfaceArena", true },
+    { "spanArena", true }
+};
+
+static_assert(sizeof(counterInfo) / sizeof(counterInfo[0]) == (int)RenderCounter::TOTAL, "Missing render counter info");
+
+void RenderStats::beginFrame()
+{
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        counters[i].value = 0;
+    }
+}
+
+void RenderStats::endFrame()
+{
+    if(!isRecording())
+    {
+        return;
+    }
+
+    if(recordJson)
+    {
+        writeJsonRow();
+    }
+    else
+    {
+        writeCsvRow();
+    }
+
+    ++totalRecordedFrames;
+}
+
+const char* RenderStats::getName(RenderCounter counter)
+{
+    return counterInfo[(int)counter].name;
+}
+
+bool RenderStats::startRecording(const char* fileName)
+{
+    stopRecording();
+
+    recordFile = fopen(fileName, "w");
+
+    if(!recordFile)
+    {
+        return false;
+    }
+
+    int nameLength = strlen(fileName);
+
+    recordJson = nameLength >= 5 && strcmp(fileName + nameLength - 5, ".json") == 0;
+    totalRecordedFrames = 0;
+
+    if(recordJson)
+    {
+        fprintf(recordFile, "[\n");
+        return true;
+    }
+
+    fprintf(recordFile, "frame");
+
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        fprintf(recordFile, ",%s", counterInfo[i].name);
+
+        if(counterInfo[i].hasCapacity)
+        {
+            fprintf(recordFile, ",%sCapacity", counterInfo[i].name);
+        }
+    }
+
+    fprintf(recordFile, "\n");
+
+    return true;
+}
+
+void RenderStats::stopRecording()
+{
+    if(!isRecording())
+    {
+        return;
+    }
+
+    if(recordJson)
+    {
+        fprintf(recordFile, "\n]\n");
+    }
+
+    fclose(recordFile);
+    recordFile = nullptr;
+}
+
+void RenderStats::writeCsvRow()
+{
+    fprintf(recordFile, "%d", totalRecordedFrames);
+
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        fprintf(recordFile, ",%d", (int)counters[i].value);
+
+        if(counterInfo[i].hasCapacity)
+        {
+            fprintf(recordFile, ",%d", (int)counters[i].capacity);
+        }
+    }
+
+    fprintf(recordFile, "\n");
+}
+
+void RenderStats::writeJsonRow()
+{
+    fprintf(recordFile, "%s    { \"frame\": %d", totalRecordedFrames > 0 ? ",\n" : "", totalRecordedFrames);
+
+    // Counter names come from code, so they never need escaping
+    for(int i = 0; i < (int)RenderCounter::TOTAL; ++i)
+    {
+        if(counterInfo[i].hasCapacity)
+        {
+            fprintf(recordFile, ", \"%s\": { \"used\": %d, \"capacity\": %d }", counterInfo[i].name, (int)counters[i].value, (int)counters[i].capacity);
+        }
+        else
+        {
+            fprintf(recordFile, ", \"%s\": %d", counterInfo[i].name, (int)counters[i].value);
+        }
+    }
+
+    fprintf(recordFile, " }");
+}
+
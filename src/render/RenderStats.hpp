@@ -0,0 +1,121 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstdio>
+
+#include "engine/Config.hpp"
+
+#if X_ENABLE_THREADS
+#include <atomic>
+#endif
+
+enum class RenderCounter
+{
+    nodesVisited,
+    nodesFrustumCulled,
+    polygonsEmitted,
+    edgesGenerated,
+    spansGenerated,
+    texelsDrawn,
+    surfaceCacheHits,
+    surfaceCacheMisses,
+    edgeArena,
+    surfaceArena,
+    spanArena,
+    TOTAL
+};
+
+// Per-frame counters for the renderer. They're reset when a frame starts and keep their
+// values until the next one, so overlays and the console can read the last full frame.
+// Views can be drawn on several threads at once, so the counters are atomic.
+class RenderStats
+{
+public:
+    static void beginFrame();
+    static void endFrame();
+
+    static void add(RenderCounter counter, int amount = 1)
+    {
+        counters[(int)counter].value += amount;
+    }
+
+    // Arenas are reset for every view, so they report the most used by any view this frame
+    static void recordUsage(RenderCounter counter, int used, int capacity)
+    {
+        Counter& c = counters[(int)counter];
+
+#if X_ENABLE_THREADS
+        int value = c.value.load(std::memory_order_relaxed);
+
+        while(used > value && !c.value.compare_exchange_weak(value, used, std::memory_order_relaxed))
+        {
+        }
+#else
+        if(used > c.value)
+        {
+            c.value = used;
+        }
+#endif
+
+        c.capacity = capacity;
+    }
+
+    static int getValue(RenderCounter counter)
+    {
+        return counters[(int)counter].value;
+    }
+
+    // Zero if the counter doesn't have a capacity
+    static int getCapacity(RenderCounter counter)
+    {
+        return counters[(int)counter].capacity;
+    }
+
+    static const char* getName(RenderCounter counter);
+
+    // Writes a row per frame until stopRecording() is called. The file is JSON if the name
+    // ends in .json and CSV otherwise.
+    static bool startRecording(const char* fileName);
+    static void stopRecording();
+
+    static bool isRecording()
+    {
+        return recordFile != nullptr;
+    }
+
+private:
+#if X_ENABLE_THREADS
+    typedef std::atomic<int> CounterValue;
+#else
+    typedef int CounterValue;
+#endif
+
+    struct Counter
+    {
+        CounterValue value;
+        CounterValue capacity;
+    };
+
+    static void writeCsvRow();
+    static void writeJsonRow();
+
+    static Counter counters[(int)RenderCounter::TOTAL];
+
+    static FILE* recordFile;
+    static bool recordJson;
+    static int totalRecordedFrames;
+};
+
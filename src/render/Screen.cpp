@@ -24,6 +24,7 @@ void Screen::restartVideo(int newW, int newH, fp newFov)
     
     x_free(zbuf);
     zbuf = (x_fp0x16*)x_malloc(calculateZBufSize());
+    zbufTiles.invalidate();
     
     // FIXME: Broadcast to cameras the change so they can update their viewports
 //    for(Camera* cam = cameraListHead; cam != NULL; cam = cam->nextInCameraList)
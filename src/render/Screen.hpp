@@ -18,6 +18,7 @@
 #include "Palette.hpp"
 #include "math/FixedPoint.hpp"
 #include "Texture.hpp"
+#include "DepthTiles.hpp"
 
 #define X_ZBUF_FURTHEST_VALUE 0
 
@@ -61,6 +62,12 @@ public:
     void clearZBuf()
     {
         memset(zbuf, X_ZBUF_FURTHEST_VALUE, calculateZBufSize());
+        zbufTiles.invalidate();
+    }
+    
+    bool zbufRectIsHidden(int left, int top, int right, int bottom, int closestZ)
+    {
+        return zbufTiles.rectIsHidden(zbuf, getW(), getH(), left, top, right, bottom, closestZ);
     }
     
     Vec2 getCenter()
@@ -77,6 +84,7 @@ public:
     
     Texture canvas;
     x_fp0x16* zbuf;
+    DepthTiles zbufTiles;
     
     const X_Palette* palette;
     ScreenEventHandlers handlers;
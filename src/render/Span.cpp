@@ -21,6 +21,7 @@
 #include "OldRenderer.hpp"
 #include "Surface.h"
 #include "Camera.hpp"
+#include "RenderStats.hpp"
 
 // Scales a value down based on the current mip map level
 static inline int mip_adjust(int val, int mipLevel)
@@ -153,6 +154,10 @@ static inline void setup_surface(X_AE_SurfaceRenderContext* context)
     context->texW = context->surfaceTexture.getW();
     
     context->surfaceTexels = context->surfaceTexture.getTexels();
+    
+    context->surfaceLayout = context->renderContext->renderer->surfaceTexelLayout;
+    context->tiledSurfaceW = x_surface_tiled_size(context->surfaceTexture.getW());
+    context->writeDepth = context->renderContext->renderer->writeWorldDepth;
 }
 
 static inline void setup_recip_tab(X_AE_SurfaceRenderContext* context)
@@ -249,6 +254,7 @@ static inline void calculate_u_and_v_at_screen_point(const X_AE_SurfaceRenderCon
     clamp_texture_coord(context, u, v);
 }
 
+template<SurfaceTexelLayout layout>
 static inline X_Color get_texel(const X_AE_SurfaceRenderContext* context, fp u, fp v)
 {
     int uu = u.toInt();
@@ -259,6 +265,9 @@ static inline X_Color get_texel(const X_AE_SurfaceRenderContext* context, fp u,
     vv = vv % context->surfaceTexture.getH();
 #endif
     
+    if(layout == SURFACE_TEXELS_TILED)
+        return context->surfaceTexture.getTexels()[x_surface_tiled_texel_offset(uu, vv, context->tiledSurfaceW)];
+    
     return context->surfaceTexture.getTexels()[vv * context->surfaceTexture.getW() + uu];
 }
 
@@ -269,12 +278,11 @@ static inline void __attribute__((hot)) fill_solid_span(X_AE_SurfaceRenderContex
 
     for(int x = span->x1; x < span->x2; ++x)
     {
-        // temp check
-        if(scanline[x] == 0)
         scanline[x] = color;
     }
 }
 
+template<SurfaceTexelLayout layout, bool writeDepth>
 static inline void __attribute__((hot)) x_ae_surfacerendercontext_render_span(X_AE_SurfaceRenderContext* context, X_AE_Span* span)
 {
     int y = span->y;
@@ -302,17 +310,16 @@ static inline void __attribute__((hot)) x_ae_surfacerendercontext_render_span(X_
         
         for(int i = 0; i < 16; ++i)
         {
-            X_Color texel = get_texel(context, u, v);
+            X_Color texel = get_texel<layout>(context, u, v);
             
-            if(scanline[x] == 0)
-
             scanline[x] = texel;
 //             scanline[x * 2] = texel;
 //             scanline[x * 2 + 1] = texel;
 //             scanline[x * 2 + screenTex->w] = texel;
 //             scanline[x * 2 + screenTex->w + 1] = texel;
             
-            zbuf[x] = invZ.internalValue();
+            if(writeDepth)
+                zbuf[x] = invZ.internalValue();
             
             invZ += dInvZ;
             u += dU;
@@ -335,12 +342,11 @@ static inline void __attribute__((hot)) x_ae_surfacerendercontext_render_span(X_
     while(x < span->x2)
     {
         //scanline[x] = get_texel(context, u, v);
-        zbuf[x] = invZ.internalValue();
+        if(writeDepth)
+            zbuf[x] = invZ.internalValue();
         
-        X_Color texel = get_texel(context, u, v);
+        X_Color texel = get_texel<layout>(context, u, v);
    
-        if(scanline[x] == 0)
-
         scanline[x] = texel;
 //         scanline[x * 2] = texel;
 //         scanline[x * 2 + 1] = texel;
@@ -363,6 +369,20 @@ void draw_surface(X_AE_SurfaceRenderContext* context, X_AE_Span* span);
 
 }
 
+template<SurfaceTexelLayout layout, bool writeDepth>
+static void render_textured_spans(X_AE_SurfaceRenderContext* context)
+{
+    int texelsDrawn = 0;
+
+    for(X_AE_Span* span = context->surface->spanHead.next; span != NULL; span = span->next)
+    {
+        x_ae_surfacerendercontext_render_span<layout, writeDepth>(context, span);
+        texelsDrawn += span->x2 - span->x1;
+    }
+
+    RenderStats::add(RenderCounter::texelsDrawn, texelsDrawn);
+}
+
 static void merge_adjacent_spans(X_AE_Span* head)
 {
     X_AE_Span* prev = head;
@@ -385,6 +405,17 @@ static void merge_adjacent_spans(X_AE_Span* head)
     }
 }
 
+// Lets the surface cache evict the surface's texture again once its spans are drawn
+void x_ae_surfacerendercontext_release(X_AE_SurfaceRenderContext* context)
+{
+    if(context->surface->flags.hasFlag(SURFACE_FILL_SOLID))
+    {
+        return;
+    }
+
+    x_bspsurface_release_surface_texture(context->surface->bspSurface, context->mipLevel, context->renderContext->renderer);
+}
+
 void __attribute__((hot)) x_ae_surfacerendercontext_render_spans(X_AE_SurfaceRenderContext* context)
 {
     context->surface->last->next = NULL;
@@ -406,12 +437,19 @@ void __attribute__((hot)) x_ae_surfacerendercontext_render_spans(X_AE_SurfaceRen
             fill_solid_span(context, span, fillColor);
         }
     }
+    else if(context->surfaceLayout == SURFACE_TEXELS_TILED)
+    {
+        if(context->writeDepth)
+            render_textured_spans<SURFACE_TEXELS_TILED, true>(context);
+        else
+            render_textured_spans<SURFACE_TEXELS_TILED, false>(context);
+    }
     else
     {
-        for(X_AE_Span* span = context->surface->spanHead.next; span != NULL; span = span->next)
-        {
-            x_ae_surfacerendercontext_render_span(context, span);
-        }
+        if(context->writeDepth)
+            render_textured_spans<SURFACE_TEXELS_LINEAR, true>(context);
+        else
+            render_textured_spans<SURFACE_TEXELS_LINEAR, false>(context);
     }
 }
 
@@ -17,6 +17,7 @@
 
 #include "math/FixedPoint.hpp"
 #include "render/Texture.hpp"
+#include "render/SurfaceLayout.hpp"
 
 struct X_AE_Surface;
 struct Viewport;
@@ -31,6 +32,14 @@ typedef struct X_AE_Span
     struct X_AE_Span* next;
 } X_AE_Span;
 
+// A span of the screen a portal covers
+struct PortalSpan
+{
+    short left;
+    short right;
+    int y;
+};
+
 typedef struct X_AE_TextureVar
 {
     fp uOrientationStep;
@@ -85,8 +94,12 @@ typedef struct X_AE_SurfaceRenderContext
     int mipLevel;
     
     Texture surfaceTexture;
+    SurfaceTexelLayout surfaceLayout;
+    int tiledSurfaceW;
+    bool writeDepth;
 } X_AE_SurfaceRenderContext;
 
 void x_ae_surfacerendercontext_init(X_AE_SurfaceRenderContext* context, struct X_AE_Surface* surface, struct X_RenderContext* renderContext);
 void x_ae_surfacerendercontext_render_spans(X_AE_SurfaceRenderContext* context);
+void x_ae_surfacerendercontext_release(X_AE_SurfaceRenderContext* context);
 
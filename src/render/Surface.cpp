@@ -14,10 +14,18 @@
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
 #include <new>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "level/BspLevel.hpp"
 #include "OldRenderer.hpp"
 #include "Surface.h"
+#include "SurfaceLayout.hpp"
+#include "RenderStats.hpp"
 
 #define X_LIGHTMAP_MAX_SIZE 64
 
@@ -33,6 +41,14 @@ typedef struct X_SurfaceBuilderBlock
     fp dRight;
 } X_SurfaceBuilderBlock;
 
+// Where a dynamic light reaches on a surface's lightmap
+typedef struct X_SurfaceLightInfluence
+{
+    Vec2 closestIn2D;
+    x_fp24x8 intensityAtClosestPoint;
+    LumelRect rect;
+} X_SurfaceLightInfluence;
+
 typedef struct X_SurfaceBuilder
 {
     BspSurface* bspSurface;
@@ -50,35 +66,89 @@ typedef struct X_SurfaceBuilder
     
     int mipLevel;
     
+    SurfaceTexelLayout layout;
+    int tiledW;
+    
     X_SurfaceBuilderBlock block;
     
     X_Light* currentLight;
+    
+    unsigned int dynamicLights;
+    X_SurfaceLightInfluence lightInfluences[X_RENDERER_MAX_LIGHTS];
+    int totalLightInfluences;
+    LumelRect litRect;
 } X_SurfaceBuilder;
 
+// Forces the original per-texel block builder and scalar lightmap combining, so surfacecheck can
+// compare the optimized kernels against them
+static bool useReferenceKernels = false;
+
 // TODO: should this be moved into utils?
 static bool is_power_of_2(int val)
 {
     return val != 0 && (val & (val - 1)) == 0;
 }
 
-static void clear_to_ambient_light(int* lightmap, int lightmapSize)
+static void clear_to_ambient_light(int* lightmap, Vec2 lightmapSize, const LumelRect& rect)
 {
-    for(int i = 0; i < lightmapSize; ++i)
-        lightmap[i] = 0;
+    for(int i = rect.top; i <= rect.bottom; ++i)
+    {
+        for(int j = rect.left; j <= rect.right; ++j)
+            lightmap[i * lightmapSize.x + j] = 0;
+    }
+}
+
+static void x_lightmap_add_lumels_reference(int* dest, const unsigned char* lumels, int count)
+{
+    for(int i = 0; i < count; ++i)
+        dest[i] += lumels[i];
+}
+
+static void x_lightmap_add_lumels(int* dest, const unsigned char* lumels, int count)
+{
+    if(useReferenceKernels)
+    {
+        x_lightmap_add_lumels_reference(dest, lumels, count);
+        return;
+    }
+    
+#if defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    int i;
+    
+    for(i = 0; i + 4 <= count; i += 4)
+    {
+        int packedLumels;
+        memcpy(&packedLumels, lumels + i, sizeof(int));
+        
+        __m128i lumels32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedLumels), zero), zero);
+        __m128i sum = _mm_add_epi32(_mm_loadu_si128((__m128i*)(dest + i)), lumels32);
+        
+        _mm_storeu_si128((__m128i*)(dest + i), sum);
+    }
+    
+    x_lightmap_add_lumels_reference(dest + i, lumels + i, count - i);
+#else
+    x_lightmap_add_lumels_reference(dest, lumels, count);
+#endif
 }
 
-static void x_surfacebuilder_combine_lightmaps(X_SurfaceBuilder* builder)
+static void x_surfacebuilder_combine_lightmaps(X_SurfaceBuilder* builder, const LumelRect& rect)
 {
     const unsigned char END_OF_LIGHTMAPS = 255;
     unsigned char* lumels = builder->bspSurface->lightmapData;
+    int lightmapW = builder->lightmapSize.x;
     
     for(int i = 0; i < X_BSPSURFACE_MAX_LIGHTMAPS; ++i)
     {
         if(builder->bspSurface->lightmapStyles[i] == END_OF_LIGHTMAPS)
             break;
         
-        for(int j = 0; j < builder->lightmapTotalLumels; ++j)
-            builder->combinedLightmap[j] += lumels[j];
+        for(int j = rect.top; j <= rect.bottom; ++j)
+        {
+            int rowStart = j * lightmapW + rect.left;
+            x_lightmap_add_lumels(builder->combinedLightmap + rowStart, lumels + rowStart, rect.right - rect.left + 1);
+        }
         
         // Lightmaps are stored consecutively in memory
         lumels += builder->lightmapTotalLumels;
@@ -138,13 +208,21 @@ static X_Color x_surfacebuilder_get_texture_texel(X_SurfaceBuilder* builder, int
     return builder->texture.getTexel({ textureX, textureY });
 }
 
+static X_Color* x_surfacebuilder_get_surface_texel_address(X_SurfaceBuilder* builder, int x, int y)
+{
+    if(builder->layout == SURFACE_TEXELS_TILED)
+        return builder->surface.getTexels() + x_surface_tiled_texel_offset(x, y, builder->tiledW);
+    
+    return builder->surface.getRow(y) + x;
+}
+
 static void x_surfacebuilder_build_without_lighting(X_SurfaceBuilder* builder)
 {
     for(int i = 0; i < builder->surface.getH(); ++i)
     {
         for(int j = 0; j < builder->surface.getW(); ++j)
         {
-            builder->surface.getTexels()[i * builder->surface.getW() + j] = x_surfacebuilder_get_texture_texel(builder, j, i);
+            *x_surfacebuilder_get_surface_texel_address(builder, j, i) = x_surfacebuilder_get_texture_texel(builder, j, i);
         }
     }
 }
@@ -154,6 +232,79 @@ static fp lightmap_get_lumel(int* lightmap, Vec2 lightmapSize, int x, int y)
     return fp::fromInt(lightmap[y * lightmapSize.x + x]);
 }
 
+// Shades one row of a block. The intensity (fp16x16, 0-255) starts at intensity and steps by
+// dIntensity each texel, and picks one of the colormap's 64 shades.
+static void x_surfacebuilder_shade_block_row_scalar(X_Color* dest, const X_Color* textureRow, int textureX, int textureMaskX,
+    int intensity, int dIntensity, int count, const X_Color* colorMap)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        X_Color texel = textureRow[(textureX + i) & textureMaskX];
+        dest[i] = colorMap[texel * X_COLORMAP_SHADES_PER_COLOR + (intensity >> (16 + 2))];
+        intensity += dIntensity;
+    }
+}
+
+#if defined(__SSE2__)
+
+// Same as the scalar version for count a multiple of 4 and texels that don't wrap. SSE2 has
+// no gather, so only the colormap indices are computed 4 at a time.
+static void x_surfacebuilder_shade_block_row_sse2(X_Color* dest, const X_Color* texels, int intensity, int dIntensity, int count, const X_Color* colorMap)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i step = _mm_set1_epi32(dIntensity * 4);
+    __m128i intensities = _mm_add_epi32(_mm_set1_epi32(intensity), _mm_set_epi32(dIntensity * 3, dIntensity * 2, dIntensity, 0));
+    
+    for(int i = 0; i < count; i += 4)
+    {
+        int packedTexels;
+        memcpy(&packedTexels, texels + i, sizeof(int));
+        
+        __m128i texels32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedTexels), zero), zero);
+        __m128i shades = _mm_srai_epi32(intensities, 16 + 2);
+        __m128i colorMapIndices = _mm_add_epi32(_mm_slli_epi32(texels32, 6), shades);
+        
+        alignas(16) int indices[4];
+        _mm_store_si128((__m128i*)indices, colorMapIndices);
+        
+        dest[i + 0] = colorMap[indices[0]];
+        dest[i + 1] = colorMap[indices[1]];
+        dest[i + 2] = colorMap[indices[2]];
+        dest[i + 3] = colorMap[indices[3]];
+        
+        intensities = _mm_add_epi32(intensities, step);
+    }
+}
+
+#endif
+
+static void x_surfacebuilder_shade_block_row(X_Color* dest, const X_Color* textureRow, int textureX, int textureMaskX,
+    int intensity, int dIntensity, int count, const X_Color* colorMap)
+{
+#if defined(__SSE2__)
+    static_assert(X_COLORMAP_SHADES_PER_COLOR == 64, "SSE2 surface builder assumes 64 shades per color");
+    
+    if((count & 3) == 0)
+    {
+        const X_Color* texels = textureRow + textureX;
+        X_Color wrappedTexels[16];
+        
+        if(textureX + count - 1 > textureMaskX)
+        {
+            for(int i = 0; i < count; ++i)
+                wrappedTexels[i] = textureRow[(textureX + i) & textureMaskX];
+            
+            texels = wrappedTexels;
+        }
+        
+        x_surfacebuilder_shade_block_row_sse2(dest, texels, intensity, dIntensity, count, colorMap);
+        return;
+    }
+#endif
+    
+    x_surfacebuilder_shade_block_row_scalar(dest, textureRow, textureX, textureMaskX, intensity, dIntensity, count, colorMap);
+}
+
 static fp x_surfacebuilderblock_get_intensity_at_offset(X_SurfaceBuilderBlock* block, int offsetX, int offsetY, int mipLevel)
 {
     fp left = block->topLeftIntensity + offsetY * block->dLeft;
@@ -163,12 +314,11 @@ static fp x_surfacebuilderblock_get_intensity_at_offset(X_SurfaceBuilderBlock* b
     return left + offsetX * dRow;
 }
 
-static void x_surfacebuilder_build_16x16_block(X_SurfaceBuilder* builder)
+// The original builder, which works out the intensity and texture texel of every texel on its own
+static void x_surfacebuilder_build_16x16_block_reference(X_SurfaceBuilder* builder)
 {
     X_SurfaceBuilderBlock* block = &builder->block;
     
-    //int texX = builder->te
-    
     for(int i = 0; i < block->blockSize; ++i)
     {
         for(int j = 0; j < block->blockSize; ++j)
@@ -179,7 +329,50 @@ static void x_surfacebuilder_build_16x16_block(X_SurfaceBuilder* builder)
             X_Color texel = x_surfacebuilder_get_texture_texel(builder, x, y);
             fp intensity = x_surfacebuilderblock_get_intensity_at_offset(block, j, i, builder->mipLevel);
             
-            builder->surface.getTexels()[y * builder->surface.getW() + x] = x_renderer_get_shaded_color(builder->renderer, texel, intensity.asRightShiftedInteger(16 + 2));
+            *x_surfacebuilder_get_surface_texel_address(builder, x, y) = x_renderer_get_shaded_color(builder->renderer, texel, intensity.asRightShiftedInteger(16 + 2));
+        }
+    }
+}
+
+static void x_surfacebuilder_build_16x16_block(X_SurfaceBuilder* builder)
+{
+    if(useReferenceKernels)
+    {
+        x_surfacebuilder_build_16x16_block_reference(builder);
+        return;
+    }
+    
+    X_SurfaceBuilderBlock* block = &builder->block;
+    
+    // Rows of a tiled surface are only contiguous within a tile. Blocks are aligned to their
+    // size, so a run never crosses a tile boundary.
+    int runLength = block->blockSize;
+    
+    if(builder->layout == SURFACE_TEXELS_TILED)
+        runLength = X_MIN(runLength, X_SURFACE_TILE_SIZE);
+    
+    for(int i = 0; i < block->blockSize; ++i)
+    {
+        int y = block->startY + i;
+        int textureY = (y + builder->textureOffset.y) & builder->textureMask.y;
+        
+        fp left = block->topLeftIntensity + i * block->dLeft;
+        fp right = block->topRightIntensity + i * block->dRight;
+        fp dRow = (right - left) >> (4 - builder->mipLevel);
+        
+        for(int j = 0; j < block->blockSize; j += runLength)
+        {
+            int x = block->startX + j;
+            
+            x_surfacebuilder_shade_block_row(
+                x_surfacebuilder_get_surface_texel_address(builder, x, y),
+                builder->texture.getTexels() + textureY * builder->texture.getW(),
+                (x + builder->textureOffset.x) & builder->textureMask.x,
+                builder->textureMask.x,
+                (left + j * dRow).internalValue(),
+                dRow.internalValue(),
+                runLength,
+                builder->renderer->colorMap);
         }
     }
 }
@@ -201,11 +394,22 @@ static void x_surfacebuilder_init_block(X_SurfaceBuilder* builder, int blockX, i
     block->startY = blockY * (16 >> builder->mipLevel);
 }
 
-static void x_surfacebuilder_build_from_combined_lightmap(X_SurfaceBuilder* builder)
+static LumelRect x_surfacebuilder_get_full_lightmap_rect(X_SurfaceBuilder* builder)
 {
-    for(int i = 0; i < builder->lightmapSize.y - 1; ++i)
+    return { 0, 0, (short)(builder->lightmapSize.x - 1), (short)(builder->lightmapSize.y - 1) };
+}
+
+// Block (x, y) is interpolated from lumels (x, y) to (x + 1, y + 1), so there's one less block than lumels
+static LumelRect x_surfacebuilder_get_full_block_rect(X_SurfaceBuilder* builder)
+{
+    return { 0, 0, (short)(builder->lightmapSize.x - 2), (short)(builder->lightmapSize.y - 2) };
+}
+
+static void x_surfacebuilder_build_from_combined_lightmap(X_SurfaceBuilder* builder, const LumelRect& blockRect)
+{
+    for(int i = blockRect.top; i <= blockRect.bottom; ++i)
     {
-        for(int j = 0; j < builder->lightmapSize.x - 1; ++j)
+        for(int j = blockRect.left; j <= blockRect.right; ++j)
         {
             x_surfacebuilder_init_block(builder, j, i);
             x_surfacebuilder_build_16x16_block(builder);
@@ -227,7 +431,8 @@ static void x_surfacebuilder_surface_point_closest_to_light(X_SurfaceBuilder* bu
     *distDest = abs(dist);
 }
 
-static void x_surfacebuilder_apply_dynamic_light(X_SurfaceBuilder* builder)
+// Returns false if the light doesn't reach any lumel of the surface
+static bool x_surfacebuilder_calculate_light_influence(X_SurfaceBuilder* builder, X_SurfaceLightInfluence* dest)
 {
     int lightDistToPlane;
     Vec3fp closestPoint;
@@ -236,54 +441,158 @@ static void x_surfacebuilder_apply_dynamic_light(X_SurfaceBuilder* builder)
     // We use linear falloff
     x_fp24x8 intensityAtClosestPoint = builder->currentLight->intensity - lightDistToPlane;
     
+    if(intensityAtClosestPoint <= 0)
+        return false;
+    
+    // In texels relative to the top left of the surface (textureMinCoord is fp16x16)
     BspFaceTexture* faceTexture = builder->bspSurface->faceTexture;
     Vec2 closestIn2D = Vec2(
-        closestPoint.dot(faceTexture->uOrientation).toInt() + faceTexture->uOffset.internalValue() - builder->bspSurface->textureMinCoord.x,
-        closestPoint.dot(faceTexture->vOrientation).toInt() + faceTexture->vOffset.internalValue() - builder->bspSurface->textureMinCoord.y);
+        ((closestPoint.dot(faceTexture->uOrientation) + faceTexture->uOffset).internalValue() - builder->bspSurface->textureMinCoord.x) >> 16,
+        ((closestPoint.dot(faceTexture->vOrientation) + faceTexture->vOffset).internalValue() - builder->bspSurface->textureMinCoord.y) >> 16);
     
-    for(int i = 0; i < builder->lightmapSize.y; ++i)
+    // The falloff distance is at least as far as the distance along either axis, so nothing
+    // outside of this square gets any light
+    int left = X_MAX(0, (closestIn2D.x - intensityAtClosestPoint) >> 4);
+    int top = X_MAX(0, (closestIn2D.y - intensityAtClosestPoint) >> 4);
+    int right = X_MIN(builder->lightmapSize.x - 1, (closestIn2D.x + intensityAtClosestPoint) >> 4);
+    int bottom = X_MIN(builder->lightmapSize.y - 1, (closestIn2D.y + intensityAtClosestPoint) >> 4);
+    
+    if(left > right || top > bottom)
+        return false;
+    
+    dest->closestIn2D = closestIn2D;
+    dest->intensityAtClosestPoint = intensityAtClosestPoint;
+    dest->rect = { (short)left, (short)top, (short)right, (short)bottom };
+    
+    return true;
+}
+
+static void x_surfacebuilder_calculate_light_influences(X_SurfaceBuilder* builder)
+{
+    builder->totalLightInfluences = 0;
+    builder->litRect = LumelRect::empty();
+    
+    for(int i = 0; i < X_RENDERER_MAX_LIGHTS; ++i)
     {
-        int vDist = abs(closestIn2D.y - i * 16);
+        if((builder->dynamicLights & (1U << i)) == 0)
+            continue;
+        
+        builder->currentLight = builder->renderer->dynamicLights + i;
+        
+        X_SurfaceLightInfluence* influence = builder->lightInfluences + builder->totalLightInfluences;
         
-        for(int j = 0; j < builder->lightmapSize.x; ++j)
+        if(x_surfacebuilder_calculate_light_influence(builder, influence))
         {
-            int uDist = abs(closestIn2D.x - j * 16);
-            int approxDist = (uDist > vDist ? uDist + (vDist >> 1) : vDist + (uDist >> 1));
-            
-            builder->combinedLightmap[i * builder->lightmapSize.x + j] += X_MAX(0, intensityAtClosestPoint - approxDist);
+            builder->litRect.add(influence->rect);
+            ++builder->totalLightInfluences;
         }
     }
 }
 
-static void x_surfacebuilder_clamp_lightmap(X_SurfaceBuilder* builder)
+static void x_surfacebuilder_apply_dynamic_light(X_SurfaceBuilder* builder, const X_SurfaceLightInfluence* influence, const LumelRect& rect)
 {
-    for(int i = 0; i < builder->lightmapTotalLumels; ++i)
-        builder->combinedLightmap[i] = X_MIN(255, builder->combinedLightmap[i]);
+    int top = X_MAX(rect.top, influence->rect.top);
+    int bottom = X_MIN(rect.bottom, influence->rect.bottom);
+    int left = X_MAX(rect.left, influence->rect.left);
+    int right = X_MIN(rect.right, influence->rect.right);
+    
+    for(int i = top; i <= bottom; ++i)
+    {
+        int vDist = abs(influence->closestIn2D.y - i * 16);
+        
+        for(int j = left; j <= right; ++j)
+        {
+            int uDist = abs(influence->closestIn2D.x - j * 16);
+            int approxDist = (uDist > vDist ? uDist + (vDist >> 1) : vDist + (uDist >> 1));
+            
+            builder->combinedLightmap[i * builder->lightmapSize.x + j] += X_MAX(0, influence->intensityAtClosestPoint - approxDist);
+        }
+    }
 }
 
-static void x_surfacebuilder_build_with_lighting(X_SurfaceBuilder* builder)
+static void x_surfacebuilder_clamp_lightmap(X_SurfaceBuilder* builder, const LumelRect& rect)
 {
-    clear_to_ambient_light(builder->combinedLightmap, builder->lightmapTotalLumels);
-    x_surfacebuilder_combine_lightmaps(builder);
-    
-    for(int i = 0; i < X_RENDERER_MAX_LIGHTS; ++i)
+    for(int i = rect.top; i <= rect.bottom; ++i)
     {
-        builder->currentLight = builder->renderer->dynamicLights + i;
-        
-        if(x_light_is_enabled(builder->currentLight))
+        for(int j = rect.left; j <= rect.right; ++j)
         {
-            x_surfacebuilder_apply_dynamic_light(builder);
+            int* lumel = builder->combinedLightmap + i * builder->lightmapSize.x + j;
+            *lumel = X_MIN(255, *lumel);
         }
     }
+}
+
+static void x_surfacebuilder_build_combined_lightmap(X_SurfaceBuilder* builder, const LumelRect& rect)
+{
+    clear_to_ambient_light(builder->combinedLightmap, builder->lightmapSize, rect);
+    x_surfacebuilder_combine_lightmaps(builder, rect);
+    
+    for(int i = 0; i < builder->totalLightInfluences; ++i)
+        x_surfacebuilder_apply_dynamic_light(builder, builder->lightInfluences + i, rect);
+    
+    x_surfacebuilder_clamp_lightmap(builder, rect);
+}
+
+static void x_surfacebuilder_save_light_state(X_SurfaceBuilder* builder)
+{
+    BspSurfaceLightState* state = builder->bspSurface->cachedLightStates + builder->mipLevel;
+    
+    state->lights = builder->dynamicLights;
+    state->lightVersion = builder->renderer->dynamicLightVersion;
+    state->litRect = builder->litRect;
+}
+
+static void x_surfacebuilder_build_with_lighting(X_SurfaceBuilder* builder)
+{
+    x_surfacebuilder_calculate_light_influences(builder);
     
     if(builder->bspSurface->id == 27)
     {
         printf("W: %d %d\n", builder->textureOffset.x, builder->textureOffset.y);
     }
     
-    x_surfacebuilder_clamp_lightmap(builder);
+    x_surfacebuilder_build_combined_lightmap(builder, x_surfacebuilder_get_full_lightmap_rect(builder));
+    x_surfacebuilder_build_from_combined_lightmap(builder, x_surfacebuilder_get_full_block_rect(builder));
     
-    x_surfacebuilder_build_from_combined_lightmap(builder);
+    x_surfacebuilder_save_light_state(builder);
+}
+
+// Only rebuilds the blocks that were lit by the old set of lights or are lit by the new one;
+// everything else only has static light and is already correct
+static void x_surfacebuilder_rebuild_dynamic_lighting(X_SurfaceBuilder* builder)
+{
+    LumelRect dirtyRect = builder->bspSurface->cachedLightStates[builder->mipLevel].litRect;
+    
+    x_surfacebuilder_calculate_light_influences(builder);
+    dirtyRect.add(builder->litRect);
+    
+    if(!dirtyRect.isEmpty())
+    {
+        LumelRect fullBlockRect = x_surfacebuilder_get_full_block_rect(builder);
+        
+        LumelRect blockRect =
+        {
+            (short)X_MAX(dirtyRect.left - 1, fullBlockRect.left),
+            (short)X_MAX(dirtyRect.top - 1, fullBlockRect.top),
+            (short)X_MIN(dirtyRect.right, fullBlockRect.right),
+            (short)X_MIN(dirtyRect.bottom, fullBlockRect.bottom)
+        };
+        
+        if(!blockRect.isEmpty())
+        {
+            LumelRect lumelRect = { blockRect.left, blockRect.top, (short)(blockRect.right + 1), (short)(blockRect.bottom + 1) };
+            
+            x_surfacebuilder_build_combined_lightmap(builder, lumelRect);
+            x_surfacebuilder_build_from_combined_lightmap(builder, blockRect);
+        }
+    }
+    
+    x_surfacebuilder_save_light_state(builder);
+}
+
+static unsigned int x_bspsurface_get_touching_lights(BspSurface* surface, OldRenderer* renderer)
+{
+    return surface->lastLightUpdateFrame == renderer->currentFrame ? surface->lightsTouchingSurface : 0;
 }
 
 static void x_surfacebuilder_init(X_SurfaceBuilder* builder, BspSurface* surface, int mipLevel, OldRenderer* renderer)
@@ -291,12 +600,19 @@ static void x_surfacebuilder_init(X_SurfaceBuilder* builder, BspSurface* surface
     builder->renderer = renderer;
     builder->mipLevel = mipLevel;
     builder->bspSurface = surface;
+    builder->dynamicLights = x_bspsurface_get_touching_lights(surface, renderer);
     
     x_surfacebuilder_calculate_surface_size(builder);
     x_surfacebuilder_calculate_lightmap_size(builder);
     
+    builder->layout = renderer->surfaceTexelLayout;
+    builder->tiledW = x_surface_tiled_size(builder->surface.getW());
+    
     int totalTexels = builder->surface.getW() * builder->surface.getH();
     
+    if(builder->layout == SURFACE_TEXELS_TILED)
+        totalTexels = builder->tiledW * x_surface_tiled_size(builder->surface.getH());
+    
     if(!x_cachentry_is_in_cache(surface->cachedSurfaces + mipLevel))
     {
         x_cache_alloc(&renderer->surfaceCache, totalTexels, surface->cachedSurfaces + mipLevel);
@@ -319,24 +635,90 @@ static void __attribute__((hot)) x_bspsurface_rebuild(BspSurface* surface, int m
     x_surfacebuilder_init(&builder, surface, mipLevel, renderer);
     
     if(renderer->enableLighting)
+    {
         x_surfacebuilder_build_with_lighting(&builder);
+    }
     else
+    {
         x_surfacebuilder_build_without_lighting(&builder);
+        
+        builder.dynamicLights = 0;
+        builder.litRect = LumelRect::empty();
+        x_surfacebuilder_save_light_state(&builder);
+    }
 }
 
-static bool x_bspsurface_need_to_rebuild_because_lights_changed(BspSurface* surface, OldRenderer* renderer)
+static void x_bspsurface_rebuild_dynamic_lighting(BspSurface* surface, int mipLevel, OldRenderer* renderer)
 {
-    return surface->lastLightUpdateFrame == renderer->currentFrame &&
-        (surface->lightsTouchingSurface & renderer->dynamicLightsNeedingUpdated) != 0;
+    X_SurfaceBuilder builder;
+    x_surfacebuilder_init(&builder, surface, mipLevel, renderer);
+    x_surfacebuilder_rebuild_dynamic_lighting(&builder);
+}
+
+static bool x_bspsurface_need_to_rebuild_because_lights_changed(BspSurface* surface, int mipLevel, OldRenderer* renderer)
+{
+    if(!renderer->enableLighting)
+        return false;
+    
+    const BspSurfaceLightState* state = surface->cachedLightStates + mipLevel;
+    unsigned int touchingLights = x_bspsurface_get_touching_lights(surface, renderer);
+    
+    // A light started or stopped touching the surface
+    if(touchingLights != state->lights)
+        return true;
+    
+    for(int i = 0; touchingLights != 0; ++i, touchingLights >>= 1)
+    {
+        if((touchingLights & 1) && renderer->dynamicLights[i].version > state->lightVersion)
+            return true;
+    }
+    
+    return false;
 }
 
 void x_bspsurface_get_surface_texture_for_mip_level(BspSurface* surface, int mipLevel, OldRenderer* renderer, Texture* dest)
 {
-    if(!x_cachentry_is_in_cache(surface->cachedSurfaces + mipLevel) || x_bspsurface_need_to_rebuild_because_lights_changed(surface, renderer))
+    // Views can be drawn on several threads at once, and the surface has to stay in the cache
+    // until the view is done with it
+    std::lock_guard<Mutex> guard(renderer->surfaceCacheLock);
+
+    if(!x_cachentry_is_in_cache(surface->cachedSurfaces + mipLevel))
+    {
+        RenderStats::add(RenderCounter::surfaceCacheMisses);
         x_bspsurface_rebuild(surface, mipLevel, renderer);
+    }
+    else
+    {
+        RenderStats::add(RenderCounter::surfaceCacheHits);
+
+        if(x_bspsurface_need_to_rebuild_because_lights_changed(surface, mipLevel, renderer))
+            x_bspsurface_rebuild_dynamic_lighting(surface, mipLevel, renderer);
+    }
+    
+    x_cache_pin(&renderer->surfaceCache, surface->cachedSurfaces + mipLevel);
+    
+    new (dest) Texture(surface->textureExtent.x >> (mipLevel + 16),
+        surface->textureExtent.y >> (mipLevel + 16),
+        (X_Color*)x_cache_get_cached_data(&renderer->surfaceCache, surface->cachedSurfaces + mipLevel));
+}
+
+void x_bspsurface_release_surface_texture(BspSurface* surface, int mipLevel, OldRenderer* renderer)
+{
+    std::lock_guard<Mutex> guard(renderer->surfaceCacheLock);
+
+    x_cache_unpin(&renderer->surfaceCache, surface->cachedSurfaces + mipLevel);
+}
+
+void x_bspsurface_rebuild_for_mip_level(BspSurface* surface, int mipLevel, OldRenderer* renderer, Texture* dest)
+{
+    x_bspsurface_rebuild(surface, mipLevel, renderer);
     
     new (dest) Texture(surface->textureExtent.x >> (mipLevel + 16),
         surface->textureExtent.y >> (mipLevel + 16),
         (X_Color*)x_cache_get_cached_data(&renderer->surfaceCache, surface->cachedSurfaces + mipLevel));
 }
 
+void x_surfacebuilder_use_reference_kernels(bool enable)
+{
+    useReferenceKernels = enable;
+}
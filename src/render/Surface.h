@@ -17,5 +17,13 @@
 
 #include "level/BspLevel.hpp"
 
+// The texture is pinned in the surface cache until it's released
 void x_bspsurface_get_surface_texture_for_mip_level(BspSurface* surface, int mipLevel, OldRenderer* renderer, Texture* dest);
+void x_bspsurface_release_surface_texture(BspSurface* surface, int mipLevel, OldRenderer* renderer);
+
+// Rebuilds the surface even if the cached copy is up to date
+void x_bspsurface_rebuild_for_mip_level(BspSurface* surface, int mipLevel, OldRenderer* renderer, Texture* dest);
+
+// Makes the surface builder use its original per-texel builder instead of the optimized kernels
+void x_surfacebuilder_use_reference_kernels(bool enable);
 
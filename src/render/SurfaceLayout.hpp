@@ -0,0 +1,38 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// How the texels of a cached surface are laid out in memory. Tiled surfaces store 8x8 blocks
+// of texels contiguously (one 64 byte cache line each), so spans that walk down the surface at
+// a steep angle touch fewer cache lines than with plain rows.
+enum SurfaceTexelLayout
+{
+    SURFACE_TEXELS_LINEAR = 0,
+    SURFACE_TEXELS_TILED = 1
+};
+
+static const int X_SURFACE_TILE_SIZE = 8;
+
+// Width and height of a tiled surface, rounded up to a whole number of tiles
+static inline int x_surface_tiled_size(int size)
+{
+    return (size + X_SURFACE_TILE_SIZE - 1) & ~(X_SURFACE_TILE_SIZE - 1);
+}
+
+static inline int x_surface_tiled_texel_offset(int x, int y, int tiledW)
+{
+    return ((y >> 3) * tiledW + (x & ~7)) * X_SURFACE_TILE_SIZE + ((y & 7) << 3) + (x & 7);
+}
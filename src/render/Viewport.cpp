@@ -51,20 +51,30 @@ void Viewport::init(Vec2 screenPos_, int w_, int h_, fp fieldOfView)
 }
 
 void Viewport::updateFrustum(const Vec3fp& camPos, const Vec3fp& forward, const Vec3fp& right, const Vec3fp& up)
+{
+    updateFrustumForScreenRect(camPos, forward, right, up, screenPos, Vec2(screenPos.x + w, screenPos.y + h));
+}
+
+// Builds a frustum whose sides pass through the edges of a rectangle on the screen (in screen
+// coordinates, not relative to the viewport)
+void Viewport::updateFrustumForScreenRect(const Vec3fp& camPos, const Vec3fp& forward, const Vec3fp& right, const Vec3fp& up, const Vec2& topLeft, const Vec2& bottomRight)
 {
     Vec3fp nearPlaneCenter = camPos + forward * distToNearPlane;
 
-    int epsilon = 0;
+    int centerX = screenPos.x + w / 2;
+    int centerY = screenPos.y + h / 2;
 
-    Vec3fp rightTranslation = right * (w / 2 + epsilon);
-    Vec3fp upTranslation = up * (h / 2 + epsilon);
+    Vec3fp leftTranslation = right * (topLeft.x - centerX);
+    Vec3fp rightTranslation = right * (bottomRight.x - centerX);
+    Vec3fp topTranslation = up * (centerY - topLeft.y);
+    Vec3fp bottomTranslation = up * (centerY - bottomRight.y);
 
     Vec3fp nearPlaneVertices[4] =
     {
-        nearPlaneCenter + rightTranslation + upTranslation,     // Right
-        nearPlaneCenter + rightTranslation - upTranslation,     // Bottom
-        nearPlaneCenter - rightTranslation - upTranslation,     // Left
-        nearPlaneCenter - rightTranslation + upTranslation      // Top
+        nearPlaneCenter + rightTranslation + topTranslation,    // Right
+        nearPlaneCenter + rightTranslation + bottomTranslation, // Bottom
+        nearPlaneCenter + leftTranslation + bottomTranslation,  // Left
+        nearPlaneCenter + leftTranslation + topTranslation      // Top
     };
 
     // Order has to be left, right, bottom, top
@@ -225,10 +235,13 @@ void Viewport::project(const Vec3fp& src, Vec2_fp16x16& dest)
 
     // TODO: may be able to get away with multiplying by distToNearPlane / z
 
+    fp centerX = fp::fromInt(screenPos.x + w / 2);
+    fp centerY = fp::fromInt(screenPos.y + h / 2);
+
     if(src.z < fp::fromFloat(100))
     {
-        dest.x = (src.x / src.z * distToNearPlane + fp::fromInt(w / 2)).toFp16x16();
-        dest.y = (src.y / src.z * distToNearPlane + fp::fromInt(h / 2)).toFp16x16();
+        dest.x = (src.x / src.z * distToNearPlane + centerX).toFp16x16();
+        dest.y = (src.y / src.z * distToNearPlane + centerY).toFp16x16();
     }
     else
     {
@@ -238,8 +251,8 @@ void Viewport::project(const Vec3fp& src, Vec2_fp16x16& dest)
         fp x = (((long long)src.x.toFp16x16() * invZ) >> (shiftDown + 16));
         fp y = (((long long)src.y.toFp16x16() * invZ) >> (shiftDown + 16));
 
-        dest.x = (x * distToNearPlane + fp::fromInt(w / 2)).toFp16x16();
-        dest.y = (y * distToNearPlane + fp::fromInt(h / 2)).toFp16x16();
+        dest.x = (x * distToNearPlane + centerX).toFp16x16();
+        dest.y = (y * distToNearPlane + centerY).toFp16x16();
 
 
         //fp inverseZ = fp::fromInt(distToNearPlane) / fp(src.z);   //fp(x_fastrecip(src.z.toFp16x16() >> 16));
@@ -24,12 +24,18 @@ class Viewport
 public:
     void init(Vec2 screenPos, int w, int h, fp fieldOfView);
     void updateFrustum(const Vec3fp& camPos, const Vec3fp& forward, const Vec3fp& right, const Vec3fp& up);
+    void updateFrustumForScreenRect(const Vec3fp& camPos, const Vec3fp& forward, const Vec3fp& right, const Vec3fp& up, const Vec2& topLeft, const Vec2& bottomRight);
     void project(const Vec3fp& src, Vec2_fp16x16& dest);
     void clamp(Vec2& v);
     void clampfp(Vec2_fp16x16& v);
 
     void projectBisect(const Vec3fp& src, Vec2_fp16x16& dest);
 
+    bool coversScreen(int screenW, int screenH) const
+    {
+        return screenPos.x == 0 && screenPos.y == 0 && w == screenW && h == screenH;
+    }
+
     int closestMipLevelForZ(fp z)
     {
         for(int i = 0; i < 3; ++i)
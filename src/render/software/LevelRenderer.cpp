@@ -19,6 +19,8 @@
 #include "entity/component/PhysicsComponent.hpp"
 #include "render/OldRenderer.hpp"
 #include "engine/Engine.hpp"
+#include "render/RenderStats.hpp"
+#include "memory/FrameAllocator.hpp"
 
 void LevelRenderer::render(const X_RenderContext& renderContext)
 {
@@ -27,23 +29,35 @@ void LevelRenderer::render(const X_RenderContext& renderContext)
 
     nextBspKey = 0;
 
-    x_ae_context_set_current_model(&renderContext.renderer->activeEdgeContext, &levelModel);
+    x_ae_context_set_current_model(renderContext.activeEdgeContext, &levelModel);
 
     BoundBoxFrustumFlags enableAllPlanes = (BoundBoxFrustumFlags)((1 << renderContext.viewFrustum->totalPlanes) - 1);
 
+    // Classify every node against the frustum in one batch; renderRecursive() just looks up the result
+    renderContext.level->nodeBounds.classifyAgainstFrustum(*renderContext.viewFrustum);
+
     renderRecursive(rootLevelNode, renderContext, enableAllPlanes);
     renderBrushModels(renderContext);
 }
 
 void LevelRenderer::renderRecursive(BspNode& node, const X_RenderContext& renderContext, BoundBoxFrustumFlags parentNodeFlags)
 {
-    if(!node.isVisibleThisFrame(renderContext.currentFrame))
+    if(!node.isVisibleThisFrame(renderContext.pvsFrame))
     {
         return;
     }
 
-    BoundBoxFrustumFlags nodeFlags = node.nodeBoundBox.determineFrustumClipFlags(*renderContext.viewFrustum, parentNodeFlags);
+    RenderStats::add(RenderCounter::nodesVisited);
+
+    BspLevel* level = renderContext.level;
+    BoundBoxFrustumFlags nodeFlags = level->nodeBounds.getFrustumClipFlags(level->getNodeBoundsId(node), parentNodeFlags);
     if(nodeFlags == X_BOUNDBOX_TOTALLY_OUTSIDE_FRUSTUM)
+    {
+        RenderStats::add(RenderCounter::nodesFrustumCulled);
+        return;
+    }
+
+    if(renderContext.renderer->occlusionCull && nodeIsOccluded(node, renderContext))
     {
         return;
     }
@@ -113,7 +127,7 @@ void LevelRenderer::renderSurfaces(const BspNode& node, const X_RenderContext& r
         if((!onNormalSide) ^ planeFlipped)
             continue;
 
-        renderContext.renderer->activeEdgeContext.addLevelPolygon(
+        renderContext.activeEdgeContext->addLevelPolygon(
             renderContext.level,
             level->surfaceEdgeIds + surface->firstEdgeId,
             surface->totalEdges,
@@ -135,6 +149,86 @@ void LevelRenderer::markSurfacesAsVisible(BspLeaf& leaf, int currentFrame, int l
     }
 
     leaf.bspKey = leafBspKey;
+    leaf.bspKeyFrame = currentFrame;
+}
+
+bool LevelRenderer::nodeIsOccluded(const BspNode& node, const X_RenderContext& renderContext)
+{
+    ++renderContext.renderer->totalOcclusionTests;
+
+    if(!renderContext.activeEdgeContext->boxIsOccluded(node.nodeBoundBox))
+    {
+        return false;
+    }
+
+    ++renderContext.renderer->totalOccludedNodes;
+
+    return true;
+}
+
+// Brush model polygons are only drawn in leaves that were reached this frame, so a model
+// that only touches culled leaves can be skipped entirely
+bool LevelRenderer::boxTouchesRenderedLeaf(BspNode& node, const BoundBox& box, const X_RenderContext& renderContext)
+{
+    if(!node.isVisibleThisFrame(renderContext.pvsFrame))
+    {
+        return false;
+    }
+
+    if(node.isLeaf())
+    {
+        return node.getLeaf().bspKeyFrame == renderContext.currentFrame;
+    }
+
+    BoundBoxPlaneFlags flags = box.determinePlaneClipFlags(node.plane->plane);
+
+    if(flags != X_BOUNDBOX_OUTSIDE_PLANE && boxTouchesRenderedLeaf(*node.frontChild, box, renderContext))
+    {
+        return true;
+    }
+
+    return flags != X_BOUNDBOX_INSIDE_PLANE && boxTouchesRenderedLeaf(*node.backChild, box, renderContext);
+}
+
+// Moving a brush model into world space doesn't depend on the view, so it's only done for the
+// first view of the frame that draws the model
+void LevelRenderer::updateBrushModelWorldGeometry(BspModel& model, int renderFrame)
+{
+    if(model.worldGeometryFrame == renderFrame)
+    {
+        return;
+    }
+
+    model.worldGeometryFrame = renderFrame;
+    model.worldBoundBox = model.boundBox;
+
+    for(int i = 0; i < 2; ++i)
+    {
+        model.worldBoundBox.v[i].x += model.center.x.internalValue();
+        model.worldBoundBox.v[i].y += model.center.y.internalValue();
+        model.worldBoundBox.v[i].z += model.center.z.internalValue();
+    }
+
+    model.faceWorldVertices = FrameAllocator::alloc<Vec3fp*>(model.totalFaces);
+
+    for(int i = 0; i < model.totalFaces; ++i)
+    {
+        BspSurface* surface = model.faces + i;
+        int* edgeIds = model.surfaceEdgeIds + surface->firstEdgeId;
+        Vec3fp* vertices = FrameAllocator::alloc<Vec3fp>(surface->totalEdges);
+
+        for(int j = 0; j < surface->totalEdges; ++j)
+        {
+            int edgeId = edgeIds[j];
+            Vec3fp v = edgeId >= 0
+                ? model.vertices[model.edges[edgeId].v[0]].v
+                : model.vertices[model.edges[-edgeId].v[1]].v;
+
+            vertices[j] = v + model.center;
+        }
+
+        model.faceWorldVertices[i] = vertices;
+    }
 }
 
 void LevelRenderer::renderBrushModels(const X_RenderContext& renderContext)
@@ -157,14 +251,27 @@ void LevelRenderer::renderBrushModels(const X_RenderContext& renderContext)
                 continue;
             }
 
-            renderBrushModel(*brushModelComponent->model, renderContext, enableAllPlanes);
+            BspModel& model = *brushModelComponent->model;
+
+            updateBrushModelWorldGeometry(model, renderContext.renderer->currentFrame);
+
+            if(renderContext.renderer->occlusionCull)
+            {
+                if(!boxTouchesRenderedLeaf(renderContext.level->getLevelModel().getRootNode(), model.worldBoundBox, renderContext))
+                {
+                    ++renderContext.renderer->totalCulledBrushModels;
+                    continue;
+                }
+            }
+
+            renderBrushModel(model, renderContext, enableAllPlanes);
         }
     }
 }
 
 void LevelRenderer::renderBrushModel(BspModel& brushModel, const X_RenderContext& renderContext, BoundBoxFrustumFlags geoFlags)
 {
-    x_ae_context_set_current_model(&renderContext.renderer->activeEdgeContext, &brushModel);
+    x_ae_context_set_current_model(renderContext.activeEdgeContext, &brushModel);
 
     for(int i = 0; i < brushModel.totalFaces; ++i)
     {
@@ -180,8 +287,9 @@ void LevelRenderer::renderBrushModel(BspModel& brushModel, const X_RenderContext
 //         if((!onNormalSide) ^ planeFlipped)
 //            continue;
 
-        renderContext.renderer->activeEdgeContext.addSubmodelPolygon(
+        renderContext.activeEdgeContext->addSubmodelPolygon(
             renderContext.level,
+            brushModel.faceWorldVertices[i],
             brushModel.surfaceEdgeIds + surface->firstEdgeId,
             surface->totalEdges,
             surface,
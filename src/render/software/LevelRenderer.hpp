@@ -36,6 +36,9 @@ private:
     void renderBrushModels(const X_RenderContext& renderContext);
     void renderBrushModel(BspModel& brushModel, const X_RenderContext& renderContext, BoundBoxFrustumFlags geoFlags);
     static void markSurfacesAsVisible(BspLeaf& leaf, int currentFrame, int leafBspKey);
+    static bool nodeIsOccluded(const BspNode& node, const X_RenderContext& renderContext);
+    static bool boxTouchesRenderedLeaf(BspNode& node, const BoundBox& box, const X_RenderContext& renderContext);
+    static void updateBrushModelWorldGeometry(BspModel& model, int renderFrame);
 
     int nextBspKey;
 };
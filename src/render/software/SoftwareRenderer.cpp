@@ -26,20 +26,110 @@
 #include "LevelRenderer.hpp"
 #include "entity/system/CameraSystem.hpp"
 #include "engine/Engine.hpp"
+#include "memory/FrameAllocator.hpp"
+#include "level/Portal.hpp"
+#include "render/RenderStats.hpp"
+#include "engine/GlobalConfiguration.hpp"
 
-#if 0
+static void x_engine_begin_frame(EngineContext* context)
+{
+    ++context->frameCount;
+}
 
-static void mark_lights(EngineContext* context)
+static void fill_with_background_color(EngineContext* engineContext)
 {
-    return;
+    if(engineContext->renderer->fillColor != X_RENDERER_FILL_DISABLED)
+    {
+        engineContext->screen->canvas.fill(engineContext->renderer->fillColor);
+    }
+}
+
+static void x_renderer_begin_frame(OldRenderer* renderer, EngineContext* engineContext)
+{
+    renderer->totalSurfacesRendered = 0;
+    renderer->totalOcclusionTests = 0;
+    renderer->totalOccludedNodes = 0;
+    renderer->totalCulledBrushModels = 0;
+    renderer->currentFrame = engineContext->frameCount;
+
+    renderer->totalRenderedPortals = 0;
+    renderer->maxRenderedPortals = 10;
+    renderer->maxPortalDepth = 1;
+}
+
+static void clear_zbuffer(EngineContext* engineContext)
+{
+    engineContext->screen->clearZBuf();
+}
+
+// Models and billboards are the only things that read the z-buffer
+static bool depth_tested_geometry_will_be_drawn(EngineContext* engineContext)
+{
+    return !engineContext->renderSystem->getAllQuakeModels().isEmpty()
+        || !engineContext->renderSystem->getAllBillboards().isEmpty();
+}
+
+static void x_cameraobject_determine_current_bspleaf(Camera* cam, X_RenderContext* renderContext)
+{
+    cam->currentLeaf = renderContext->level->findLeafPointIsIn(cam->position);
+}
 
-    X_Light* lights = context->renderer->dynamicLights;
-    for(int i = 0; i < X_RENDERER_MAX_LIGHTS; ++i)
+static void x_cameraobject_load_pvs_for_current_leaf(Camera* cam, X_RenderContext* renderContext)
+{
+    if(cam->currentLeaf == cam->lastLeaf)
     {
-        if(!x_light_is_free(lights + i))
-        {
-            x_bsplevel_mark_surfaces_light_is_close_to(context->levelManager->getCurrentLevel(), lights + i, context->frameCount);
-        }
+        return;
+    }
+
+    cam->lastLeaf = cam->currentLeaf;
+
+    renderContext->level->pvs.decompressPvsForLeaf(*cam->currentLeaf, cam->pvsForCurrentLeaf);
+}
+
+static void x_cameraobject_update_pvs(Camera* cam, X_RenderContext* renderContext)
+{
+    if(!cam->flags.hasFlag(CAMERA_OVERRIDE_PVS))
+    {
+        x_cameraobject_determine_current_bspleaf(cam, renderContext);
+    }
+
+    x_cameraobject_load_pvs_for_current_leaf(cam, renderContext);
+}
+
+// For views that aren't part of the frame's shared PVS, like the ones seen through portals
+static void x_cameraobject_mark_potentially_visible_leaves(Camera* cam, X_RenderContext* renderContext)
+{
+    x_cameraobject_update_pvs(cam, renderContext);
+
+    renderContext->level->pvs.markVisibleLeaves(cam->pvsForCurrentLeaf, renderContext->currentFrame);
+    renderContext->pvsFrame = renderContext->currentFrame;
+}
+
+// The camera's leaf and the visible leaves must already be marked, see renderContext->pvsFrame
+void x_cameraobject_render(Camera* cam, X_RenderContext* renderContext)
+{
+    x_assert(renderContext != NULL, "No render context");
+    x_assert(renderContext->engineContext != NULL, "No engine context in render context");
+
+    int currentFrame = x_enginecontext_get_frame(renderContext->engineContext);
+
+    renderContext->camPos = x_cameraobject_get_position(cam);
+    renderContext->currentFrame = currentFrame;
+
+    renderContext->level->clearPortalSurfaces();
+
+    if(cam->currentLeaf != renderContext->level->leaves + 0 && !renderContext->renderer->wireframe)
+    {
+        LevelRenderer levelRenderer;
+        levelRenderer.render(*renderContext);
+
+        renderContext->level->renderPortals(*renderContext);
+    }
+    else
+    {
+        WireframeLevelRenderer wireFrameLevelRenderer(*renderContext, 5 * 16 - 1, 15);
+
+        wireFrameLevelRenderer.render();
     }
 }
 
@@ -50,48 +140,74 @@ void OldRenderer::scheduleNextLevelOfPortals(X_RenderContext& renderContext, int
         return;
     }
 
-    const int MAX_PORTAL_SPANS = 1024;
     auto level = renderContext.level;
+    Screen* screen = renderContext.screen;
 
     for(auto portal = level->portalHead; portal != nullptr; portal = portal->next)
     {
-        if(!portal->aeSurface || portal->aeSurface->spanHead.next == nullptr)
+        if(!portal->aeSurface || portal->aeSurface->last == &portal->aeSurface->spanHead)
         {
             continue;
         }
 
+        // The span list is only terminated when a surface's spans get drawn, and these don't
+        portal->aeSurface->last->next = nullptr;
+
         if(scheduledPortals.isFull())
         {
             break;
         }
 
+        int totalSpans = 0;
+
+        for(auto span = portal->aeSurface->spanHead.next; span != nullptr; span = span->next)
+        {
+            ++totalSpans;
+        }
+
         auto scheduledPortal = scheduledPortals.allocate();
-        //auto nextPortalSpan = Zone::alloc<PortalSpan>(MAX_PORTAL_SPANS);
+        auto nextPortalSpan = FrameAllocator::alloc<PortalSpan>(totalSpans);
 
         scheduledPortal->recursionDepth = recursionDepth;
-        //scheduledPortal->spans = nextPortalSpan;
+        scheduledPortal->spans = nextPortalSpan;
         scheduledPortal->cam = *renderContext.cam;
         scheduledPortal->portal = portal;
 
-        auto otherSide = portal->otherSide;
-
-        scheduledPortal->cam.viewMatrix = *renderContext.viewMatrix; //otherSide->orientation;
-        scheduledPortal->cam.position = otherSide->center;
-
         Camera& cam = scheduledPortal->cam;
 
         createCameraFromPerspectiveOfPortal(renderContext, *portal, cam);
 
-        // for(auto span = portal->aeSurface->spanHead.next; span != nullptr; span = span->next)
-        // {
-        //     nextPortalSpan->left = span->x1;
-        //     nextPortalSpan->right = span->x2;
-        //     nextPortalSpan->y = span->y;
+        Vec2 topLeft(screen->getW(), screen->getH());
+        Vec2 bottomRight(0, 0);
+
+        for(auto span = portal->aeSurface->spanHead.next; span != nullptr; span = span->next)
+        {
+            nextPortalSpan->left = span->x1;
+            nextPortalSpan->right = span->x2;
+            nextPortalSpan->y = span->y;
+
+            topLeft.x = std::min(topLeft.x, (int)span->x1);
+            topLeft.y = std::min(topLeft.y, (int)span->y);
+            bottomRight.x = std::max(bottomRight.x, (int)span->x2);
+            bottomRight.y = std::max(bottomRight.y, (int)span->y + 1);
+
+            ++nextPortalSpan;
+        }
+
+        scheduledPortal->spansEnd = nextPortalSpan;
 
-        //     ++nextPortalSpan;
-        // }
+        // Only what can be seen through the portal's screen footprint needs to be considered. The
+        // rect is padded a little so rounding in the frustum planes can't cut off edge pixels.
+        const int PADDING = 2;
 
-        // scheduledPortal->spansEnd = nextPortalSpan;
+        const Viewport& viewport = cam.viewport;
+
+        topLeft.x = std::max(topLeft.x - PADDING, viewport.screenPos.x);
+        topLeft.y = std::max(topLeft.y - PADDING, viewport.screenPos.y);
+        bottomRight.x = std::min(bottomRight.x + PADDING, viewport.screenPos.x + viewport.w);
+        bottomRight.y = std::min(bottomRight.y + PADDING, viewport.screenPos.y + viewport.h);
+
+        cam.updateFrustumForScreenRect(topLeft, bottomRight);
     }
 }
 
@@ -100,10 +216,7 @@ void OldRenderer::createCameraFromPerspectiveOfPortal(X_RenderContext& renderCon
     calculateCameraPositionOnOtherSideOfPortal(renderContext, portal, dest);
     calculateCameraViewMatrix(renderContext, portal, dest);
 
-
     dest.viewport.viewFrustum.planes = dest.viewport.viewFrustumPlanes;
-
-    dest.updateFrustum();
 }
 
 void OldRenderer::calculateCameraPositionOnOtherSideOfPortal(X_RenderContext& renderContext, Portal& portal, Camera& cam)
@@ -128,7 +241,6 @@ void OldRenderer::calculateCameraViewMatrix(X_RenderContext& renderContext, Port
 
 void OldRenderer::renderScheduledPortal(ScheduledPortal* scheduledPortal, EngineContext& engineContext, X_RenderContext* renderContext)
 {
-
     bool wireframe = renderContext->renderer->wireframe;
 
     renderContext->renderer->wireframe = false;
@@ -138,43 +250,42 @@ void OldRenderer::renderScheduledPortal(ScheduledPortal* scheduledPortal, Engine
 
     x_ae_context_begin_render(&activeEdgeContext, renderContext);
 
+    // Nothing outside of the portal's spans gets drawn, so most of the level gets culled
+    activeEdgeContext.setDrawRegion(scheduledPortal->spans, scheduledPortal->spansEnd);
+
+    x_cameraobject_mark_potentially_visible_leaves(&scheduledPortal->cam, renderContext);
     x_cameraobject_render(&scheduledPortal->cam, renderContext);
 
     x_ae_context_scan_edges(&activeEdgeContext);
 
-    //Zone::free(scheduledPortal->spans);
-
+    // Spans come from the frame allocator, so they go away on their own
     scheduledPortal->spans = nullptr;
 
     renderContext->renderer->wireframe = wireframe;
 }
 
-void OldRenderer::renderCamera(Camera* cam, EngineContext* engineContext)
+// Renders what can be seen through the portals the camera's view just drew. Every view gets the
+// full portal budget, so what one camera shows doesn't depend on the cameras drawn before it.
+void OldRenderer::renderPortals(Camera* cam, EngineContext* engineContext)
 {
     X_RenderContext renderContext;
     x_enginecontext_get_rendercontext_for_camera(engineContext, cam, &renderContext);
 
-    x_ae_context_begin_render(&activeEdgeContext, &renderContext);
-
-    StopWatch::start("traverse-level");
-    x_cameraobject_render(cam, &renderContext);
-    StopWatch::stop("traverse-level");
-
-    x_ae_context_scan_edges(&activeEdgeContext);
-
     int recursionDepth = 1;
-
-    x_enginecontext_get_rendercontext_for_camera(engineContext, cam, &renderContext);
+    int viewRenderedPortals = 0;
 
     do
     {
         scheduleNextLevelOfPortals(renderContext, recursionDepth);
 
-        if(scheduledPortals.isEmpty() || ++totalRenderedPortals > maxRenderedPortals)
+        if(scheduledPortals.isEmpty() || viewRenderedPortals >= maxRenderedPortals)
         {
             break;
         }
 
+        ++viewRenderedPortals;
+        ++totalRenderedPortals;
+
         auto scheduledPortal = scheduledPortals.dequeue();
         renderScheduledPortal(scheduledPortal, *engineContext, &renderContext);
 
@@ -184,108 +295,203 @@ void OldRenderer::renderCamera(Camera* cam, EngineContext* engineContext)
     while(!scheduledPortals.isEmpty())
     {
         auto scheduledPortal = scheduledPortals.dequeue();
-        //Zone::free(scheduledPortal->spans);
 
         scheduledPortal->spans = nullptr;
     }
 }
 
-#endif
-
-static void x_engine_begin_frame(EngineContext* context)
+// A view whose level is drawn (or being drawn on a worker), which still needs its models
+struct PendingView
 {
-    ++context->frameCount;
-}
+    CameraComponent* camera;
+    X_RenderContext renderContext;
+};
 
-static void fill_with_background_color(EngineContext* engineContext)
+static void draw_models_and_billboards(EngineContext* engineContext, CameraComponent* camera, X_RenderContext* renderContext)
 {
-    if(engineContext->renderer->fillColor != X_RENDERER_FILL_DISABLED)
+    // Draw the quake models
+    auto& quakeModels = engineContext->renderSystem->getAllQuakeModels();
+
+    Time currentTime = Clock::getTicks();
+
+    for(Entity* entity : quakeModels)
     {
-        engineContext->screen->canvas.fill(engineContext->renderer->fillColor);
-    }
-}
+        QuakeModelRenderComponent* renderComponent = entity->getComponent<QuakeModelRenderComponent>();
+        TransformComponent* transformComponent = entity->getComponent<TransformComponent>();
 
-static void x_renderer_begin_frame(OldRenderer* renderer, EngineContext* engineContext)
-{
-    renderer->totalSurfacesRendered = 0;
-    renderer->currentFrame = engineContext->frameCount;
-    renderer->dynamicLightsNeedingUpdated = 0xFFFFFFFF;
+        Mat4x4 transform;
+        transformComponent->toMat4x4(transform);
 
-    renderer->totalRenderedPortals = 0;
-    renderer->maxRenderedPortals = 10;
-    renderer->maxPortalDepth = 1;
-}
+        Vec3fp pos = transformComponent->getPosition();
 
-static void clear_zbuffer(EngineContext* engineContext)
-{
-    engineContext->screen->clearZBuf();
-}
 
-static void x_cameraobject_determine_current_bspleaf(Camera* cam, X_RenderContext* renderContext)
-{
-    cam->currentLeaf = renderContext->level->findLeafPointIsIn(cam->position);
-}
+        transform.elem[0][3] = pos.x;
+        transform.elem[1][3] = pos.y;
+        transform.elem[2][3] = pos.z;
 
-static void x_cameraobject_load_pvs_for_current_leaf(Camera* cam, X_RenderContext* renderContext)
-{
-    if(cam->currentLeaf == cam->lastLeaf)
-    {
-        return;
+        X_EntityFrame* frame = renderComponent->currentFrame;
+
+
+        if(renderComponent->playingAnimation &&
+           currentTime >= renderComponent->frameStart + Duration::fromSeconds(0.1_fp))
+        {
+            if(frame->nextInSequence != nullptr)
+            {
+                //frame = frame->nextInSequence;
+                renderComponent->currentFrame = frame;
+                renderComponent->frameStart = currentTime + Duration::fromSeconds(2);
+            }
+            else
+            {
+                if(renderComponent->loopAnimation)
+                {
+                    renderComponent->currentFrame = renderComponent->animationStartFrame;
+                }
+            }
+        }
+
+        if(frame != nullptr)
+        {
+            x_entitymodel_render_flat_shaded(renderComponent->model, frame, transform, renderContext);
+        }
     }
 
-    cam->lastLeaf = cam->currentLeaf;
+    // Draw the billboards
+    auto& billboards = engineContext->renderSystem->getAllBillboards();
 
-    renderContext->level->pvs.decompressPvsForLeaf(*cam->currentLeaf, cam->pvsForCurrentLeaf);
+    Vec3fp up, right, forward;
+    camera->viewMatrix.extractViewVectors(forward, right, up);
+
+    for(Entity* entity : billboards)
+    {
+        BillboardRenderComponent* renderComponent = entity->getComponent<BillboardRenderComponent>();
+        TransformComponent* transformComponent = entity->getComponent<TransformComponent>();
+
+        Vec3fp position = transformComponent->getPosition();
+
+        int xsize = 20;
+        int ysize = 20;
+
+        Vec3fp x = right * xsize;
+        Vec3fp y = up * ysize;
+
+        Vec3fp vertices[4] =
+        {
+            position + x + y,
+            position - x + y,
+            position - x - y,
+            position + x - y
+        };
+
+        int texW = renderComponent->texture->getW();
+        int texH = renderComponent->texture->getH();
+
+        Vec2i textureCoords[4] = {
+            { texW - 1, 0 },
+            { 0, 0 },
+            { 0, texH - 1 },
+            { texW - 1, texH - 1 }
+        };
+
+        ModelVertex modelVertex[4];
+
+        for(int i = 0; i < 4; ++i)
+        {
+            modelVertex[i].v = vertices[i];
+            modelVertex[i].s = textureCoords[i].x;
+            modelVertex[i].t = textureCoords[i].y;
+        }
+
+        ModelVertex triA[3] =
+        {
+            modelVertex[0],
+            modelVertex[2],
+            modelVertex[1],
+        };
+
+        ModelVertex triB[3] =
+        {
+            modelVertex[0],
+            modelVertex[3],
+            modelVertex[2],
+        };
+
+
+
+        x_polygon3_render_textured(triA, 3, renderContext, renderComponent->texture);
+        x_polygon3_render_textured(triB, 3, renderContext, renderComponent->texture);
+    }
 }
 
-void x_cameraobject_render(Camera* cam, X_RenderContext* renderContext)
+static bool viewports_overlap(const Viewport& a, const Viewport& b)
 {
-    x_assert(renderContext != NULL, "No render context");
-    x_assert(renderContext->engineContext != NULL, "No engine context in render context");
+    return a.screenPos.x < b.screenPos.x + b.w && b.screenPos.x < a.screenPos.x + a.w
+        && a.screenPos.y < b.screenPos.y + b.h && b.screenPos.y < a.screenPos.y + a.h;
+}
 
-    int currentFrame = x_enginecontext_get_frame(renderContext->engineContext);
+// The models are depth tested against the level, so they wait until the level is drawn
+static void finish_pending_views(EngineContext* engineContext, PendingView* views, int& totalViews)
+{
+    engineContext->renderer->viewWorkers.waitForAll();
 
-    if(!cam->flags.hasFlag(CAMERA_OVERRIDE_PVS))
+    // The level just overwrote the z-buffer
+    engineContext->screen->zbufTiles.invalidate();
+
+    for(int i = 0; i < totalViews; ++i)
     {
-        x_cameraobject_determine_current_bspleaf(cam, renderContext);
+        draw_models_and_billboards(engineContext, views[i].camera, &views[i].renderContext);
     }
 
-    x_cameraobject_load_pvs_for_current_leaf(cam, renderContext);
-    renderContext->level->pvs.markVisibleLeaves(cam->pvsForCurrentLeaf, currentFrame);
-
-    renderContext->camPos = x_cameraobject_get_position(cam);
-    renderContext->currentFrame = currentFrame;
+    totalViews = 0;
+}
 
-    if(cam->currentLeaf != renderContext->level->leaves + 0 && !renderContext->renderer->wireframe)
+// Portal surfaces are added while traversing the level
+static bool view_can_see_portals(BspLevel* level)
+{
+    for(auto portal = level->portalHead; portal != nullptr; portal = portal->next)
     {
-        LevelRenderer levelRenderer;
-        levelRenderer.render(*renderContext);
+        if(portal->aeSurface != nullptr)
+        {
+            return true;
+        }
     }
-    else
-    {
-        WireframeLevelRenderer wireFrameLevelRenderer(*renderContext, 5 * 16 - 1, 15);
 
-        wireFrameLevelRenderer.render();
-    }
+    return false;
 }
 
 void SoftwareRenderer::render()
 {
     x_engine_begin_frame(engineContext);
     x_renderer_begin_frame(engineContext->renderer, engineContext);
-    clear_zbuffer(engineContext);
+    RenderStats::beginFrame();
+
+    engineContext->renderer->writeWorldDepth = depth_tested_geometry_will_be_drawn(engineContext);
+
+    if(engineContext->renderer->writeWorldDepth)
+    {
+        clear_zbuffer(engineContext);
+    }
+
     fill_with_background_color(engineContext);
 
 
     if(engineContext->levelManager->getCurrentLevel() == nullptr)
     {
+        RenderStats::endFrame();
         return;
     }
 
+    engineContext->renderer->markSurfacesTouchedByDynamicLights(engineContext->levelManager->getCurrentLevel());
+
     CameraSystem* cameraSystem = Engine::getInstance()->cameraSystem;   // FIXME: DI
 
     auto& entitiesWithCameras = cameraSystem->getAllEntities();
+    bool firstCamera = true;
 
+    BspLevel* level = engineContext->levelManager->getCurrentLevel();
+    OldRenderer* renderer = engineContext->renderer;
+
+    // The leaves potentially visible from any camera are merged, so they only get marked once
     for(auto& entity : entitiesWithCameras)
     {
         CameraComponent* camera = entity->getComponent<CameraComponent>();
@@ -299,127 +505,130 @@ void SoftwareRenderer::render()
         X_RenderContext renderContext;
         x_enginecontext_get_rendercontext_for_camera(engineContext, camera, &renderContext);
 
-        x_ae_context_begin_render(activeEdgeContext, &renderContext);
-
-        StopWatch::start("traverse-level");
-        x_cameraobject_render(camera, &renderContext);
-        StopWatch::stop("traverse-level");
-
-        x_ae_context_scan_edges(activeEdgeContext);
-
-        // Draw the quake models
-        auto& quakeModels = engineContext->renderSystem->getAllQuakeModels();
-
-        Time currentTime = Clock::getTicks();
+        x_cameraobject_update_pvs(camera, &renderContext);
 
-        for(Entity* entity : quakeModels)
+        if(firstCamera)
         {
-            QuakeModelRenderComponent* renderComponent = entity->getComponent<QuakeModelRenderComponent>();
-            TransformComponent* transformComponent = entity->getComponent<TransformComponent>();
+            renderer->framePvs = camera->pvsForCurrentLeaf;
+        }
+        else
+        {
+            renderer->framePvs.addVisibleLeaves(camera->pvsForCurrentLeaf, level->pvs.getBytesPerEntry());
+        }
 
-            Mat4x4 transform;
-            transformComponent->toMat4x4(transform);
+        firstCamera = false;
+    }
 
-            Vec3fp pos = transformComponent->getPosition();
+    firstCamera = true;
 
+    bool framePvsIsMarked = false;
+    int pvsFrame = 0;
 
-            transform.elem[0][3] = pos.x;
-            transform.elem[1][3] = pos.y;
-            transform.elem[2][3] = pos.z;
+    // With more than one view, the views are scanned and drawn on worker threads while this thread
+    // traverses the level for the next one. Traversal stays on this thread because it stamps the
+    // level with the frame, and brush model geometry and light marking are shared between views.
+    ViewWorkers& viewWorkers = renderer->viewWorkers;
+    bool useWorkers = entitiesWithCameras.end() - entitiesWithCameras.begin() > 1;
 
-            X_EntityFrame* frame = renderComponent->currentFrame;
+    if(useWorkers && !viewWorkers.isStarted())
+    {
+        viewWorkers.start(*activeEdgeContext);
+    }
 
+    useWorkers = useWorkers && viewWorkers.getTotalWorkers() > 0;
 
-            if(renderComponent->playingAnimation &&
-               currentTime >= renderComponent->frameStart + Duration::fromSeconds(0.1_fp))
-            {
-                if(frame->nextInSequence != nullptr)
-                {
-                    //frame = frame->nextInSequence;
-                    renderComponent->currentFrame = frame;
-                    renderComponent->frameStart = currentTime + Duration::fromSeconds(2);
-                }
-                else
-                {
-                    if(renderComponent->loopAnimation)
-                    {
-                        renderComponent->currentFrame = renderComponent->animationStartFrame;
-                    }
-                }
-            }
+    PendingView pendingViews[Configuration::CAMERAS_MAX];
+    int totalPendingViews = 0;
+    int nextWorker = 0;
+
+    for(auto& entity : entitiesWithCameras)
+    {
+        CameraComponent* camera = entity->getComponent<CameraComponent>();
 
-            if(frame != nullptr)
+        // Views that share pixels have to be drawn in order
+        for(int i = 0; i < totalPendingViews; ++i)
+        {
+            if(viewports_overlap(pendingViews[i].camera->viewport, camera->viewport))
             {
-                x_entitymodel_render_flat_shaded(renderComponent->model, frame, transform, &renderContext);
+                finish_pending_views(engineContext, pendingViews, totalPendingViews);
+                break;
             }
         }
 
-        // Draw the billboards
-        auto& billboards = engineContext->renderSystem->getAllBillboards();
+        X_AE_Context* context = activeEdgeContext;
+        int workerId = -1;
+
+        if(useWorkers)
+        {
+            workerId = nextWorker;
+            nextWorker = (nextWorker + 1) % viewWorkers.getTotalWorkers();
 
-        Vec3fp up, right, forward;
-        camera->viewMatrix.extractViewVectors(forward, right, up);
+            context = viewWorkers.acquireContext(workerId);
+        }
 
-        for(Entity* entity : billboards)
+        if(!firstCamera)
         {
-            BillboardRenderComponent* renderComponent = entity->getComponent<BillboardRenderComponent>();
-            TransformComponent* transformComponent = entity->getComponent<TransformComponent>();
+            // Edge, vertex and visibility caches are stamped with the frame number
+            x_engine_begin_frame(engineContext);
+        }
 
-            Vec3fp position = transformComponent->getPosition();
+        firstCamera = false;
 
-            int xsize = 20;
-            int ysize = 20;
+        if(!framePvsIsMarked)
+        {
+            pvsFrame = x_enginecontext_get_frame(engineContext);
+            level->pvs.markVisibleLeaves(renderer->framePvs, pvsFrame);
+            framePvsIsMarked = true;
+        }
 
-            Vec3fp x = right * xsize;
-            Vec3fp y = up * ysize;
+        PendingView& view = pendingViews[totalPendingViews++];
+        view.camera = camera;
 
-            Vec3fp vertices[4] =
-            {
-                position + x + y,
-                position - x + y,
-                position - x - y,
-                position + x - y
-            };
+        X_RenderContext& renderContext = view.renderContext;
+        x_enginecontext_get_rendercontext_for_camera(engineContext, camera, &renderContext);
+        renderContext.pvsFrame = pvsFrame;
+        renderContext.activeEdgeContext = context;
 
-            int texW = renderComponent->texture->getW();
-            int texH = renderComponent->texture->getH();
+        x_ae_context_begin_render(context, &renderContext);
 
-            Vec2i textureCoords[4] = {
-                { texW - 1, 0 },
-                { 0, 0 },
-                { 0, texH - 1 },
-                { texW - 1, texH - 1 }
-            };
+        if(!camera->viewport.coversScreen(engineContext->screen->getW(), engineContext->screen->getH()))
+        {
+            const Viewport& viewport = camera->viewport;
 
-            ModelVertex modelVertex[4];
+            context->setDrawRect(
+                viewport.screenPos.x,
+                viewport.screenPos.y,
+                viewport.screenPos.x + viewport.w,
+                viewport.screenPos.y + viewport.h);
+        }
 
-            for(int i = 0; i < 4; ++i)
-            {
-                modelVertex[i].v = vertices[i];
-                modelVertex[i].s = textureCoords[i].x;
-                modelVertex[i].t = textureCoords[i].y;
-            }
+        StopWatch::start("traverse-level");
+        x_cameraobject_render(camera, &renderContext);
+        StopWatch::stop("traverse-level");
 
-            ModelVertex triA[3] =
-            {
-                modelVertex[0],
-                modelVertex[2],
-                modelVertex[1],
-            };
+        if(workerId != -1 && !view_can_see_portals(level))
+        {
+            viewWorkers.drawView(workerId);
+            continue;
+        }
 
-            ModelVertex triB[3] =
-            {
-                modelVertex[0],
-                modelVertex[3],
-                modelVertex[2],
-            };
+        // The views through portals traverse the level too, so they're drawn on this thread
+        x_ae_context_scan_edges(context);
 
+        int totalRenderedPortals = renderer->totalRenderedPortals;
 
+        engineContext->renderer->renderPortals(camera, engineContext);
 
-            x_polygon3_render_textured(triA, 3, &renderContext, renderComponent->texture);
-            x_polygon3_render_textured(triB, 3, &renderContext, renderComponent->texture);
+        // Views through portals mark their own leaves over the shared ones
+        if(renderer->totalRenderedPortals != totalRenderedPortals)
+        {
+            framePvsIsMarked = false;
         }
     }
+
+    finish_pending_views(engineContext, pendingViews, totalPendingViews);
+
+    RenderStats::endFrame();
 }
 
 SoftwareRenderer::SoftwareRenderer(X_AE_Context* activeEdgeContext, EngineContext* engineContext)
@@ -0,0 +1,166 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ViewWorkers.hpp"
+#include "render/ActiveEdge.hpp"
+#include "error/Log.hpp"
+#include "error/Error.hpp"
+
+#if X_ENABLE_THREADS
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct ViewWorkers::Worker
+{
+    Worker(const X_AE_Context& mainContext)
+        : activeEdgeContext(mainContext.edges.maxAllocs(), mainContext.surfaces.maxAllocs(), mainContext.spans.maxAllocs(), mainContext.screen),
+        hasView(false),
+        quit(false)
+    {
+
+    }
+
+    X_AE_Context activeEdgeContext;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;       // Signaled when a view is handed over and when it's done
+
+    bool hasView;
+    bool quit;
+};
+
+void ViewWorkers::workerMain(Worker* worker)
+{
+    std::unique_lock<std::mutex> lock(worker->mutex);
+
+    while(true)
+    {
+        worker->wake.wait(lock, [=] { return worker->hasView || worker->quit; });
+
+        if(worker->quit)
+        {
+            return;
+        }
+
+        lock.unlock();
+        x_ae_context_scan_edges(&worker->activeEdgeContext);
+        lock.lock();
+
+        worker->hasView = false;
+        worker->wake.notify_all();
+    }
+}
+
+void ViewWorkers::start(const X_AE_Context& mainContext)
+{
+    started = true;
+
+    // The main thread keeps traversing the level, so it doesn't get a worker of its own
+    int totalCores = std::thread::hardware_concurrency();
+    totalWorkers = std::min(totalCores - 1, MAX_WORKERS);
+
+    if(totalWorkers <= 0)
+    {
+        totalWorkers = 0;
+        return;
+    }
+
+    for(int i = 0; i < totalWorkers; ++i)
+    {
+        workers[i] = new Worker(mainContext);
+        workers[i]->thread = std::thread(workerMain, workers[i]);
+    }
+
+    Log::info("Started %d view worker threads", totalWorkers);
+}
+
+ViewWorkers::~ViewWorkers()
+{
+    for(int i = 0; i < totalWorkers; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> guard(workers[i]->mutex);
+            workers[i]->quit = true;
+        }
+
+        workers[i]->wake.notify_all();
+        workers[i]->thread.join();
+
+        delete workers[i];
+    }
+}
+
+X_AE_Context* ViewWorkers::acquireContext(int workerId)
+{
+    Worker* worker = workers[workerId];
+
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    worker->wake.wait(lock, [=] { return !worker->hasView; });
+
+    return &worker->activeEdgeContext;
+}
+
+void ViewWorkers::drawView(int workerId)
+{
+    Worker* worker = workers[workerId];
+
+    {
+        std::lock_guard<std::mutex> guard(worker->mutex);
+        worker->hasView = true;
+    }
+
+    worker->wake.notify_all();
+}
+
+void ViewWorkers::waitForAll()
+{
+    for(int i = 0; i < totalWorkers; ++i)
+    {
+        acquireContext(i);
+    }
+}
+
+#else
+
+void ViewWorkers::start(const X_AE_Context& mainContext)
+{
+    started = true;
+}
+
+ViewWorkers::~ViewWorkers()
+{
+
+}
+
+X_AE_Context* ViewWorkers::acquireContext(int workerId)
+{
+    x_system_error("No view workers without threads");
+}
+
+void ViewWorkers::drawView(int workerId)
+{
+    x_system_error("No view workers without threads");
+}
+
+void ViewWorkers::waitForAll()
+{
+
+}
+
+#endif
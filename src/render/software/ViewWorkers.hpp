@@ -0,0 +1,70 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "engine/Config.hpp"
+
+struct X_AE_Context;
+
+// Threads that scan and draw views, so the main thread can traverse the level for the next view
+// while the last one is being drawn. Each worker owns an active edge context that the main
+// thread fills in before handing it over. There are no workers without threads (or on a single
+// core), in which case every view is drawn on the main thread.
+class ViewWorkers
+{
+public:
+    ViewWorkers()
+        : totalWorkers(0),
+        started(false)
+    {
+
+    }
+
+    ~ViewWorkers();
+
+    // The worker contexts are sized like the main one, so edges cached by one view can't point
+    // outside of another view's context
+    void start(const X_AE_Context& mainContext);
+
+    bool isStarted() const
+    {
+        return started;
+    }
+
+    int getTotalWorkers() const
+    {
+        return totalWorkers;
+    }
+
+    // Waits for the worker to finish the view it's drawing, so the context can take a new one
+    X_AE_Context* acquireContext(int workerId);
+
+    // The context's render context has to stay alive until the view is drawn
+    void drawView(int workerId);
+
+    void waitForAll();
+
+private:
+    static const int MAX_WORKERS = 4;
+
+    struct Worker;
+
+    static void workerMain(Worker* worker);
+
+    Worker* workers[MAX_WORKERS];
+    int totalWorkers;
+    bool started;
+};
@@ -44,7 +44,7 @@ char* FileReader::readWholeFile(const char* fileName, int& size)
         return nullptr;
     }
 
-    char* buf = Zone::alloc<char>(reader.getSize() + 1);
+    char* buf = Zone::alloc<char>(reader.getSize() + 1, ZoneTag::file);
     reader.readArray(buf, reader.getSize());
 
     size = reader.getSize();
@@ -79,7 +79,7 @@ bool FileSystem::locateFileInSearchPaths(const char* name, FileLocation& dest)
 
 void FileSystem::addSearchPath(const char* path)
 {
-    auto pathNode = Zone::alloc<Link<FilePath>>();
+    auto pathNode = Zone::alloc<Link<FilePath>>(1, ZoneTag::file);
 
     pathNode->value.set(path);
     pathNode->next = searchPathRoot.next;
@@ -26,6 +26,32 @@ JsonValue* Json::parse(const char* str)
     return parser.parse();
 }
 
+void Json::free(JsonValue* value)
+{
+    if(value == &JsonValue::nullValue || value == &JsonValue::trueValue || value == &JsonValue::falseValue)
+    {
+        return;
+    }
+
+    if(value->type == JSON_OBJECT)
+    {
+        for(int i = 0; i < (int)value->object.pairs.size(); ++i)
+        {
+            free(value->object.pairs[i].value);
+        }
+    }
+    else if(value->type == JSON_ARRAY)
+    {
+        for(int i = 0; i < (int)value->array.values.size(); ++i)
+        {
+            free(value->array.values[i]);
+        }
+    }
+
+    value->~JsonValue();
+    Zone::free(value);
+}
+
 JsonValue::~JsonValue()
 {
     switch(type)
@@ -155,7 +155,7 @@ class Json
 public:
     static JsonValue* newValue(JsonType type)
     {
-        auto value = Zone::alloc<JsonValue>();
+        auto value = Zone::alloc<JsonValue>(1, ZoneTag::json);
         value->type = type;
 
         switch(type)
@@ -181,7 +181,7 @@ public:
 
     static JsonValue* newXString(const char* begin, const char* end)
     {
-        auto value = Zone::alloc<JsonValue>();
+        auto value = Zone::alloc<JsonValue>(1, ZoneTag::json);
         value->type = JSON_STRING;
 
         new (&value->stringValue) XString(begin, end);
@@ -191,6 +191,9 @@ public:
 
     static XString stringify(JsonValue* value, bool pretty);
 
+    // Frees a value returned by parse() and everything in it
+    static void free(JsonValue* value);
+
     static JsonValue* parse(const char* str);
 
     friend class MemoryManager;
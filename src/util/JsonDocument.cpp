@@ -0,0 +1,154 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "JsonDocument.hpp"
+#include "error/Error.hpp"
+
+JsonNode JsonNode::nullNode(JSON_NULL);
+
+JsonNode* JsonDocument::parse(char* source)
+{
+    nodes.freeAll();
+
+    JsonReader reader(source);
+    JsonToken token;
+
+    reader.read(token);
+    root = parseValue(reader, token);
+
+    // Make sure there's nothing left after the root
+    reader.read(token);
+
+    return root;
+}
+
+JsonNode* JsonDocument::parseValue(JsonReader& reader, JsonToken& token)
+{
+    JsonNode* node = nodes.alloc();
+    node->key.start = nullptr;
+    node->key.length = 0;
+    node->nextSibling = nullptr;
+
+    switch(token.type)
+    {
+        case JSON_TOKEN_BEGIN_OBJECT:
+            node->type = JSON_OBJECT;
+            parseChildren(reader, node, JSON_TOKEN_END_OBJECT);
+            break;
+
+        case JSON_TOKEN_BEGIN_ARRAY:
+            node->type = JSON_ARRAY;
+            parseChildren(reader, node, JSON_TOKEN_END_ARRAY);
+            break;
+
+        case JSON_TOKEN_STRING:
+            node->type = JSON_STRING;
+            node->stringValue = token.stringValue;
+            break;
+
+        case JSON_TOKEN_INT:
+            node->type = JSON_INT;
+            node->iValue = token.iValue;
+            break;
+
+        case JSON_TOKEN_FP:
+            node->type = JSON_FP;
+            node->fpValue = token.fpValue;
+            break;
+
+        case JSON_TOKEN_BOOL:
+            node->type = JSON_BOOL;
+            node->boolValue = token.boolValue;
+            break;
+
+        case JSON_TOKEN_NULL:
+            node->type = JSON_NULL;
+            break;
+
+        default:
+            x_system_error("Unexpected json token: %d", token.type);
+    }
+
+    return node;
+}
+
+void JsonDocument::parseChildren(JsonReader& reader, JsonNode* node, JsonTokenType endType)
+{
+    JsonNode** tail = &node->children.first;
+    node->children.total = 0;
+
+    JsonToken token;
+
+    while(reader.read(token) != endType)
+    {
+        JsonStringView key = { nullptr, 0 };
+
+        if(token.type == JSON_TOKEN_KEY)
+        {
+            key = token.stringValue;
+            reader.read(token);
+        }
+
+        JsonNode* child = parseValue(reader, token);
+        child->key = key;
+
+        *tail = child;
+        tail = &child->nextSibling;
+        ++node->children.total;
+    }
+
+    *tail = nullptr;
+}
+
+JsonNode& JsonNode::operator[](int index)
+{
+    if(type != JSON_ARRAY)
+    {
+        x_system_error("Json type is not array");
+    }
+
+    if(index < 0 || index >= children.total)
+    {
+        x_system_error("Json array index out of bounds");
+    }
+
+    JsonNode* child = children.first;
+
+    for(int i = 0; i < index; ++i)
+    {
+        child = child->nextSibling;
+    }
+
+    return *child;
+}
+
+JsonNode& JsonNode::operator[](const char* name)
+{
+    if(type != JSON_OBJECT)
+    {
+        x_system_error("Json type is not object");
+    }
+
+    for(JsonNode* child = children.first; child != nullptr; child = child->nextSibling)
+    {
+        if(child->key == name)
+        {
+            return *child;
+        }
+    }
+
+    return nullNode;
+}
+
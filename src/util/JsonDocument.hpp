@@ -0,0 +1,86 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "Json.hpp"
+#include "JsonReader.hpp"
+#include "memory/ArenaAllocator.hpp"
+
+struct JsonNode;
+
+struct JsonNodeChildren
+{
+    JsonNode* first;
+    int total;
+};
+
+// Value in a JsonDocument. Children of objects and arrays are kept in a list in document order.
+struct JsonNode
+{
+    JsonNode() { }
+    JsonNode(JsonType type_) : type(type_) { }
+
+    JsonType type;
+    JsonStringView key;         // Only set for members of an object
+    JsonNode* nextSibling;
+
+    union
+    {
+        JsonNodeChildren children;
+        int iValue;
+        fp fpValue;
+        bool boolValue;
+        JsonStringView stringValue;
+    };
+
+    JsonNode& operator[](int index);
+    JsonNode& operator[](const char* name);
+
+    static JsonNode nullNode;
+};
+
+// Parses a whole document out of one arena instead of allocating each value from the zone. Strings
+// point into the source, so it has to outlive the document. Parsing again reuses the arena.
+class JsonDocument
+{
+public:
+    JsonDocument(int maxNodes)
+        : nodes(maxNodes, "json nodes"),
+        root(nullptr)
+    {
+
+    }
+
+    JsonNode* parse(char* source);
+
+    JsonNode* getRoot() const
+    {
+        return root;
+    }
+
+    int totalNodes() const
+    {
+        return nodes.totalAllocs();
+    }
+
+private:
+    JsonNode* parseValue(JsonReader& reader, JsonToken& token);
+    void parseChildren(JsonReader& reader, JsonNode* node, JsonTokenType endType);
+
+    ArenaAllocator<JsonNode> nodes;
+    JsonNode* root;
+};
+
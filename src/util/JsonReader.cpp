@@ -0,0 +1,367 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+
+#include "JsonReader.hpp"
+#include "error/Error.hpp"
+
+JsonTokenType JsonReader::read(JsonToken& token)
+{
+    skipWhitespace();
+
+    if(state == AFTER_ROOT)
+    {
+        if(*next != '\0')
+        {
+            x_system_error("Unexpected '%c' after end of json document", *next);
+        }
+
+        token.type = JSON_TOKEN_END;
+        return token.type;
+    }
+
+    if(state == EXPECT_ROOT || state == EXPECT_OBJECT_VALUE)
+    {
+        readValue(token);
+        return token.type;
+    }
+
+    bool isObject = inObject();
+    char closing = (isObject ? '}' : ']');
+
+    if(*next == closing && state != EXPECT_ITEM)
+    {
+        ++next;
+        --depth;
+        finishValue();
+
+        token.type = (isObject ? JSON_TOKEN_END_OBJECT : JSON_TOKEN_END_ARRAY);
+        return token.type;
+    }
+
+    if(state == EXPECT_COMMA)
+    {
+        if(*next != ',')
+        {
+            x_system_error("Expected ',' or '%c', found '%c'", closing, *next);
+        }
+
+        ++next;
+        skipWhitespace();
+    }
+
+    if(!isObject)
+    {
+        readValue(token);
+        return token.type;
+    }
+
+    if(*next != '"')
+    {
+        x_system_error("Expected key, found '%c'", *next);
+    }
+
+    token.type = JSON_TOKEN_KEY;
+    token.stringValue = readStringLiteral();
+
+    skipWhitespace();
+
+    if(*next != ':')
+    {
+        x_system_error("Expected ':' after key, found '%c'", *next);
+    }
+
+    ++next;
+    state = EXPECT_OBJECT_VALUE;
+
+    return token.type;
+}
+
+void JsonReader::skipValue()
+{
+    JsonToken token;
+    read(token);
+
+    if(token.type == JSON_TOKEN_KEY)
+    {
+        read(token);
+    }
+
+    if(token.type != JSON_TOKEN_BEGIN_OBJECT && token.type != JSON_TOKEN_BEGIN_ARRAY)
+    {
+        return;
+    }
+
+    int containerDepth = depth;
+
+    while(depth >= containerDepth)
+    {
+        read(token);
+    }
+}
+
+void JsonReader::readValue(JsonToken& token)
+{
+    switch(*next)
+    {
+        case '{':
+            token.type = JSON_TOKEN_BEGIN_OBJECT;
+            beginContainer(true);
+            return;
+
+        case '[':
+            token.type = JSON_TOKEN_BEGIN_ARRAY;
+            beginContainer(false);
+            return;
+
+        case '"':
+            token.type = JSON_TOKEN_STRING;
+            token.stringValue = readStringLiteral();
+            break;
+
+        case 't':
+            expectWord("true");
+            token.type = JSON_TOKEN_BOOL;
+            token.boolValue = true;
+            break;
+
+        case 'f':
+            expectWord("false");
+            token.type = JSON_TOKEN_BOOL;
+            token.boolValue = false;
+            break;
+
+        case 'n':
+            expectWord("null");
+            token.type = JSON_TOKEN_NULL;
+            break;
+
+        case '-':
+        case '0'...'9':
+            readNumber(token);
+            break;
+
+        case '\0':
+            x_system_error("Unexpected end of json document");
+
+        default:
+            x_system_error("Unexpected character '%c'", *next);
+    }
+
+    finishValue();
+}
+
+void JsonReader::beginContainer(bool isObject)
+{
+    if(depth == MAX_DEPTH)
+    {
+        x_system_error("Json document is nested too deeply (max depth is %d)", MAX_DEPTH);
+    }
+
+    ++next;
+    containerIsObject[depth++] = isObject;
+    state = EXPECT_FIRST_ITEM;
+}
+
+void JsonReader::finishValue()
+{
+    state = (depth == 0 ? AFTER_ROOT : EXPECT_COMMA);
+}
+
+static int hexDigitValue(char c)
+{
+    if(c >= '0' && c <= '9')
+        return c - '0';
+
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+
+    x_system_error("Bad hex digit '%c' in \\u escape", c);
+}
+
+// Unescaped strings are always shorter than their source, so they're written over it
+JsonStringView JsonReader::readStringLiteral()
+{
+    ++next;
+
+    char* start = next;
+
+    while(*next != '"' && *next != '\\')
+    {
+        if(*next == '\0')
+        {
+            x_system_error("Unterminated '\"'");
+        }
+
+        ++next;
+    }
+
+    char* dest = next;
+
+    while(*next != '"')
+    {
+        char c = *next++;
+
+        if(c == '\0')
+        {
+            x_system_error("Unterminated '\"'");
+        }
+
+        if(c != '\\')
+        {
+            *dest++ = c;
+            continue;
+        }
+
+        c = *next++;
+
+        switch(c)
+        {
+            case '\\':      *dest++ = '\\'; break;
+            case '/':       *dest++ = '/'; break;
+            case '"':       *dest++ = '"'; break;
+            case 'b':       *dest++ = '\b'; break;
+            case 'f':       *dest++ = '\f'; break;
+            case 'n':       *dest++ = '\n'; break;
+            case 'r':       *dest++ = '\r'; break;
+            case 't':       *dest++ = '\t'; break;
+
+            case 'u':
+            {
+                int codePoint = 0;
+
+                for(int i = 0; i < 4; ++i)
+                {
+                    codePoint = codePoint * 16 + hexDigitValue(*next++);
+                }
+
+                // Encoded as UTF-8, which takes at most 3 bytes for the 6 characters of the escape
+                if(codePoint < 0x80)
+                {
+                    *dest++ = codePoint;
+                }
+                else if(codePoint < 0x800)
+                {
+                    *dest++ = 0xC0 | (codePoint >> 6);
+                    *dest++ = 0x80 | (codePoint & 0x3F);
+                }
+                else
+                {
+                    *dest++ = 0xE0 | (codePoint >> 12);
+                    *dest++ = 0x80 | ((codePoint >> 6) & 0x3F);
+                    *dest++ = 0x80 | (codePoint & 0x3F);
+                }
+
+                break;
+            }
+
+            default:
+                x_system_error("Unknown escape character \\%c", c);
+        }
+    }
+
+    ++next;
+
+    JsonStringView view;
+    view.start = start;
+    view.length = dest - start;
+
+    return view;
+}
+
+void JsonReader::readNumber(JsonToken& token)
+{
+    char* start = next;
+    bool negative = (*next == '-');
+
+    if(negative)
+    {
+        ++next;
+    }
+
+    if(*next < '0' || *next > '9')
+    {
+        x_system_error("Expected digit after '-'");
+    }
+
+    int value = 0;
+
+    while(*next >= '0' && *next <= '9')
+    {
+        value = value * 10 + (*next++ - '0');
+    }
+
+    if(*next != '.' && *next != 'e' && *next != 'E')
+    {
+        token.type = JSON_TOKEN_INT;
+        token.iValue = (negative ? -value : value);
+        return;
+    }
+
+    if(*next == '.')
+    {
+        ++next;
+
+        while(*next >= '0' && *next <= '9')
+        {
+            ++next;
+        }
+    }
+
+    if(*next == 'e' || *next == 'E')
+    {
+        ++next;
+
+        if(*next == '+' || *next == '-')
+        {
+            ++next;
+        }
+
+        while(*next >= '0' && *next <= '9')
+        {
+            ++next;
+        }
+    }
+
+    char buf[64];
+    int length = next - start;
+
+    if(length >= (int)sizeof(buf))
+    {
+        x_system_error("Json number is too long");
+    }
+
+    memcpy(buf, start, length);
+    buf[length] = '\0';
+
+    token.type = JSON_TOKEN_FP;
+    token.fpValue = fp::fromFloat(atof(buf));
+}
+
+void JsonReader::expectWord(const char* word)
+{
+    for(const char* ptr = word; *ptr; ++ptr)
+    {
+        if(*next++ != *ptr)
+        {
+            x_system_error("Expected \"%s\"", word);
+        }
+    }
+}
+
@@ -0,0 +1,126 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstring>
+
+#include "math/FixedPoint.hpp"
+
+enum JsonTokenType
+{
+    JSON_TOKEN_BEGIN_OBJECT,
+    JSON_TOKEN_END_OBJECT,
+    JSON_TOKEN_BEGIN_ARRAY,
+    JSON_TOKEN_END_ARRAY,
+    JSON_TOKEN_KEY,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_INT,
+    JSON_TOKEN_FP,
+    JSON_TOKEN_BOOL,
+    JSON_TOKEN_NULL,
+    JSON_TOKEN_END
+};
+
+// A string inside the source buffer, which isn't null terminated
+struct JsonStringView
+{
+    bool operator==(const char* str) const
+    {
+        return strncmp(start, str, length) == 0 && str[length] == '\0';
+    }
+
+    const char* start;
+    int length;
+};
+
+struct JsonToken
+{
+    JsonToken() { }
+
+    JsonTokenType type;
+
+    union
+    {
+        JsonStringView stringValue;     // For keys and strings
+        int iValue;
+        fp fpValue;
+        bool boolValue;
+    };
+};
+
+// Pull parser that reads one token at a time without allocating anything. Strings are returned as
+// views into the source, which is why it isn't const: strings with escapes are unescaped in place.
+class JsonReader
+{
+public:
+    JsonReader(char* source)
+        : next(source),
+        depth(0),
+        state(EXPECT_ROOT)
+    {
+
+    }
+
+    JsonTokenType read(JsonToken& token);
+
+    // Skips the next value, including everything inside it if it's an object or array
+    void skipValue();
+
+    int getDepth() const
+    {
+        return depth;
+    }
+
+    static const int MAX_DEPTH = 64;
+
+private:
+    enum State
+    {
+        EXPECT_ROOT,
+        EXPECT_FIRST_ITEM,
+        EXPECT_ITEM,
+        EXPECT_COMMA,
+        EXPECT_OBJECT_VALUE,
+        AFTER_ROOT
+    };
+
+    void readValue(JsonToken& token);
+    void beginContainer(bool isObject);
+    void finishValue();
+
+    JsonStringView readStringLiteral();
+    void readNumber(JsonToken& token);
+    void expectWord(const char* word);
+
+    bool inObject() const
+    {
+        return containerIsObject[depth - 1];
+    }
+
+    void skipWhitespace()
+    {
+        while(*next == ' ' || *next == '\t' || *next == '\n' || *next == '\r')
+        {
+            ++next;
+        }
+    }
+
+    char* next;
+    int depth;
+    State state;
+    bool containerIsObject[MAX_DEPTH];
+};
+
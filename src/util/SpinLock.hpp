@@ -0,0 +1,100 @@
+// This file is part of X3D.
+//
+// X3D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// X3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with X3D. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "engine/Config.hpp"
+
+#if X_ENABLE_THREADS
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#endif
+
+// Lock for short critical sections (e.g. allocator bookkeeping). Compiles down to nothing
+// when threads are disabled. Meets BasicLockable, so it works with std::lock_guard.
+class SpinLock
+{
+public:
+#if X_ENABLE_THREADS
+
+    void lock()
+    {
+        int spins = 0;
+
+        while(flag.test_and_set(std::memory_order_acquire))
+        {
+            if(++spins == MAX_SPINS_BEFORE_YIELD)
+            {
+                std::this_thread::yield();
+                spins = 0;
+            }
+        }
+    }
+
+    void unlock()
+    {
+        flag.clear(std::memory_order_release);
+    }
+
+private:
+    static const int MAX_SPINS_BEFORE_YIELD = 64;
+
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+
+#else
+
+    void lock() { }
+    void unlock() { }
+
+#endif
+};
+
+// Lock for critical sections that can run long enough that a waiting thread should sleep
+// instead of spinning (e.g. building a surface). Also compiles down to nothing without threads.
+class Mutex
+{
+public:
+#if X_ENABLE_THREADS
+
+    void lock()
+    {
+        mutex.lock();
+    }
+
+    void unlock()
+    {
+        mutex.unlock();
+    }
+
+private:
+    std::mutex mutex;
+
+#else
+
+    void lock() { }
+    void unlock() { }
+
+#endif
+};
+
+#if X_ENABLE_THREADS
+#define X_THREAD_LOCAL thread_local
+#else
+#define X_THREAD_LOCAL
+#endif
+
@@ -16,10 +16,13 @@
 #include "StackTrace.hpp"
 
 #include <cstdio>
+#include <csignal>
 #include <execinfo.h>
 #include <cstdlib>
 #include <unistd.h>
 
+#include "error/Log.hpp"
+
 void printStackTrace()
 {
     void* entries[100];
@@ -27,3 +30,25 @@ void printStackTrace()
     backtrace_symbols_fd(entries, size, STDERR_FILENO);
 }
 
+
+static void crashHandler(int signalNumber)
+{
+    // Restore the default handler first so a crash in here doesn't recurse
+    signal(signalNumber, SIG_DFL);
+
+    fprintf(stderr, "Caught signal %d\n", signalNumber);
+
+    Log::flush();
+    printStackTrace();
+
+    raise(signalNumber);
+}
+
+void installCrashHandler()
+{
+    signal(SIGSEGV, crashHandler);
+    signal(SIGABRT, crashHandler);
+    signal(SIGFPE, crashHandler);
+    signal(SIGILL, crashHandler);
+    signal(SIGBUS, crashHandler);
+}
@@ -17,3 +17,6 @@
 
 void printStackTrace();
 
+// Prints a stack trace and flushes the log if the engine crashes (e.g. segfault or abort)
+void installCrashHandler();
+
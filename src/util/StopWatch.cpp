@@ -14,14 +14,21 @@
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
 #include <sys/time.h>
+#include <mutex>
 
 #include "StopWatch.hpp"
 #include "dev/console/Console.hpp"
 #include "engine/EngineContext.hpp"
+#include "util/SpinLock.hpp"
 
 StopWatchEntry StopWatch::entries[X_STOPWATCH_MAX_ENTRIES];
 int StopWatch::totalEntries = 0;
 
+// Views can be timed on several threads at once, so every thread keeps its own start times and
+// the entries are only changed while holding the lock
+static SpinLock entryLock;
+static X_THREAD_LOCAL long long startTicks[X_STOPWATCH_MAX_ENTRIES];
+
 static long long getTime()
 {
     struct timeval tv;
@@ -33,22 +40,34 @@ static long long getTime()
 
 void StopWatch::start(const char* name)
 {
-    auto entry = getEntry(name);
+    int entryId;
 
-    if(!entry)
     {
-        entries[totalEntries].frameTicks = 0;
-        entries[totalEntries].totalTicks = 0;
-        entries[totalEntries].name = name;
-        
-        entry = entries + totalEntries++;
+        std::lock_guard<SpinLock> guard(entryLock);
+
+        auto entry = getEntry(name);
+
+        if(!entry)
+        {
+            entries[totalEntries].frameTicks = 0;
+            entries[totalEntries].totalTicks = 0;
+            entries[totalEntries].name = name;
+
+            entry = entries + totalEntries++;
+        }
+
+        entryId = entry - entries;
     }
 
-    entry->startTick = getTime();
+    startTicks[entryId] = getTime();
 }
 
 void StopWatch::stop(const char* name)
 {
+    long long stopTick = getTime();
+
+    std::lock_guard<SpinLock> guard(entryLock);
+
     auto entry = getEntry(name);
 
     if(!entry)
@@ -56,7 +75,7 @@ void StopWatch::stop(const char* name)
         return;
     }
 
-    entry->frameTicks = getTime() - entry->startTick;
+    entry->frameTicks = stopTick - startTicks[entry - entries];
     entry->totalTicks += entry->frameTicks;
 }
 
@@ -79,6 +98,8 @@ void StopWatch::stopwatchCmd(EngineContext* engineContext, int argc, char* argv[
 
     if(argc == 2 && strcmp(argv[1], "reset") == 0)
     {
+        std::lock_guard<SpinLock> guard(entryLock);
+
         totalEntries = 0;
         return;
     }
@@ -24,8 +24,6 @@ struct StopWatchEntry
     const char* name;
     long long totalTicks;
     long long frameTicks;
-
-    long long startTick;
 };
 
 class StopWatch
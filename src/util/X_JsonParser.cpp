@@ -155,6 +155,8 @@ JsonValue* JsonParser::parseNumber()
         *bufptr++ = *next++;
     } while(true);
 
+    *bufptr = '\0';
+
     JsonValue* value;
 
     if(isFloat)
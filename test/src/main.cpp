@@ -13,6 +13,8 @@
 // You should have received a copy of the GNU General Public License
 // along with X3D. If not, see <http://www.gnu.org/licenses/>.
 
+#include <cstring>
+
 #include <X3D/X3D.hpp>
 #include <engine/EngineContext.hpp>
 
@@ -60,6 +62,7 @@ int main(int argc, char* argv[])
         .screenConfig(screenConfig);
 
     config.systemConfig.programPath = argv[0];
+    config.systemConfig.enableStdinCommands = (argc > 1 && strcmp(argv[1], "-stdin") == 0);
 
     EngineContext* engineContext = Engine::init(config);
 
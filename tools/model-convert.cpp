@@ -5,6 +5,9 @@
 #include <cstdlib>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <map>
+#include <algorithm>
 
 float degToRadians(float deg) {
     return deg * 3.1415926535 / 180.0;
@@ -462,21 +465,523 @@ struct ModelLoader {
     }
 };
 
+// Reads a Quake .mdl file, resolving the skin seam into separate vertices and welding vertices that
+// end up identical in every frame
+struct MdlLoader {
+    struct Skin {
+        std::vector<float> displayDurations;
+        std::vector<unsigned char> texels;
+    };
+    
+    struct Frame {
+        char name[16];
+        std::vector<Vec3> vertices;
+    };
+    
+    // Frames are stored one group after another, single frames as groups of one
+    struct FrameGroup {
+        int totalFrames;
+        float displayDuration;
+    };
+    
+    FILE* file;
+    
+    int skinWidth;
+    int skinHeight;
+    std::vector<Skin> skins;
+    
+    // One per welded vertex
+    std::vector<int> s;
+    std::vector<int> t;
+    
+    std::vector<Triangle> triangles;
+    std::vector<Frame> frames;
+    std::vector<FrameGroup> frameGroups;
+    
+    unsigned char readByte() {
+        int c = fgetc(file);
+        
+        if(c == EOF)
+            throw std::string("Unexpected end of file");
+        
+        return c;
+    }
+    
+    int readInt() {
+        unsigned int b0 = readByte();
+        unsigned int b1 = readByte();
+        unsigned int b2 = readByte();
+        unsigned int b3 = readByte();
+        
+        return (int)(b0 | (b1 << 8) | (b2 << 16) | (b3 << 24));
+    }
+    
+    float readFloat() {
+        int i = readInt();
+        float f;
+        memcpy(&f, &i, sizeof(f));
+        
+        return f;
+    }
+    
+    Vec3 readVec3() {
+        float x = readFloat();
+        float y = readFloat();
+        float z = readFloat();
+        
+        return Vec3(x, y, z);
+    }
+    
+    void loadFile(std::string fileName) {
+        printf("Loading model %s\n", fileName.c_str());
+        
+        file = fopen(fileName.c_str(), "rb");
+        if(!file)
+            throw "Failed to load file: " + fileName;
+        
+        try {
+            load();
+        }
+        catch(...) {
+            fclose(file);
+            throw;
+        }
+        
+        fclose(file);
+        
+        printf("Welded %d vertices, %d triangles, %d frames in %d groups\n", (int)s.size(), (int)triangles.size(), (int)frames.size(), (int)frameGroups.size());
+    }
+    
+    void load() {
+        if(readInt() != 'I' + ('D' << 8) + ('P' << 16) + ('O' << 24))
+            throw std::string("Not a Quake model file");
+        
+        if(readInt() != 6)
+            throw std::string("Unsupported model version");
+        
+        Vec3 scale = readVec3();
+        Vec3 origin = readVec3();
+        readFloat();        // Radius
+        readVec3();         // Eye position
+        
+        int totalSkins = readInt();
+        skinWidth = readInt();
+        skinHeight = readInt();
+        int totalVertices = readInt();
+        int totalTriangles = readInt();
+        int totalFrames = readInt();
+        readInt();          // Sync type
+        readInt();          // Flags
+        readFloat();        // Average triangle size
+        
+        for(int i = 0; i < totalSkins; ++i)
+            loadSkin();
+        
+        std::vector<int> onSeam(totalVertices);
+        std::vector<int> mdlS(totalVertices);
+        std::vector<int> mdlT(totalVertices);
+        
+        for(int i = 0; i < totalVertices; ++i) {
+            onSeam[i] = readInt();
+            mdlS[i] = readInt();
+            mdlT[i] = readInt();
+        }
+        
+        // Back facing triangles use the other half of the skin for vertices on the seam
+        std::vector<int> mdlVertexIds;
+        std::vector<int> backSideIds(totalVertices, -1);
+        
+        for(int i = 0; i < totalVertices; ++i) {
+            mdlVertexIds.push_back(i);
+            s.push_back(mdlS[i]);
+            t.push_back(mdlT[i]);
+        }
+        
+        for(int i = 0; i < totalTriangles; ++i) {
+            bool facesFront = readInt();
+            int v[3];
+            
+            for(int j = 0; j < 3; ++j) {
+                v[j] = readInt();
+                
+                if(v[j] < 0 || v[j] >= totalVertices)
+                    throw std::string("Triangle has a bad vertex id");
+                
+                if(!facesFront && onSeam[v[j]]) {
+                    if(backSideIds[v[j]] == -1) {
+                        backSideIds[v[j]] = mdlVertexIds.size();
+                        mdlVertexIds.push_back(v[j]);
+                        s.push_back(mdlS[v[j]] + skinWidth / 2);
+                        t.push_back(mdlT[v[j]]);
+                    }
+                    
+                    v[j] = backSideIds[v[j]];
+                }
+            }
+            
+            triangles.push_back(Triangle(v[0], v[1], v[2]));
+        }
+        
+        for(int i = 0; i < totalFrames; ++i)
+            loadFrameGroup(totalVertices, mdlVertexIds, scale, origin);
+        
+        weldVertices();
+    }
+    
+    void loadSkin() {
+        Skin skin;
+        int totalTextures = 1;
+        
+        if(readInt() != 0) {
+            totalTextures = readInt();
+            
+            for(int i = 0; i < totalTextures; ++i)
+                skin.displayDurations.push_back(readFloat());
+        }
+        else {
+            skin.displayDurations.push_back(0);
+        }
+        
+        skin.texels.resize(skinWidth * skinHeight * totalTextures);
+        
+        for(int i = 0; i < (int)skin.texels.size(); ++i)
+            skin.texels[i] = readByte();
+        
+        skins.push_back(skin);
+    }
+    
+    // Same conversion as the engine: scale, translate, then swap to X3D's coordinate system
+    Vec3 readVertex(Vec3 scale, Vec3 origin) {
+        float x = readByte();
+        float y = readByte();
+        float z = readByte();
+        readByte();     // Normal index
+        
+        Vec3 v = Vec3(x, y, z).multiplyEach(scale) + origin;
+        
+        return Vec3(v.y, -v.z, -v.x);
+    }
+    
+    void loadFrameGroup(int totalMdlVertices, const std::vector<int>& mdlVertexIds, Vec3 scale, Vec3 origin) {
+        FrameGroup group = { 1, 0 };
+        
+        if(readInt() != 0) {
+            group.totalFrames = readInt();
+            
+            if(group.totalFrames <= 0)
+                throw std::string("Frame group has no frames");
+            
+            // Packed bound box of the whole group
+            for(int i = 0; i < 8; ++i)
+                readByte();
+            
+            // Each interval is the time the next frame starts, so the first one is how long a frame is shown
+            for(int i = 0; i < group.totalFrames; ++i) {
+                float interval = readFloat();
+                
+                if(i == 0)
+                    group.displayDuration = interval;
+            }
+        }
+        
+        for(int i = 0; i < group.totalFrames; ++i)
+            loadFrame(totalMdlVertices, mdlVertexIds, scale, origin);
+        
+        frameGroups.push_back(group);
+    }
+    
+    void loadFrame(int totalMdlVertices, const std::vector<int>& mdlVertexIds, Vec3 scale, Vec3 origin) {
+        // Packed bound box, which is recalculated from the vertices
+        for(int i = 0; i < 8; ++i)
+            readByte();
+        
+        Frame frame;
+        
+        for(int i = 0; i < 16; ++i)
+            frame.name[i] = readByte();
+        
+        frame.name[15] = '\0';
+        
+        std::vector<Vec3> mdlVertices;
+        for(int i = 0; i < totalMdlVertices; ++i)
+            mdlVertices.push_back(readVertex(scale, origin));
+        
+        for(int id : mdlVertexIds)
+            frame.vertices.push_back(mdlVertices[id]);
+        
+        frames.push_back(frame);
+    }
+    
+    void weldVertices() {
+        std::map<std::vector<int>, int> weldedIds;
+        std::vector<int> remap(s.size());
+        std::vector<int> keep;
+        
+        for(int i = 0; i < (int)s.size(); ++i) {
+            std::vector<int> key = { s[i], t[i] };
+            
+            for(Frame& frame : frames) {
+                key.push_back(toFixedPoint(frame.vertices[i].x));
+                key.push_back(toFixedPoint(frame.vertices[i].y));
+                key.push_back(toFixedPoint(frame.vertices[i].z));
+            }
+            
+            auto it = weldedIds.find(key);
+            
+            if(it != weldedIds.end()) {
+                remap[i] = it->second;
+                continue;
+            }
+            
+            remap[i] = keep.size();
+            weldedIds[key] = keep.size();
+            keep.push_back(i);
+        }
+        
+        for(Triangle& tri : triangles) {
+            for(int j = 0; j < 3; ++j)
+                tri.v[j] = remap[tri.v[j]];
+        }
+        
+        std::vector<int> newS, newT;
+        for(int id : keep) {
+            newS.push_back(s[id]);
+            newT.push_back(t[id]);
+        }
+        
+        s = newS;
+        t = newT;
+        
+        for(Frame& frame : frames) {
+            std::vector<Vec3> vertices;
+            
+            for(int id : keep)
+                vertices.push_back(frame.vertices[id]);
+            
+            frame.vertices = vertices;
+        }
+    }
+    
+    static int toFixedPoint(float f) {
+        return (int)lround(f * 65536.0);
+    }
+};
+
+// Writes X3D's own model format (see X_EntityModelFileHeader in src/level/EntityModelLoader.hpp)
+struct NativeModelWriter {
+    static const int MAX_VERTICES = 2048;
+    static const int MAX_TRIANGLES = 4096;
+    
+    FILE* file;
+    bool bigEndian;
+    int totalBytesWritten;
+    
+    void writeBytes(const unsigned char* bytes, int count) {
+        fwrite(bytes, 1, count, file);
+        totalBytesWritten += count;
+    }
+    
+    void writeInt(int value) {
+        unsigned int v = value;
+        unsigned char bytes[4];
+        
+        for(int i = 0; i < 4; ++i) {
+            int shift = bigEndian ? (3 - i) * 8 : i * 8;
+            bytes[i] = (v >> shift) & 0xFF;
+        }
+        
+        writeBytes(bytes, 4);
+    }
+    
+    void writeShort(int value) {
+        unsigned char lo = value & 0xFF;
+        unsigned char hi = (value >> 8) & 0xFF;
+        unsigned char bytes[2] = { bigEndian ? hi : lo, bigEndian ? lo : hi };
+        
+        writeBytes(bytes, 2);
+    }
+    
+    void writeFixedPoint(float f) {
+        writeInt(MdlLoader::toFixedPoint(f));
+    }
+    
+    void pad() {
+        unsigned char zero = 0;
+        
+        while(totalBytesWritten % 4 != 0)
+            writeBytes(&zero, 1);
+    }
+    
+    static int skinSectionSize(const MdlLoader& model) {
+        int size = 0;
+        
+        for(const MdlLoader::Skin& skin : model.skins)
+            size += 4 + (4 * skin.displayDurations.size() + skin.texels.size() + 3) / 4 * 4;
+        
+        return size;
+    }
+    
+    void save(const MdlLoader& model, std::string fileName, bool bigEndian_) {
+        int totalVertices = model.s.size();
+        int totalTriangles = model.triangles.size();
+        
+        if(totalVertices > MAX_VERTICES || totalTriangles > MAX_TRIANGLES)
+            throw std::string("Model has too many vertices or triangles");
+        
+        file = fopen(fileName.c_str(), "wb");
+        if(!file)
+            throw std::string("Failed to open file for writing");
+        
+        bigEndian = bigEndian_;
+        totalBytesWritten = 0;
+        
+        const int HEADER_SIZE = 14 * 4;
+        int skinsOffset = HEADER_SIZE;
+        int textureCoordsOffset = skinsOffset + skinSectionSize(model);
+        int trianglesOffset = textureCoordsOffset + totalVertices * 8;
+        int frameGroupsOffset = trianglesOffset + (totalTriangles * 6 + 3) / 4 * 4;
+        int framesOffset = frameGroupsOffset + model.frameGroups.size() * 8;
+        
+        writeInt('X' + ('3' << 8) + ('D' << 16) + ('M' << 24));
+        writeInt(2);
+        writeInt(model.skinWidth);
+        writeInt(model.skinHeight);
+        writeInt(model.skins.size());
+        writeInt(totalVertices);
+        writeInt(totalTriangles);
+        writeInt(model.frames.size());
+        writeInt(skinsOffset);
+        writeInt(textureCoordsOffset);
+        writeInt(trianglesOffset);
+        writeInt(framesOffset);
+        writeInt(model.frameGroups.size());
+        writeInt(frameGroupsOffset);
+        
+        for(const MdlLoader::Skin& skin : model.skins) {
+            writeInt(skin.displayDurations.size());
+            
+            for(float duration : skin.displayDurations)
+                writeFixedPoint(duration);
+            
+            writeBytes(&skin.texels[0], skin.texels.size());
+            pad();
+        }
+        
+        for(int i = 0; i < totalVertices; ++i) {
+            writeInt(model.s[i]);
+            writeInt(model.t[i]);
+        }
+        
+        for(const Triangle& tri : model.triangles) {
+            for(int j = 0; j < 3; ++j)
+                writeShort(tri.v[j]);
+        }
+        
+        pad();
+        
+        for(const MdlLoader::FrameGroup& group : model.frameGroups) {
+            writeInt(group.totalFrames);
+            writeFixedPoint(group.displayDuration);
+        }
+        
+        for(const MdlLoader::Frame& frame : model.frames)
+            saveFrame(model, frame);
+        
+        fclose(file);
+    }
+    
+    void saveFrame(const MdlLoader& model, const MdlLoader::Frame& frame) {
+        writeBytes((const unsigned char*)frame.name, 16);
+        
+        Vec3 mins = frame.vertices[0];
+        Vec3 maxs = frame.vertices[0];
+        
+        for(const Vec3& v : frame.vertices) {
+            mins = Vec3(std::min(mins.x, v.x), std::min(mins.y, v.y), std::min(mins.z, v.z));
+            maxs = Vec3(std::max(maxs.x, v.x), std::max(maxs.y, v.y), std::max(maxs.z, v.z));
+        }
+        
+        Vec3 center = (mins + maxs) * 0.5;
+        float radius = 0;
+        
+        for(const Vec3& v : frame.vertices)
+            radius = std::max(radius, (v - center).length());
+        
+        writeFixedPoint(mins.x);
+        writeFixedPoint(mins.y);
+        writeFixedPoint(mins.z);
+        writeFixedPoint(maxs.x);
+        writeFixedPoint(maxs.y);
+        writeFixedPoint(maxs.z);
+        writeFixedPoint(center.x);
+        writeFixedPoint(center.y);
+        writeFixedPoint(center.z);
+        writeInt(MdlLoader::toFixedPoint(radius) + 1);
+        
+        for(const Vec3& v : frame.vertices)
+            writeFixedPoint(v.x);
+        
+        for(const Vec3& v : frame.vertices)
+            writeFixedPoint(v.y);
+        
+        for(const Vec3& v : frame.vertices)
+            writeFixedPoint(v.z);
+        
+        // Triangles are visible when their vertices are clockwise on screen, which puts the normal on
+        // the side of (v2 - v0) x (v1 - v0). Degenerate triangles get a zero normal so they're never drawn.
+        for(const Triangle& tri : model.triangles) {
+            Vec3 v0 = frame.vertices[tri.v[0]];
+            Vec3 normal = (frame.vertices[tri.v[2]] - v0).cross(frame.vertices[tri.v[1]] - v0);
+            
+            if(normal.lengthSquared() != 0)
+                normal = normal.normalize();
+            
+            writeFixedPoint(normal.x);
+            writeFixedPoint(normal.y);
+            writeFixedPoint(normal.z);
+        }
+    }
+};
+
+static bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 int main(int argc, char* argv[]) {
+    bool bigEndian = false;
+    
+    if(argc == 4 && std::string(argv[1]) == "--big-endian") {
+        bigEndian = true;
+        ++argv;
+        --argc;
+    }
+    
     if(argc != 3) {
         printf("Converts 3D models in .obj format to X3D's model format\n");
-        printf("Usage: %s [input model] [output file]l\n", argv[0]);
+        printf("Quake .mdl models are converted to X3D's native model format, which is loaded directly\n");
+        printf("Usage: %s [--big-endian] [input model] [output file]\n", argv[0]);
+        printf("Native models are written little-endian, which is what the PC and the nspire load\n");
+        printf("--big-endian is only for engines built for big-endian machines\n");
         return 0;
     }
     
     try {
+        if(endsWith(argv[1], ".mdl")) {
+            MdlLoader loader;
+            loader.loadFile(argv[1]);
+            
+            NativeModelWriter writer;
+            writer.save(loader, argv[2], bigEndian);
+            
+            return 0;
+        }
+        
         ModelLoader loader;
         Model model = loader.loadFile(argv[1]);
         model.save(argv[2]);
     }
     catch(std::string s) {
         printf("Error converting file: %s\n", s.c_str());
+        return 1;
     }
 }
-
-